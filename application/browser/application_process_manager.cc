@@ -9,7 +9,7 @@
 #include "base/stl_util.h"
 #include "net/base/net_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
-#include "xwalk/application/common/constants.h"
+#include "xwalk/application/common/manifest_handlers/main_document_handler.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 
@@ -56,34 +56,16 @@ void ApplicationProcessManager::OnRuntimeRemoved(Runtime* runtime) {
 
 bool ApplicationProcessManager::RunMainDocument(
     const Application* application) {
-  const Manifest* manifest = application->GetManifest();
-  const base::DictionaryValue* dict = NULL;
-  if (!manifest->GetDictionary(application_manifest_keys::kAppMainKey, &dict))
+  const MainDocumentInfo* main_info = MainDocumentInfo::Get(application);
+  if (!main_info)
     return false;
 
-  GURL url;
-  std::string main_source;
-  const base::ListValue* main_scripts = NULL;
-  manifest->GetString(application_manifest_keys::kAppMainSourceKey,
-      &main_source);
-  manifest->GetList(application_manifest_keys::kAppMainScriptsKey,
-      &main_scripts);
-
-  if (!main_source.empty() && (main_scripts && main_scripts->GetSize()))
-    LOG(WARNING) << "An app should not has more than one main document.";
-
-  if (!main_source.empty()) {
-    url = application->GetResourceURL(main_source);
-  } else if (main_scripts && main_scripts->GetSize()) {
-    // When no main.source is defined but main.scripts are, we implicitly create
-    // a main document.
-    url = application->GetResourceURL(kGeneratedMainDocumentFilename);
-  } else {
+  if (!main_info->main_url().is_valid()) {
     LOG(WARNING) << "The app.main field doesn't contain a valid main document.";
     return false;
   }
 
-  main_runtime_ = Runtime::Create(runtime_context_, url);
+  main_runtime_ = Runtime::Create(runtime_context_, main_info->main_url());
   return true;
 }
 
@@ -5,48 +5,126 @@
 #include "xwalk/application/browser/application_protocols.h"
 
 #include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/format_macros.h"
+#include "base/memory/ref_counted_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
 #include "base/threading/thread_restrictions.h"
 #include "base/threading/worker_pool.h"
 #include "base/threading/sequenced_worker_pool.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/resource_request_info.h"
 #include "url/url_util.h"
+#include "net/base/io_buffer.h"
+#include "net/base/mime_util.h"
 #include "net/base/net_errors.h"
+#include "net/http/http_byte_range.h"
+#include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/http/http_response_info.h"
+#include "net/http/http_util.h"
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_archive.h"
 #include "xwalk/application/common/application_file_util.h"
-#include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/application_resource_cache.h"
+#include "xwalk/application/common/application_resource_index.h"
 #include "xwalk/application/common/constants.h"
+#include "xwalk/application/common/manifest_handlers/main_document_handler.h"
 
 using content::ResourceRequestInfo;
 using xwalk::application::Application;
+using xwalk::application::ApplicationArchive;
+using xwalk::application::ApplicationResourceCache;
+using xwalk::application::ApplicationResourceIndex;
 
 namespace {
 
+const char* const kWeekDays[] = {
+  "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+};
+
+const char* const kMonths[] = {
+  "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+// Formats |time| as in RFC 1123, like "Sun, 06 Nov 1994 08:49:37 GMT".
+std::string FormatHttpTime(const base::Time& time) {
+  base::Time::Exploded exploded;
+  time.UTCExplode(&exploded);
+  return base::StringPrintf("%s, %02d %s %04d %02d:%02d:%02d GMT",
+                            kWeekDays[exploded.day_of_week],
+                            exploded.day_of_month,
+                            kMonths[exploded.month - 1],
+                            exploded.year,
+                            exploded.hour,
+                            exploded.minute,
+                            exploded.second);
+}
+
+std::string GetETag(const ApplicationResourceIndex::Entry& entry) {
+  return "\"" + entry.hash + "\"";
+}
+
+// Whether the If-None-Match header |if_none_match| matches |etag|.
+bool MatchesETag(const std::string& if_none_match, const std::string& etag) {
+  std::vector<std::string> etags;
+  base::SplitString(if_none_match, ',', &etags);
+  for (size_t i = 0; i < etags.size(); ++i) {
+    if (etags[i] == "*" || etags[i] == etag)
+      return true;
+  }
+  return false;
+}
+
+// Describes the response for a resource present in the index of the
+// application.
+struct IndexedResponse {
+  IndexedResponse()
+      : not_modified(false),
+        first_byte(-1),
+        last_byte(-1) {}
+
+  ApplicationResourceIndex::Entry entry;
+  bool not_modified;
+  // The part of the file sent, -1 when sending the whole file.
+  int64 first_byte;
+  int64 last_byte;
+};
+
 net::HttpResponseHeaders* BuildHttpHeaders(
     const std::string& mime_type, const std::string& method,
     const base::FilePath& file_path, const base::FilePath& relative_path,
-    bool is_authority_match) {
+    bool is_authority_match, const IndexedResponse* indexed_response) {
+  bool found = false;
   std::string raw_headers;
-  if (method == "GET") {
-    if (relative_path.empty())
+  if (method == "GET" || method == "HEAD") {
+    if (relative_path.empty()) {
       raw_headers.append("HTTP/1.1 400 Bad Request");
-    else if (!is_authority_match)
+    } else if (!is_authority_match) {
       raw_headers.append("HTTP/1.1 403 Forbidden");
-    else if (file_path.empty())
+    } else if (file_path.empty()) {
       raw_headers.append("HTTP/1.1 404 Not Found");
-    else
-      raw_headers.append("HTTP/1.1 200 OK");
+    } else {
+      found = true;
+      if (indexed_response && indexed_response->not_modified)
+        raw_headers.append("HTTP/1.1 304 Not Modified");
+      else if (indexed_response && indexed_response->first_byte >= 0)
+        raw_headers.append("HTTP/1.1 206 Partial Content");
+      else
+        raw_headers.append("HTTP/1.1 200 OK");
+    }
   } else {
     raw_headers.append("HTTP/1.1 501 Not Implemented");
   }
@@ -60,6 +138,37 @@ net::HttpResponseHeaders* BuildHttpHeaders(
     raw_headers.append(mime_type);
   }
 
+  if (found && indexed_response) {
+    // The files only change when the application is installed again, but
+    // then the validators change too, so revalidating is cheap.
+    const ApplicationResourceIndex::Entry& entry = indexed_response->entry;
+    raw_headers.append(1, '\0');
+    raw_headers.append("Cache-Control: no-cache");
+    raw_headers.append(1, '\0');
+    raw_headers.append("ETag: " + GetETag(entry));
+    raw_headers.append(1, '\0');
+    raw_headers.append("Last-Modified: " +
+                       FormatHttpTime(entry.last_modified));
+    raw_headers.append(1, '\0');
+    raw_headers.append("Accept-Ranges: bytes");
+
+    if (!indexed_response->not_modified) {
+      int64 content_length = entry.size;
+      if (indexed_response->first_byte >= 0) {
+        content_length =
+            indexed_response->last_byte - indexed_response->first_byte + 1;
+        raw_headers.append(1, '\0');
+        raw_headers.append(base::StringPrintf(
+            "Content-Range: bytes %" PRId64 "-%" PRId64 "/%" PRId64,
+            indexed_response->first_byte, indexed_response->last_byte,
+            entry.size));
+      }
+      raw_headers.append(1, '\0');
+      raw_headers.append("Content-Length: " +
+                         base::Int64ToString(content_length));
+    }
+  }
+
   raw_headers.append(2, '\0');
   return new net::HttpResponseHeaders(raw_headers);
 }
@@ -73,7 +182,8 @@ class GeneratedMainDocumentJob: public net::URLRequestSimpleJob {
     : net::URLRequestSimpleJob(request, network_delegate),
       application_(application),
       mime_type_("text/html"),
-      relative_path_(relative_path) {
+      relative_path_(relative_path),
+      weak_factory_(this) {
   }
 
   // Overridden from URLRequestSimpleJob:
@@ -83,42 +193,66 @@ class GeneratedMainDocumentJob: public net::URLRequestSimpleJob {
                       const net::CompletionCallback& callback) const OVERRIDE {
     *mime_type = mime_type_;
     *charset = "utf-8";
-    *data = "<!DOCTYPE html>\n<body>\n";
-
-    // TODO(xiang): use manifest handler instead of the raw data.
-    const base::ListValue* main_scripts;
-    application_->GetManifest()->GetList(
-        xwalk::application_manifest_keys::kAppMainScriptsKey,
-        &main_scripts);
-    for (size_t i = 0; i < main_scripts->GetSize(); ++i) {
-      std::string script;
-      main_scripts->GetString(i, &script);
-      *data += "<script src=\"";
-      *data += script;
-      *data += "\"></script>\n";
-    }
-    return net::OK;
+    const xwalk::application::MainDocumentInfo* main_info =
+        xwalk::application::MainDocumentInfo::Get(application_.get());
+    if (!main_info || !main_info->has_generated_document())
+      return net::ERR_FILE_NOT_FOUND;
+
+    // The document is built from the scripts of the application the first
+    // time it's requested.
+    std::string* document = new std::string;
+    bool posted = base::WorkerPool::PostTaskAndReply(
+        FROM_HERE,
+        base::Bind(&GetGeneratedDocument, application_,
+                   base::Unretained(document)),
+        base::Bind(&GeneratedMainDocumentJob::OnDocumentGenerated,
+                   weak_factory_.GetWeakPtr(), base::Owned(document),
+                   data, callback),
+        true /* task is slow */);
+    DCHECK(posted);
+    return net::ERR_IO_PENDING;
   }
 
   virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
     response_info_.headers = BuildHttpHeaders(mime_type_, "GET", relative_path_,
-        relative_path_, true);
+        relative_path_, true, NULL);
     *info = response_info_;
   }
 
  private:
   virtual ~GeneratedMainDocumentJob() {}
 
+  static void GetGeneratedDocument(
+      const scoped_refptr<const Application>& application,
+      std::string* document) {
+    *document = xwalk::application::MainDocumentInfo::Get(
+        application.get())->GetGeneratedDocument(application.get());
+  }
+
+  void OnDocumentGenerated(std::string* document, std::string* data,
+                           const net::CompletionCallback& callback) {
+    if (document->empty()) {
+      callback.Run(net::ERR_FILE_NOT_FOUND);
+      return;
+    }
+    data->swap(*document);
+    callback.Run(net::OK);
+  }
+
   scoped_refptr<const Application> application_;
   const std::string mime_type_;
   const base::FilePath relative_path_;
   net::HttpResponseInfo response_info_;
+  mutable base::WeakPtrFactory<GeneratedMainDocumentJob> weak_factory_;
 };
 
 void ReadResourceFilePath(
     const xwalk::application::ApplicationResource& resource,
+    const scoped_refptr<ApplicationResourceIndex>& index,
     base::FilePath* file_path) {
   *file_path = resource.GetFilePath();
+  if (index)
+    index->Load();
 }
 
 class URLRequestApplicationJob : public net::URLRequestFileJob {
@@ -130,30 +264,67 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
       const std::string& application_id,
       const base::FilePath& directory_path,
       const base::FilePath& relative_path,
+      const scoped_refptr<ApplicationResourceIndex>& index,
       bool is_authority_match)
       : net::URLRequestFileJob(
           request, network_delegate, base::FilePath(), file_task_runner),
-      resource_(application_id, directory_path, relative_path),
       relative_path_(relative_path),
+      index_(index),
       is_authority_match_(is_authority_match),
+      is_indexed_(false),
+      resource_(application_id, directory_path, relative_path),
       weak_factory_(this) {
   }
 
+  virtual bool GetMimeType(std::string* mime_type) const OVERRIDE {
+    if (is_indexed_ && !indexed_response_.entry.mime_type.empty()) {
+      *mime_type = indexed_response_.entry.mime_type;
+      return true;
+    }
+    return URLRequestFileJob::GetMimeType(mime_type);
+  }
+
   virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
     std::string mime_type;
     GetMimeType(&mime_type);
     std::string method = request()->method();
     response_info_.headers = BuildHttpHeaders(mime_type, method, file_path_,
-        relative_path_, is_authority_match_);
+        relative_path_, is_authority_match_,
+        is_indexed_ ? &indexed_response_ : NULL);
     *info = response_info_;
   }
 
+  virtual void SetExtraRequestHeaders(
+      const net::HttpRequestHeaders& headers) OVERRIDE {
+    URLRequestFileJob::SetExtraRequestHeaders(headers);
+    headers.GetHeader(net::HttpRequestHeaders::kIfNoneMatch, &if_none_match_);
+
+    // Like URLRequestFileJob, only single ranges are supported.
+    std::string range_header;
+    std::vector<net::HttpByteRange> ranges;
+    if (headers.GetHeader(net::HttpRequestHeaders::kRange, &range_header) &&
+        net::HttpUtil::ParseRangeHeader(range_header, &ranges) &&
+        ranges.size() == 1) {
+      byte_range_ = ranges[0];
+    }
+  }
+
   virtual void Start() OVERRIDE {
+    // Resources resolved before are served without going through the worker
+    // pool, which matters for pages loading many small files.
+    base::FilePath cached_file_path;
+    if (!resource_.empty() && (!index_ || index_->is_loaded()) &&
+        ApplicationResourceCache::GetInstance()->Lookup(
+            resource_.application_id(), relative_path_, &cached_file_path)) {
+      StartWithFilePath(cached_file_path);
+      return;
+    }
+
     base::FilePath* read_file_path = new base::FilePath;
 
     bool posted = base::WorkerPool::PostTaskAndReply(
         FROM_HERE,
-        base::Bind(&ReadResourceFilePath, resource_,
+        base::Bind(&ReadResourceFilePath, resource_, index_,
                    base::Unretained(read_file_path)),
         base::Bind(&URLRequestApplicationJob::OnFilePathRead,
                    weak_factory_.GetWeakPtr(),
@@ -162,30 +333,177 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
     DCHECK(posted);
   }
 
+  virtual bool ReadRawData(net::IOBuffer* buf, int buf_size,
+                           int* bytes_read) OVERRIDE {
+    if (!HasBody()) {
+      *bytes_read = 0;
+      return true;
+    }
+    return URLRequestFileJob::ReadRawData(buf, buf_size, bytes_read);
+  }
+
  private:
   virtual ~URLRequestApplicationJob() {}
 
   void OnFilePathRead(base::FilePath* read_file_path) {
-    file_path_ = *read_file_path;
-    if (file_path_.empty())
+    if (read_file_path->empty()) {
       NotifyHeadersComplete();
-    else
+      return;
+    }
+
+    ApplicationResourceCache::GetInstance()->Insert(
+        resource_.application_id(), relative_path_, *read_file_path);
+    StartWithFilePath(*read_file_path);
+  }
+
+  void StartWithFilePath(const base::FilePath& file_path) {
+    file_path_ = file_path;
+    is_indexed_ = index_ &&
+        index_->GetEntry(relative_path_, &indexed_response_.entry);
+    if (!is_indexed_) {
       URLRequestFileJob::Start();
+      return;
+    }
+
+    // The index knows enough to answer these without opening the file.
+    if (!if_none_match_.empty() &&
+        MatchesETag(if_none_match_, GetETag(indexed_response_.entry))) {
+      indexed_response_.not_modified = true;
+      NotifyHeadersComplete();
+      return;
+    }
+    if (request()->method() == "HEAD") {
+      NotifyHeadersComplete();
+      return;
+    }
+
+    // Otherwise URLRequestFileJob fails the request when opening the file.
+    if (byte_range_.IsValid() &&
+        byte_range_.ComputeBounds(indexed_response_.entry.size)) {
+      indexed_response_.first_byte = byte_range_.first_byte_position();
+      indexed_response_.last_byte = byte_range_.last_byte_position();
+    }
+    URLRequestFileJob::Start();
+  }
+
+  // Whether the file is read, it isn't even opened for some of the responses
+  // without body.
+  bool HasBody() const {
+    return !file_path_.empty() && !indexed_response_.not_modified &&
+        request()->method() != "HEAD";
   }
 
   net::HttpResponseInfo response_info_;
   base::FilePath relative_path_;
+  scoped_refptr<ApplicationResourceIndex> index_;
   bool is_authority_match_;
+  std::string if_none_match_;
+  net::HttpByteRange byte_range_;
+  bool is_indexed_;
+  IndexedResponse indexed_response_;
   xwalk::application::ApplicationResource resource_;
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
 };
 
+void ReadArchiveFile(scoped_refptr<ApplicationArchive> archive,
+                     const base::FilePath& relative_path,
+                     scoped_refptr<base::RefCountedMemory>* data) {
+  if (archive && !relative_path.empty())
+    *data = archive->GetFile(relative_path);
+}
+
+// Serves the files of applications installed without extracting their
+// package. Stored files are copied to the network buffers straight from the
+// mapping of the package.
+class URLRequestApplicationArchiveJob : public net::URLRequestJob {
+ public:
+  URLRequestApplicationArchiveJob(
+      net::URLRequest* request,
+      net::NetworkDelegate* network_delegate,
+      const scoped_refptr<ApplicationArchive>& archive,
+      const base::FilePath& relative_path,
+      bool is_authority_match)
+      : net::URLRequestJob(request, network_delegate),
+        archive_(archive),
+        relative_path_(relative_path),
+        is_authority_match_(is_authority_match),
+        read_offset_(0),
+        weak_factory_(this) {
+  }
+
+  virtual void Start() OVERRIDE {
+    scoped_refptr<base::RefCountedMemory>* data =
+        new scoped_refptr<base::RefCountedMemory>;
+
+    bool posted = base::WorkerPool::PostTaskAndReply(
+        FROM_HERE,
+        base::Bind(&ReadArchiveFile, archive_, relative_path_,
+                   base::Unretained(data)),
+        base::Bind(&URLRequestApplicationArchiveJob::OnFileRead,
+                   weak_factory_.GetWeakPtr(),
+                   base::Owned(data)),
+        true /* task is slow */);
+    DCHECK(posted);
+  }
+
+  virtual bool GetMimeType(std::string* mime_type) const OVERRIDE {
+    return net::GetMimeTypeFromFile(relative_path_, mime_type);
+  }
+
+  virtual void GetResponseInfo(net::HttpResponseInfo* info) OVERRIDE {
+    std::string mime_type;
+    GetMimeType(&mime_type);
+    std::string method = request()->method();
+    response_info_.headers = BuildHttpHeaders(mime_type, method,
+        data_ ? relative_path_ : base::FilePath(), relative_path_,
+        is_authority_match_, NULL);
+    *info = response_info_;
+  }
+
+  virtual bool ReadRawData(net::IOBuffer* buf, int buf_size,
+                           int* bytes_read) OVERRIDE {
+    if (!data_ || request()->method() == "HEAD") {
+      *bytes_read = 0;
+      return true;
+    }
+    const size_t remaining = data_->size() - read_offset_;
+    const size_t count = std::min(remaining, static_cast<size_t>(buf_size));
+    memcpy(buf->data(), data_->front() + read_offset_, count);
+    read_offset_ += count;
+    *bytes_read = static_cast<int>(count);
+    return true;
+  }
+
+ private:
+  virtual ~URLRequestApplicationArchiveJob() {}
+
+  void OnFileRead(scoped_refptr<base::RefCountedMemory>* data) {
+    data_ = *data;
+    if (data_)
+      set_expected_content_size(data_->size());
+    NotifyHeadersComplete();
+  }
+
+  scoped_refptr<ApplicationArchive> archive_;
+  base::FilePath relative_path_;
+  bool is_authority_match_;
+  scoped_refptr<base::RefCountedMemory> data_;
+  size_t read_offset_;
+  net::HttpResponseInfo response_info_;
+  base::WeakPtrFactory<URLRequestApplicationArchiveJob> weak_factory_;
+};
+
 class ApplicationProtocolHandler
     : public net::URLRequestJobFactory::ProtocolHandler {
  public:
   explicit ApplicationProtocolHandler(const Application* application)
     : application_(application) {
     CHECK(application_);
+    // Opened on the first request, from a worker thread.
+    if (ApplicationArchive::IsArchivePath(application_->Path()))
+      archive_ = new ApplicationArchive(application_->Path());
+    else
+      index_ = new ApplicationResourceIndex(application_->Path());
   }
 
   virtual ~ApplicationProtocolHandler() {}
@@ -196,6 +514,8 @@ class ApplicationProtocolHandler
 
  private:
   const Application* application_;
+  scoped_refptr<ApplicationArchive> archive_;
+  scoped_refptr<ApplicationResourceIndex> index_;
   DISALLOW_COPY_AND_ASSIGN(ApplicationProtocolHandler);
 };
 
@@ -219,6 +539,15 @@ ApplicationProtocolHandler::MaybeCreateJob(
         relative_path, application_);
   }
 
+  if (archive_) {
+    return new URLRequestApplicationArchiveJob(
+        request,
+        network_delegate,
+        is_authority_match ? archive_ : scoped_refptr<ApplicationArchive>(),
+        relative_path,
+        is_authority_match);
+  }
+
   return new URLRequestApplicationJob(
       request,
       network_delegate,
@@ -228,6 +557,7 @@ ApplicationProtocolHandler::MaybeCreateJob(
       application_id,
       directory_path,
       relative_path,
+      is_authority_match ? index_ : scoped_refptr<ApplicationResourceIndex>(),
       is_authority_match);
 }
 
@@ -6,12 +6,18 @@
 
 #include <string>
 
+#include "base/bind.h"
+#include "base/command_line.h"
 #include "base/file_util.h"
 #include "base/memory/scoped_ptr.h"
 #include "xwalk/application/browser/application_process_manager.h"
 #include "xwalk/application/browser/application_system.h"
 #include "xwalk/application/browser/installer/xpk_extractor.h"
+#include "xwalk/application/common/application_archive.h"
 #include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/application_resource_cache.h"
+#include "xwalk/application/common/application_resource_index.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 #include "xwalk/runtime/browser/runtime_context.h"
 
 #if defined(OS_TIZEN_MOBILE)
@@ -22,6 +28,22 @@ using xwalk::RuntimeContext;
 
 namespace {
 
+void LogInstallProgress(int64 extracted, int64 total) {
+  VLOG(1) << "Extracted " << extracted << " of " << total << " bytes.";
+}
+
+// Removes the files of an application installed by extracting its package.
+// The index of a previous installation describes files that may have
+// changed, so it goes first: its lengths and validators would be served for
+// the new files.
+bool RemoveExtractedApplication(const base::FilePath& path) {
+  const base::FilePath index =
+      xwalk::application::ApplicationResourceIndex::GetIndexPath(path);
+  if (base::PathExists(index) && !base::DeleteFile(index, false))
+    return false;
+  return !base::DirectoryExists(path) || base::DeleteFile(path, true);
+}
+
 #if defined(OS_TIZEN_MOBILE)
 bool InstallPackageOnTizen(xwalk::application::ApplicationService* service,
                            const std::string& app_id,
@@ -78,7 +100,7 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
       !file_util::CreateDirectory(data_dir))
     return false;
 
-  base::FilePath unpacked_dir;
+  base::FilePath application_path;
   std::string app_id;
   if (!base::DirectoryExists(path)) {
     scoped_refptr<XPKExtractor> extractor = XPKExtractor::Create(path);
@@ -96,21 +118,64 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
       return false;
     }
 
-    base::FilePath temp_dir;
-    extractor->Extract(&temp_dir);
-    unpacked_dir = data_dir.AppendASCII(app_id);
-    if (base::DirectoryExists(unpacked_dir) &&
-        !base::DeleteFile(unpacked_dir, true))
-      return false;
-    if (!base::Move(temp_dir, unpacked_dir))
-      return false;
+    const base::FilePath extracted_path = data_dir.AppendASCII(app_id);
+    const base::FilePath package_path =
+        extracted_path.AddExtension(ApplicationArchive::kPackageExtension);
+    if (CommandLine::ForCurrentProcess()->HasSwitch(
+            switches::kInstallWithoutExtracting)) {
+      // The copy is the one validated, |path| could change after validating
+      // it. Named so it's still recognized as a package.
+      const base::FilePath temp_package =
+          data_dir.AppendASCII(app_id + ".tmp").AddExtension(
+              ApplicationArchive::kPackageExtension);
+      if (!base::CopyFile(path, temp_package))
+        return false;
+      scoped_refptr<XPKExtractor> copy = XPKExtractor::Create(temp_package);
+      if (!copy || copy->GetPackageID() != app_id || !copy->Validate()) {
+        LOG(ERROR) << "XPK file is invalid.";
+        copy = NULL;
+        base::DeleteFile(temp_package, false);
+        return false;
+      }
+      copy = NULL;
+
+      // Left by an installation that extracted the package.
+      if (!RemoveExtractedApplication(extracted_path) ||
+          !base::Move(temp_package, package_path)) {
+        base::DeleteFile(temp_package, false);
+        return false;
+      }
+      application_path = package_path;
+    } else {
+      base::FilePath temp_dir;
+      extractor->set_progress_callback(base::Bind(&LogInstallProgress));
+      if (!extractor->Extract(&temp_dir)) {
+        LOG(ERROR) << "XPK file is invalid.";
+        return false;
+      }
+      application_path = extracted_path;
+      // Left by an installation without extracting the package.
+      if (base::PathExists(package_path) &&
+          !base::DeleteFile(package_path, false))
+        return false;
+      if (!RemoveExtractedApplication(application_path))
+        return false;
+      if (!base::Move(temp_dir, application_path))
+        return false;
+      // Without it the resources are still served, just without validators.
+      if (!ApplicationResourceIndex::Create(application_path)) {
+        LOG(WARNING) << "Couldn't index the resources of " << app_id;
+        base::DeleteFile(
+            ApplicationResourceIndex::GetIndexPath(application_path), false);
+      }
+    }
   } else {
-    unpacked_dir = path;
+    application_path = path;
   }
 
   std::string error;
   scoped_refptr<Application> application =
-      LoadApplication(unpacked_dir,
+      LoadApplication(application_path,
                       app_id,
                       Manifest::COMMAND_LINE,
                       &error);
@@ -125,6 +190,9 @@ bool ApplicationService::Install(const base::FilePath& path, std::string* id) {
     return false;
   }
 
+  // The paths resolved for a previous installation may not be valid anymore.
+  ApplicationResourceCache::GetInstance()->Invalidate(application->ID());
+
 #if defined(OS_TIZEN_MOBILE)
   if (!InstallPackageOnTizen(this, application->ID(),
                              runtime_context_->GetPath()))
@@ -149,14 +217,35 @@ bool ApplicationService::Uninstall(const std::string& id) {
     return false;
   }
 
+  ApplicationResourceCache::GetInstance()->Invalidate(id);
+
   const base::FilePath resources =
       runtime_context_->GetPath().Append(kApplicationsDir).AppendASCII(id);
+
+  // Removed first, so it never outlives the resources it describes.
+  const base::FilePath index =
+      ApplicationResourceIndex::GetIndexPath(resources);
+  if (base::PathExists(index) && !base::DeleteFile(index, false)) {
+    LOG(ERROR) << "Error occurred while trying to remove application with id "
+               << id << "; Cannot remove its resource index.";
+    return false;
+  }
+
   if (base::DirectoryExists(resources) &&
       !base::DeleteFile(resources, true)) {
     LOG(ERROR) << "Error occurred while trying to remove application with id "
                << id << "; Cannot remove all resources.";
     return false;
   }
+
+  // Applications installed without extracting them only have their package.
+  const base::FilePath package =
+      resources.AddExtension(ApplicationArchive::kPackageExtension);
+  if (base::PathExists(package) && !base::DeleteFile(package, false)) {
+    LOG(ERROR) << "Error occurred while trying to remove application with id "
+               << id << "; Cannot remove its package.";
+    return false;
+  }
   return true;
 }
 
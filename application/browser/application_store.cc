@@ -4,6 +4,7 @@
 
 #include "xwalk/application/browser/application_store.h"
 
+#include <set>
 #include <utility>
 
 #include "xwalk/application/common/application_file_util.h"
@@ -22,6 +23,7 @@ ApplicationStore::ApplicationStore(xwalk::RuntimeContext* runtime_context)
     : runtime_context_(runtime_context),
       db_store_(new DBStoreImpl(runtime_context->GetPath())),
       applications_(new ApplicationMap) {
+  db_store_->set_load_on_demand(true);
   db_store_->AddObserver(this);
   db_store_->InitDB();
 }
@@ -43,10 +45,11 @@ bool ApplicationStore::AddApplication(
 }
 
 bool ApplicationStore::RemoveApplication(const std::string& id) {
-  if (applications_->erase(id) != 1) {
+  if (!Contains(id)) {
     LOG(ERROR) << "Application " << id << " is invalid.";
     return false;
   }
+  applications_->erase(id);
 
   if (!db_store_->Remove(id)) {
     LOG(ERROR) << "Error occurred while trying to remove application"
@@ -58,7 +61,7 @@ bool ApplicationStore::RemoveApplication(const std::string& id) {
 }
 
 bool ApplicationStore::Contains(const std::string& app_id) const {
-  return applications_->find(app_id) != applications_->end();
+  return db_store_->HasApplication(app_id);
 }
 
 scoped_refptr<const Application> ApplicationStore::GetApplicationByID(
@@ -68,49 +71,53 @@ scoped_refptr<const Application> ApplicationStore::GetApplicationByID(
     return it->second;
   }
 
-  return NULL;
+  if (!Contains(application_id))
+    return NULL;
+
+  scoped_refptr<const Application> application =
+      CreateApplication(application_id);
+  if (application)
+    Insert(application);
+  return application;
 }
 
 ApplicationStore::ApplicationMap*
 ApplicationStore::GetInstalledApplications() const {
+  const std::set<std::string>& ids = db_store_->GetApplicationIDs();
+  std::set<std::string>::const_iterator it = ids.begin();
+  for (; it != ids.end(); ++it)
+    GetApplicationByID(*it);
   return applications_.get();
 }
 
-void ApplicationStore::InitApplications(const base::DictionaryValue* db) {
-  CHECK(db);
-
-  for (base::DictionaryValue::Iterator it(*db); !it.IsAtEnd();
-       it.Advance()) {
-    const std::string& id = it.key();
-    const base::DictionaryValue* value;
-    const base::DictionaryValue* manifest;
-    std::string app_path;
-    if (!it.value().GetAsDictionary(&value) ||
-        !value->GetString(ApplicationStore::kApplicationPath, &app_path) ||
-        !value->GetDictionary(ApplicationStore::kManifestPath, &manifest))
-      break;
-
-    std::string error;
-    scoped_refptr<Application> application =
-        Application::Create(base::FilePath::FromUTF8Unsafe(app_path),
-                            Manifest::INTERNAL,
-                            *manifest,
-                            id,
-                            &error);
-    if (!application) {
-      LOG(ERROR) << "Load appliation error: " << error;
-      break;
-    }
-
-    if (!Insert(application)) {
-      LOG(ERROR) << "An error occurred while"
-                    "initializing the application data.";
-      break;
-    }
+scoped_refptr<const Application> ApplicationStore::CreateApplication(
+    const std::string& id) const {
+  const base::DictionaryValue* value = db_store_->GetApplicationValue(id);
+  const base::DictionaryValue* manifest;
+  std::string app_path;
+  if (!value ||
+      !value->GetString(ApplicationStore::kApplicationPath, &app_path) ||
+      !value->GetDictionary(ApplicationStore::kManifestPath, &manifest)) {
+    LOG(ERROR) << "Invalid data for application " << id << ".";
+    return NULL;
+  }
+
+  std::string error;
+  scoped_refptr<Application> application =
+      Application::Create(base::FilePath::FromUTF8Unsafe(app_path),
+                          Manifest::INTERNAL,
+                          *manifest,
+                          id,
+                          &error);
+  if (!application) {
+    LOG(ERROR) << "Load appliation error: " << error;
+    return NULL;
   }
+  return application;
 }
 
-bool ApplicationStore::Insert(scoped_refptr<const Application> application) {
+bool ApplicationStore::Insert(
+    scoped_refptr<const Application> application) const {
   return applications_->insert(
       std::pair<std::string, scoped_refptr<const Application> >(
           application->ID(), application)).second;
@@ -121,8 +128,9 @@ void ApplicationStore::OnDBValueChanged(const std::string& key,
 }
 
 void ApplicationStore::OnInitializationCompleted(bool succeeded) {
-  if (succeeded)
-    InitApplications(db_store_->GetApplications());
+  // The applications are created on demand, see GetApplicationByID().
+  if (!succeeded)
+    LOG(ERROR) << "Unable to read the installed applications.";
 }
 
 }  // namespace application
@@ -20,6 +20,9 @@ class RuntimeContext;
 namespace xwalk {
 namespace application {
 
+// Only the ids of the installed applications are read when starting, each
+// Application is created the first time it's asked for, so starting doesn't
+// get slower with the number of installed applications.
 class ApplicationStore: public DBStore::Observer {
  public:
   typedef DBStoreSqliteImpl DBStoreImpl;
@@ -45,6 +48,8 @@ class ApplicationStore: public DBStore::Observer {
   scoped_refptr<const Application> GetApplicationByID(
       const std::string& application_id) const;
 
+  // Creates all the applications not created yet, only use it when all of
+  // them are needed.
   ApplicationMap* GetInstalledApplications() const;
 
   // Implement the DBStore::Observer.
@@ -53,8 +58,9 @@ class ApplicationStore: public DBStore::Observer {
   virtual void OnInitializationCompleted(bool succeeded) OVERRIDE;
 
  private:
-  void InitApplications(const base::DictionaryValue* value);
-  bool Insert(scoped_refptr<const Application> application);
+  scoped_refptr<const Application> CreateApplication(
+      const std::string& id) const;
+  bool Insert(scoped_refptr<const Application> application) const;
   xwalk::RuntimeContext* runtime_context_;
   scoped_ptr<DBStoreImpl> db_store_;
   scoped_ptr<ApplicationMap> applications_;
@@ -4,10 +4,21 @@
 
 #include "xwalk/application/browser/installer/xpk_extractor.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "base/logging.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool.h"
+#include "base/time/time.h"
+#include "third_party/zlib/google/zip_reader.h"
 
 namespace xwalk {
 namespace application {
@@ -15,6 +26,150 @@ namespace application {
 const base::FilePath::CharType kApplicationFileExtension[] =
     FILE_PATH_LITERAL(".xpk");
 
+namespace {
+
+// More threads don't help, writing the files becomes the bottleneck.
+const int kMaxExtractionThreads = 8;
+
+const int kProgressIntervalMs = 100;
+
+}  // namespace
+
+// Verifies the signature of the package in a worker thread while other
+// worker threads decompress its entries. Each of those opens the zip file on
+// its own, since a zip::ZipReader can't be shared between threads, and
+// extracts the entries it claims first, so faster threads take more of them.
+class XPKExtractor::ExtractionJob
+    : public base::RefCountedThreadSafe<ExtractionJob> {
+ public:
+  ExtractionJob(const base::FilePath& source_path,
+                const base::FilePath& target_dir,
+                XPKPackage* package,
+                int entry_count)
+      : source_path_(source_path),
+        target_dir_(target_dir),
+        package_(package),
+        claimed_entries_(entry_count, 0),
+        failed_(0),
+        pending_tasks_(0),
+        extracted_bytes_(0),
+        done_(true, false) {}
+
+  // Blocks until the package is validated and extracted, calling |progress|
+  // periodically if it's not null.
+  bool Run(int thread_count, int64 total_bytes,
+           const ProgressCallback& progress) {
+    pending_tasks_ = thread_count + 1;
+    PostTask(base::Bind(&ExtractionJob::ValidatePackage, this));
+    for (int i = 0; i < thread_count; ++i)
+      PostTask(base::Bind(&ExtractionJob::ExtractEntries, this));
+
+    const base::TimeDelta interval =
+        base::TimeDelta::FromMilliseconds(kProgressIntervalMs);
+    while (!done_.TimedWait(interval)) {
+      if (!progress.is_null())
+        progress.Run(extracted_bytes(), total_bytes);
+    }
+    if (!progress.is_null())
+      progress.Run(extracted_bytes(), total_bytes);
+
+    return !base::subtle::Acquire_Load(&failed_);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ExtractionJob>;
+  ~ExtractionJob() {}
+
+  void PostTask(const base::Closure& task) {
+    if (!base::WorkerPool::PostTask(FROM_HERE, task, true))
+      task.Run();
+  }
+
+  void ValidatePackage() {
+    if (!package_->Validate()) {
+      LOG(ERROR) << "The signature of the XPK file is invalid.";
+      Fail();
+    }
+    TaskDone();
+  }
+
+  void ExtractEntries() {
+    TRACE_EVENT0("xwalk", "XPKExtractor::ExtractEntries");
+    zip::ZipReader reader;
+    if (!reader.Open(source_path_)) {
+      Fail();
+      TaskDone();
+      return;
+    }
+
+    int index = 0;
+    while (reader.HasMore() && !base::subtle::Acquire_Load(&failed_)) {
+      if (index >= static_cast<int>(claimed_entries_.size())) {
+        Fail();
+        break;
+      }
+      if (!base::subtle::NoBarrier_CompareAndSwap(
+              &claimed_entries_[index], 0, 1) &&
+          !ExtractCurrentEntry(&reader)) {
+        Fail();
+        break;
+      }
+      if (!reader.AdvanceToNextEntry()) {
+        Fail();
+        break;
+      }
+      ++index;
+    }
+    TaskDone();
+  }
+
+  bool ExtractCurrentEntry(zip::ZipReader* reader) {
+    if (!reader->OpenCurrentEntryInZip())
+      return false;
+    const zip::ZipReader::EntryInfo* entry = reader->current_entry_info();
+    if (entry->is_unsafe()) {
+      LOG(ERROR) << "Unsafe path in the XPK file: "
+                 << entry->file_path().value();
+      return false;
+    }
+    if (!reader->ExtractCurrentEntryIntoDirectory(target_dir_))
+      return false;
+
+    base::AutoLock l(lock_);
+    extracted_bytes_ += entry->original_size();
+    return true;
+  }
+
+  int64 extracted_bytes() {
+    base::AutoLock l(lock_);
+    return extracted_bytes_;
+  }
+
+  void Fail() {
+    base::subtle::Release_Store(&failed_, 1);
+  }
+
+  void TaskDone() {
+    if (!base::subtle::Barrier_AtomicIncrement(&pending_tasks_, -1))
+      done_.Signal();
+  }
+
+  const base::FilePath source_path_;
+  const base::FilePath target_dir_;
+  XPKPackage* package_;
+
+  std::vector<base::subtle::Atomic32> claimed_entries_;
+  base::subtle::Atomic32 failed_;
+  base::subtle::Atomic32 pending_tasks_;
+
+  base::Lock lock_;
+  int64 extracted_bytes_;
+
+  base::WaitableEvent done_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExtractionJob);
+};
+
 XPKExtractor::XPKExtractor() {
 }
 
@@ -40,7 +195,13 @@ std::string XPKExtractor::GetPackageID() const {
   return xpk_package_.get()?xpk_package_->Id():"";
 }
 
+bool XPKExtractor::Validate() {
+  return xpk_package_.get() && xpk_package_->IsOk() &&
+      xpk_package_->Validate();
+}
+
 bool XPKExtractor::Extract(base::FilePath* target_path) {
+  TRACE_EVENT0("xwalk", "XPKExtractor::Extract");
   if (!xpk_package_.get() ||
       !xpk_package_->IsOk()) {
     LOG(ERROR) << "XPK file is broken.";
@@ -53,8 +214,38 @@ bool XPKExtractor::Extract(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
+  // Reads the central directory of the zip file, to know how much work there
+  // is to do.
+  zip::ZipReader reader;
+  if (!reader.Open(source_path_)) {
+    LOG(ERROR) << "An error occurred during package extraction";
+    return false;
+  }
+  const int entry_count = reader.num_entries();
+  int64 total_bytes = 0;
+  while (reader.HasMore()) {
+    if (!reader.OpenCurrentEntryInZip()) {
+      LOG(ERROR) << "An error occurred during package extraction";
+      return false;
+    }
+    total_bytes += reader.current_entry_info()->original_size();
+    if (!reader.AdvanceToNextEntry()) {
+      LOG(ERROR) << "An error occurred during package extraction";
+      return false;
+    }
+  }
+  reader.Close();
+
+  const int thread_count = std::max(1, std::min(
+      std::min(base::SysInfo::NumberOfProcessors(), kMaxExtractionThreads),
+      entry_count));
+
+  scoped_refptr<ExtractionJob> job(new ExtractionJob(
+      source_path_, temp_dir_.path(), xpk_package_.get(), entry_count));
+  if (!job->Run(thread_count, total_bytes, progress_callback_)) {
     LOG(ERROR) << "An error occurred during package extraction";
+    // The content may be incomplete or not come from the signer.
+    ignore_result(temp_dir_.Delete());
     return false;
   }
 
@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "base/callback.h"
 #include "base/memory/ref_counted.h"
 #include "base/files/scoped_temp_dir.h"
 #include "xwalk/application/browser/installer/xpk_package.h"
@@ -17,15 +18,34 @@ namespace application {
 class XPKExtractor
     : public base::RefCountedThreadSafe<XPKExtractor> {
  public:
+  // Called with the number of bytes extracted so far and the total size of
+  // the package content.
+  typedef base::Callback<void(int64 extracted, int64 total)> ProgressCallback;
+
   XPKExtractor();
   static scoped_refptr<XPKExtractor> Create(const base::FilePath& source_path);
   // The function will unzip the XPK file and return the target path where
   // to decompress by the parameter |target_path|.
+  //
+  // The signature is verified while the entries are decompressed, all in
+  // worker threads, and the content is discarded if it turns out to be
+  // invalid. Blocks until everything is done.
   bool Extract(base::FilePath* target_path);
   std::string GetPackageID() const;
 
+  // Only verifies the signature, for packages installed without extracting
+  // them.
+  bool Validate();
+
+  // Called periodically during Extract(), in the thread calling it.
+  void set_progress_callback(const ProgressCallback& callback) {
+    progress_callback_ = callback;
+  }
+
  private:
   friend class base::RefCountedThreadSafe<XPKExtractor>;
+  class ExtractionJob;
+
   ~XPKExtractor();
   explicit XPKExtractor(const base::FilePath& source_path);
   bool CreateTempDirectory();
@@ -34,6 +54,7 @@ class XPKExtractor
   // Temporary directory for unpacking.
   base::ScopedTempDir temp_dir_;
   scoped_ptr<XPKPackage> xpk_package_;
+  ProgressCallback progress_callback_;
 };
 
 }  // namespace application
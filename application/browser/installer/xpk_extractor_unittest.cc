@@ -4,14 +4,92 @@
 
 #include "xwalk/application/browser/installer/xpk_extractor.h"
 
+#include <cstring>
+#include <vector>
+
+#include "base/bind.h"
 #include "base/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "crypto/rsa_private_key.h"
+#include "crypto/signature_creator.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
 
 namespace xwalk {
 namespace application {
 
+namespace {
+
+void RecordProgress(int64* last_extracted, int64* last_total,
+                    int64 extracted, int64 total) {
+  EXPECT_GE(extracted, *last_extracted);
+  *last_extracted = extracted;
+  *last_total = total;
+}
+
+// Writes an XPK file with |file_count| files of |file_size| bytes, signed
+// with a new key. The content is only partly compressible, like images.
+bool CreateXPKFile(const base::FilePath& dir, int file_count, int file_size,
+                   base::FilePath* xpk_path) {
+  base::FilePath content_dir = dir.AppendASCII("content");
+  if (!file_util::CreateDirectory(content_dir.AppendASCII("images")))
+    return false;
+  uint32 seed = 42;
+  std::string data(file_size, 0);
+  for (int i = 0; i < file_count; ++i) {
+    for (int j = 0; j < file_size; ++j) {
+      seed = seed * 1103515245 + 12345;
+      data[j] = static_cast<char>((seed >> 16) & 0x3f);
+    }
+    base::FilePath file = content_dir.AppendASCII("images").AppendASCII(
+        base::StringPrintf("image%d.png", i));
+    if (file_util::WriteFile(file, data.data(), file_size) != file_size)
+      return false;
+  }
+  const char kManifest[] = "{\"name\": \"big\", \"version\": \"1.0\"}";
+  if (file_util::WriteFile(content_dir.AppendASCII("manifest.json"),
+                           kManifest, sizeof(kManifest) - 1) < 0)
+    return false;
+
+  base::FilePath zip_path = dir.AppendASCII("content.zip");
+  std::string zip_data;
+  if (!zip::Zip(content_dir, zip_path, false) ||
+      !base::ReadFileToString(zip_path, &zip_data))
+    return false;
+
+  scoped_ptr<crypto::RSAPrivateKey> key(crypto::RSAPrivateKey::Create(1024));
+  std::vector<uint8> public_key;
+  if (!key || !key->ExportPublicKey(&public_key))
+    return false;
+  scoped_ptr<crypto::SignatureCreator> signer(
+      crypto::SignatureCreator::Create(key.get()));
+  std::vector<uint8> signature;
+  if (!signer->Update(reinterpret_cast<const uint8*>(zip_data.data()),
+                      zip_data.size()) ||
+      !signer->Final(&signature))
+    return false;
+
+  XPKPackage::Header header;
+  memcpy(header.magic, XPKPackage::kXPKPackageHeaderMagic,
+         XPKPackage::kXPKPackageHeaderMagicSize);
+  header.key_size = public_key.size();
+  header.signature_size = signature.size();
+  std::string xpk_data(reinterpret_cast<const char*>(&header),
+                       sizeof(header));
+  xpk_data.append(public_key.begin(), public_key.end());
+  xpk_data.append(signature.begin(), signature.end());
+  xpk_data.append(zip_data);
+
+  *xpk_path = dir.AppendASCII("big.xpk");
+  return file_util::WriteFile(*xpk_path, xpk_data.data(), xpk_data.size()) ==
+      static_cast<int>(xpk_data.size());
+}
+
+}  // namespace
+
 class XPKExtractorTest : public testing::Test {
  public:
   virtual ~XPKExtractorTest() {
@@ -75,5 +153,58 @@ TEST_F(XPKExtractorTest, BadUnzipFile) {
   EXPECT_FALSE(extractor_->Extract(&path));
 }
 
+TEST_F(XPKExtractorTest, LargePackage) {
+  const int kFileCount = 200;
+  const int kFileSize = 256 * 1024;
+  base::ScopedTempDir source_dir;
+  ASSERT_TRUE(source_dir.CreateUniqueTempDir());
+  base::FilePath xpk_path;
+  ASSERT_TRUE(CreateXPKFile(source_dir.path(), kFileCount, kFileSize,
+                            &xpk_path));
+
+  extractor_ = XPKExtractor::Create(xpk_path);
+  ASSERT_TRUE(extractor_);
+  EXPECT_FALSE(extractor_->GetPackageID().empty());
+  int64 extracted = 0;
+  int64 total = 0;
+  extractor_->set_progress_callback(
+      base::Bind(&RecordProgress, &extracted, &total));
+
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  base::FilePath path;
+  ASSERT_TRUE(extractor_->Extract(&path));
+  LOG(INFO) << "Extracting " << kFileCount << " files of " << kFileSize
+            << " bytes took "
+            << (base::TimeTicks::Now() - start_time).InMilliseconds() << "ms.";
+  EXPECT_TRUE(temp_dir_.Set(path));
+
+  EXPECT_EQ(total, extracted);
+  EXPECT_GE(total, static_cast<int64>(kFileCount) * kFileSize);
+  int64 size;
+  ASSERT_TRUE(file_util::GetFileSize(
+      path.AppendASCII("images").AppendASCII("image7.png"), &size));
+  EXPECT_EQ(kFileSize, size);
+  EXPECT_TRUE(base::PathExists(path.AppendASCII("manifest.json")));
+}
+
+TEST_F(XPKExtractorTest, TamperedLargePackage) {
+  base::ScopedTempDir source_dir;
+  ASSERT_TRUE(source_dir.CreateUniqueTempDir());
+  base::FilePath xpk_path;
+  ASSERT_TRUE(CreateXPKFile(source_dir.path(), 20, 64 * 1024, &xpk_path));
+
+  // Changes the last byte of the package, so the signature doesn't match.
+  std::string xpk_data;
+  ASSERT_TRUE(base::ReadFileToString(xpk_path, &xpk_data));
+  xpk_data[xpk_data.size() - 1] ^= 1;
+  ASSERT_EQ(static_cast<int>(xpk_data.size()),
+            file_util::WriteFile(xpk_path, xpk_data.data(), xpk_data.size()));
+
+  extractor_ = XPKExtractor::Create(xpk_path);
+  ASSERT_TRUE(extractor_);
+  base::FilePath path;
+  EXPECT_FALSE(extractor_->Extract(&path));
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -4,6 +4,7 @@
 
 #include "xwalk/application/browser/installer/xpk_package.h"
 
+#include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "crypto/signature_verifier.h"
 #include "xwalk/application/common/id_util.h"
@@ -18,6 +19,10 @@ const uint8 kSignatureAlgorithm[15] = {
 
 const char XPKPackage::kXPKPackageHeaderMagic[] = "CrWk";
 
+// Packages can be hundreds of MB, reading them in large chunks makes fewer
+// system calls.
+const size_t kReadBufferSize = 1 << 20;
+
 XPKPackage::XPKPackage() {
 }
 
@@ -27,9 +32,11 @@ XPKPackage::~XPKPackage() {
 // static
 scoped_ptr<XPKPackage> XPKPackage::Create(const base::FilePath& path) {
   if (!base::PathExists(path))
-    scoped_ptr<XPKPackage>();
+    return scoped_ptr<XPKPackage>();
   scoped_ptr<ScopedStdioHandle> file(
       new ScopedStdioHandle(file_util::OpenFile(path, "rb")));
+  if (!file->get())
+    return scoped_ptr<XPKPackage>();
   Header header;
   size_t len = fread(&header, 1, sizeof(header), file->get());
   if (len < sizeof(header))
@@ -68,15 +75,16 @@ XPKPackage::XPKPackage(Header header, ScopedStdioHandle* file)
   if (len < header_.signature_size)
     is_ok_ = false;
 
-  if (!Validate())
-    is_ok_ = false;
-
   std::string public_key =
       std::string(reinterpret_cast<char*>(&key_.front()), key_.size());
   id_ = GenerateId(public_key);
 }
 
 bool XPKPackage::Validate() {
+  if (!is_ok_)
+    return false;
+
+  TRACE_EVENT0("xwalk", "XPKPackage::Validate");
 // Set the file read position to the beginning of compressed resource file,
 // which is behind the magic header, public key and signature key.
   fseek(file_->get(), zip_addr_, SEEK_SET);
@@ -88,10 +96,10 @@ bool XPKPackage::Validate() {
                            &key_.front(),
                            key_.size()))
     return false;
-  unsigned char buf[1 << 12];
+  std::vector<uint8> buf(kReadBufferSize);
   size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, len);
+  while ((len = fread(&buf.front(), 1, buf.size(), file_->get())) > 0)
+    verifier.VerifyUpdate(&buf.front(), len);
   if (!verifier.VerifyFinal())
     return false;
 
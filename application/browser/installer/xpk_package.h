@@ -29,14 +29,18 @@ class XPKPackage {
   };
   XPKPackage();
   ~XPKPackage();
+  // Only reads the header, the key and the signature, the package must be
+  // validated with Validate() before using its content.
   static scoped_ptr<XPKPackage> Create(const base::FilePath& path);
-  // Validate the xpk file
   bool IsOk() const { return is_ok_; }
   const std::string& Id() const { return id_; }
 
+  // Verifies the signature of the zip file, reading it from the disk. Can be
+  // called from any thread, but only from one at a time.
+  bool Validate();
+
  private:
   XPKPackage(Header header, ScopedStdioHandle* file);
-  bool Validate();
 
   Header header_;
   scoped_ptr<ScopedStdioHandle> file_;
@@ -0,0 +1,296 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_archive.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/debug/trace_event.h"
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+const base::FilePath::CharType ApplicationArchive::kPackageExtension[] =
+    FILE_PATH_LITERAL(".xpk");
+
+namespace {
+
+// Zip file format constants, see the APPNOTE.TXT of PKWARE.
+const uint32 kEndOfCentralDirectorySignature = 0x06054b50;
+const uint32 kCentralDirectoryHeaderSignature = 0x02014b50;
+const uint32 kLocalHeaderSignature = 0x04034b50;
+const size_t kEndOfCentralDirectorySize = 22;
+const size_t kCentralDirectoryHeaderSize = 46;
+const size_t kLocalHeaderSize = 30;
+const size_t kMaxCommentSize = 0xffff;
+const uint16 kMethodStored = 0;
+const uint16 kMethodDeflated = 8;
+const uint16 kFlagEncrypted = 1;
+
+// Files bigger than this are decompressed each time they are read.
+const size_t kMaxCachedFileSize = 1 << 20;
+const size_t kMaxCachedFiles = 32;
+
+// The uncompressed size of an entry comes from the archive, so it's checked
+// before allocating memory for it. Deflate can't compress more than about
+// 1032:1, and compressed files larger than kMaxUncompressedSize aren't
+// served.
+const uint64 kMaxCompressionRatio = 1032;
+const uint64 kMaxUncompressedSize = 256 << 20;
+
+uint16 ReadUInt16(const uint8* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32 ReadUInt32(const uint8* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+      (static_cast<uint32>(data[3]) << 24);
+}
+
+// Keeps the archive, and so its mapping, alive while the file is used.
+class MappedFileMemory : public base::RefCountedMemory {
+ public:
+  MappedFileMemory(scoped_refptr<ApplicationArchive> archive,
+                   const uint8* data, size_t size)
+      : archive_(archive),
+        data_(data),
+        size_(size) {}
+
+  virtual const unsigned char* front() const OVERRIDE { return data_; }
+  virtual size_t size() const OVERRIDE { return size_; }
+
+ private:
+  virtual ~MappedFileMemory() {}
+
+  scoped_refptr<ApplicationArchive> archive_;
+  const uint8* data_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFileMemory);
+};
+
+// Entries with parent references could point outside of the application.
+bool IsSafeEntryName(const std::string& name) {
+  if (name.empty() || name[0] == '/')
+    return false;
+  size_t start = 0;
+  while (start <= name.size()) {
+    size_t end = name.find('/', start);
+    if (end == std::string::npos)
+      end = name.size();
+    if (name.compare(start, end - start, "..") == 0)
+      return false;
+    start = end + 1;
+  }
+  return true;
+}
+
+}  // namespace
+
+ApplicationArchive::Entry::Entry()
+    : local_header_offset(0),
+      compression_method(0),
+      compressed_size(0),
+      uncompressed_size(0) {}
+
+ApplicationArchive::ApplicationArchive(const base::FilePath& path)
+    : path_(path),
+      opened_(false),
+      open_failed_(false),
+      cache_(kMaxCachedFiles) {}
+
+ApplicationArchive::~ApplicationArchive() {}
+
+// static
+bool ApplicationArchive::IsArchivePath(const base::FilePath& path) {
+  return path.MatchesExtension(kPackageExtension);
+}
+
+scoped_refptr<base::RefCountedMemory> ApplicationArchive::GetFile(
+    const base::FilePath& relative_path) {
+  std::string name = relative_path.AsUTF8Unsafe();
+#if defined(FILE_PATH_USES_WIN_SEPARATORS)
+  std::replace(name.begin(), name.end(), '\\', '/');
+#endif
+  return GetFile(name);
+}
+
+scoped_refptr<base::RefCountedMemory> ApplicationArchive::GetFile(
+    const std::string& name) {
+  TRACE_EVENT1("xwalk", "ApplicationArchive::GetFile",
+               "name", TRACE_STR_COPY(name.c_str()));
+  Entry entry;
+  {
+    base::AutoLock l(lock_);
+    if (!EnsureOpen())
+      return NULL;
+    EntryMap::const_iterator it = entries_.find(name);
+    if (it == entries_.end())
+      return NULL;
+    entry = it->second;
+
+    FileCache::iterator cached = cache_.Get(name);
+    if (cached != cache_.end())
+      return cached->second;
+  }
+
+  // The entries and the mapping don't change once opened, so the file can be
+  // decompressed without holding the lock.
+  scoped_refptr<base::RefCountedMemory> data = ReadEntry(entry);
+  if (data && entry.compression_method != kMethodStored &&
+      data->size() <= kMaxCachedFileSize) {
+    base::AutoLock l(lock_);
+    cache_.Put(name, data);
+  }
+  return data;
+}
+
+bool ApplicationArchive::EnsureOpen() {
+  lock_.AssertAcquired();
+  if (opened_)
+    return true;
+  if (open_failed_)
+    return false;
+
+  TRACE_EVENT0("xwalk", "ApplicationArchive::Open");
+  if (!file_.Initialize(path_) || !ReadCentralDirectory()) {
+    LOG(ERROR) << "Unable to read the application package "
+               << path_.AsUTF8Unsafe();
+    entries_.clear();
+    open_failed_ = true;
+    return false;
+  }
+  opened_ = true;
+  return true;
+}
+
+bool ApplicationArchive::ReadCentralDirectory() {
+  const uint8* data = file_.data();
+  const size_t size = file_.length();
+  if (size < kEndOfCentralDirectorySize)
+    return false;
+
+  // The end of central directory record is followed by a comment of up to
+  // 64 KB, look for its signature backwards.
+  size_t eocd = size - kEndOfCentralDirectorySize;
+  const size_t search_end = eocd > kMaxCommentSize ? eocd - kMaxCommentSize : 0;
+  while (ReadUInt32(data + eocd) != kEndOfCentralDirectorySignature) {
+    if (eocd == search_end)
+      return false;
+    --eocd;
+  }
+
+  const size_t entry_count = ReadUInt16(data + eocd + 10);
+  const size_t directory_size = ReadUInt32(data + eocd + 12);
+  const size_t directory_offset = ReadUInt32(data + eocd + 16);
+
+  // Offsets are relative to the beginning of the zip file, which comes after
+  // the XPK header in packages.
+  if (directory_size + directory_offset > eocd)
+    return false;
+  const size_t archive_start = eocd - directory_size - directory_offset;
+
+  size_t offset = archive_start + directory_offset;
+  for (size_t i = 0; i < entry_count; ++i) {
+    if (offset + kCentralDirectoryHeaderSize > eocd)
+      return false;
+    const uint8* header = data + offset;
+    if (ReadUInt32(header) != kCentralDirectoryHeaderSignature)
+      return false;
+
+    const uint16 flags = ReadUInt16(header + 8);
+    Entry entry;
+    entry.compression_method = ReadUInt16(header + 10);
+    entry.compressed_size = ReadUInt32(header + 20);
+    entry.uncompressed_size = ReadUInt32(header + 24);
+    const size_t name_size = ReadUInt16(header + 28);
+    const size_t extra_size = ReadUInt16(header + 30);
+    const size_t comment_size = ReadUInt16(header + 32);
+    entry.local_header_offset = archive_start + ReadUInt32(header + 42);
+
+    const size_t next_offset = offset + kCentralDirectoryHeaderSize +
+        name_size + extra_size + comment_size;
+    if (next_offset > eocd)
+      return false;
+    std::string name(reinterpret_cast<const char*>(header) +
+                     kCentralDirectoryHeaderSize, name_size);
+    offset = next_offset;
+
+    // Directories don't need an entry, and encrypted or unsafe entries are
+    // never served.
+    if (name.empty() || name[name.size() - 1] == '/')
+      continue;
+    if ((flags & kFlagEncrypted) || !IsSafeEntryName(name)) {
+      LOG(WARNING) << "Ignoring entry " << name << " of "
+                   << path_.AsUTF8Unsafe();
+      continue;
+    }
+    entries_[name] = entry;
+  }
+  return true;
+}
+
+scoped_refptr<base::RefCountedMemory> ApplicationArchive::ReadEntry(
+    const Entry& entry) {
+  const uint8* data = file_.data();
+  const size_t size = file_.length();
+
+  // The local header can have a different extra field than the central one.
+  if (entry.local_header_offset + kLocalHeaderSize > size ||
+      ReadUInt32(data + entry.local_header_offset) != kLocalHeaderSignature)
+    return NULL;
+  const uint8* header = data + entry.local_header_offset;
+  const size_t data_offset = entry.local_header_offset + kLocalHeaderSize +
+      ReadUInt16(header + 26) + ReadUInt16(header + 28);
+  if (data_offset > size || entry.compressed_size > size - data_offset)
+    return NULL;
+  const uint8* compressed_data = data + data_offset;
+
+  if (entry.compression_method == kMethodStored) {
+    if (entry.compressed_size != entry.uncompressed_size)
+      return NULL;
+    return new MappedFileMemory(this, compressed_data, entry.compressed_size);
+  }
+
+  if (entry.compression_method != kMethodDeflated) {
+    LOG(ERROR) << "Unsupported compression method "
+               << entry.compression_method;
+    return NULL;
+  }
+
+  const uint64 uncompressed_size = entry.uncompressed_size;
+  if (uncompressed_size > kMaxUncompressedSize ||
+      uncompressed_size / kMaxCompressionRatio > entry.compressed_size) {
+    LOG(WARNING) << "Invalid uncompressed size " << uncompressed_size
+                 << " for an entry of " << path_.AsUTF8Unsafe();
+    return NULL;
+  }
+
+  std::string file_data(entry.uncompressed_size, '\0');
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // Zip files contain raw deflate data, without zlib header.
+  if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+    return NULL;
+  stream.next_in = const_cast<Bytef*>(compressed_data);
+  stream.avail_in = entry.compressed_size;
+  stream.next_out = reinterpret_cast<Bytef*>(string_as_array(&file_data));
+  stream.avail_out = entry.uncompressed_size;
+  const int result = inflate(&stream, Z_FINISH);
+  const uLong total_out = stream.total_out;
+  inflateEnd(&stream);
+  if ((result != Z_STREAM_END && !(result == Z_BUF_ERROR &&
+                                   entry.uncompressed_size == 0)) ||
+      total_out != entry.uncompressed_size)
+    return NULL;
+
+  return base::RefCountedString::TakeString(&file_data);
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,93 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+// Reads the files of an application straight from its package, so it doesn't
+// need to be extracted when installed. The package is a zip file, possibly
+// preceded by other data like the XPK header. It's mapped in memory and its
+// central directory is read once, when the first file is asked for.
+//
+// Stored files are returned without copying them out of the mapping. Deflated
+// files are decompressed each time, except the last ones used, which are
+// kept in a small cache.
+//
+// Can be used from any thread, but reading files does IO, so not from the
+// UI or IO threads.
+class ApplicationArchive
+    : public base::RefCountedThreadSafe<ApplicationArchive> {
+ public:
+  static const base::FilePath::CharType kPackageExtension[];
+
+  explicit ApplicationArchive(const base::FilePath& path);
+
+  // Whether |path| is a package to read with ApplicationArchive, instead of
+  // a directory with the application files.
+  static bool IsArchivePath(const base::FilePath& path);
+
+  // Returns the content of the file at |relative_path| in the package, or
+  // NULL if there's no such file or the package can't be read.
+  scoped_refptr<base::RefCountedMemory> GetFile(
+      const base::FilePath& relative_path);
+
+  // Same as above, |name| uses '/' as separator, like the zip file.
+  scoped_refptr<base::RefCountedMemory> GetFile(const std::string& name);
+
+  const base::FilePath& path() const { return path_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationArchive>;
+
+  struct Entry {
+    Entry();
+
+    // Offset of the local header, from the beginning of the mapping.
+    size_t local_header_offset;
+    uint16 compression_method;
+    uint32 compressed_size;
+    uint32 uncompressed_size;
+  };
+  typedef std::map<std::string, Entry> EntryMap;
+  typedef base::MRUCache<std::string, scoped_refptr<base::RefCountedMemory> >
+      FileCache;
+
+  ~ApplicationArchive();
+
+  // Maps the file and reads the central directory, if not done yet.
+  bool EnsureOpen();
+  bool ReadCentralDirectory();
+  scoped_refptr<base::RefCountedMemory> ReadEntry(const Entry& entry);
+
+  const base::FilePath path_;
+
+  // Protects the members below.
+  base::Lock lock_;
+  bool opened_;
+  bool open_failed_;
+  base::MemoryMappedFile file_;
+  EntryMap entries_;
+  FileCache cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationArchive);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_ARCHIVE_H_
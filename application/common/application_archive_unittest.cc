@@ -0,0 +1,227 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_archive.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/stl_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/zlib.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+void AppendUInt16(uint16 value, std::string* data) {
+  data->push_back(value & 0xff);
+  data->push_back(value >> 8);
+}
+
+void AppendUInt32(uint32 value, std::string* data) {
+  AppendUInt16(value & 0xffff, data);
+  AppendUInt16(value >> 16, data);
+}
+
+std::string Deflate(const std::string& data) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  EXPECT_EQ(Z_OK, deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               -MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+  std::string result(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(string_as_array(&result));
+  stream.avail_out = result.size();
+  EXPECT_EQ(Z_STREAM_END, deflate(&stream, Z_FINISH));
+  result.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+// Writes zip files with stored or deflated entries, after some data like
+// the header of XPK packages.
+class ZipBuilder {
+ public:
+  explicit ZipBuilder(const std::string& prefix)
+      : prefix_(prefix),
+        entry_count_(0) {}
+
+  void AddFile(const std::string& name, const std::string& content,
+               bool deflate) {
+    AddFileWithUncompressedSize(name, content, deflate, content.size());
+  }
+
+  // The size written in the headers for the uncompressed content can be
+  // different from the real one, like in malicious packages.
+  void AddFileWithUncompressedSize(const std::string& name,
+                                   const std::string& content, bool deflate,
+                                   uint32 uncompressed_size) {
+    const std::string data = deflate ? Deflate(content) : content;
+    const uint16 method = deflate ? 8 : 0;
+    const uint32 crc = crc32(0, reinterpret_cast<const Bytef*>(
+        content.data()), content.size());
+    const uint32 offset = files_.size();
+
+    AppendUInt32(0x04034b50, &files_);
+    AppendUInt16(20, &files_);
+    AppendUInt16(0, &files_);
+    AppendUInt16(method, &files_);
+    AppendUInt32(0, &files_);
+    AppendUInt32(crc, &files_);
+    AppendUInt32(data.size(), &files_);
+    AppendUInt32(uncompressed_size, &files_);
+    AppendUInt16(name.size(), &files_);
+    AppendUInt16(0, &files_);
+    files_.append(name);
+    files_.append(data);
+
+    AppendUInt32(0x02014b50, &directory_);
+    AppendUInt16(20, &directory_);
+    AppendUInt16(20, &directory_);
+    AppendUInt16(0, &directory_);
+    AppendUInt16(method, &directory_);
+    AppendUInt32(0, &directory_);
+    AppendUInt32(crc, &directory_);
+    AppendUInt32(data.size(), &directory_);
+    AppendUInt32(uncompressed_size, &directory_);
+    AppendUInt16(name.size(), &directory_);
+    AppendUInt16(0, &directory_);
+    AppendUInt16(0, &directory_);
+    AppendUInt16(0, &directory_);
+    AppendUInt16(0, &directory_);
+    AppendUInt32(0, &directory_);
+    AppendUInt32(offset, &directory_);
+    directory_.append(name);
+    entry_count_++;
+  }
+
+  bool Write(const base::FilePath& path) {
+    std::string data = prefix_ + files_ + directory_;
+    AppendUInt32(0x06054b50, &data);
+    AppendUInt16(0, &data);
+    AppendUInt16(0, &data);
+    AppendUInt16(entry_count_, &data);
+    AppendUInt16(entry_count_, &data);
+    AppendUInt32(directory_.size(), &data);
+    AppendUInt32(files_.size(), &data);
+    AppendUInt16(0, &data);
+    return file_util::WriteFile(path, data.data(), data.size()) ==
+        static_cast<int>(data.size());
+  }
+
+ private:
+  std::string prefix_;
+  std::string files_;
+  std::string directory_;
+  int entry_count_;
+};
+
+std::string ToString(const scoped_refptr<base::RefCountedMemory>& data) {
+  return std::string(reinterpret_cast<const char*>(data->front()),
+                     data->size());
+}
+
+}  // namespace
+
+class ApplicationArchiveTest : public testing::Test {
+ public:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    package_path_ = temp_dir_.path().AppendASCII("test.xpk");
+  }
+
+ protected:
+  base::ScopedTempDir temp_dir_;
+  base::FilePath package_path_;
+};
+
+TEST_F(ApplicationArchiveTest, ReadsStoredAndDeflatedFiles) {
+  std::string big_content;
+  for (int i = 0; i < 10000; ++i)
+    big_content.append("var x = 42;\n");
+
+  ZipBuilder builder("CrWk some header data");
+  builder.AddFile("manifest.json", "{\"name\": \"test\"}", false);
+  builder.AddFile("scripts/main.js", big_content, true);
+  builder.AddFile("empty.txt", "", true);
+  builder.AddFile("../outside.txt", "evil", false);
+  ASSERT_TRUE(builder.Write(package_path_));
+
+  EXPECT_TRUE(ApplicationArchive::IsArchivePath(package_path_));
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(package_path_));
+
+  scoped_refptr<base::RefCountedMemory> data =
+      archive->GetFile(std::string("manifest.json"));
+  ASSERT_TRUE(data);
+  EXPECT_EQ("{\"name\": \"test\"}", ToString(data));
+
+  data = archive->GetFile(base::FilePath(FILE_PATH_LITERAL("scripts"))
+                          .Append(FILE_PATH_LITERAL("main.js")));
+  ASSERT_TRUE(data);
+  EXPECT_EQ(big_content, ToString(data));
+
+  // Served from the cache the second time.
+  scoped_refptr<base::RefCountedMemory> cached_data =
+      archive->GetFile(std::string("scripts/main.js"));
+  EXPECT_EQ(data.get(), cached_data.get());
+
+  data = archive->GetFile(std::string("empty.txt"));
+  ASSERT_TRUE(data);
+  EXPECT_EQ(0u, data->size());
+
+  EXPECT_FALSE(archive->GetFile(std::string("../outside.txt")));
+  EXPECT_FALSE(archive->GetFile(std::string("missing.txt")));
+}
+
+TEST_F(ApplicationArchiveTest, StoredFilesOutliveArchive) {
+  ZipBuilder builder("");
+  builder.AddFile("index.html", "<html></html>", false);
+  ASSERT_TRUE(builder.Write(package_path_));
+
+  scoped_refptr<base::RefCountedMemory> data;
+  {
+    scoped_refptr<ApplicationArchive> archive(
+        new ApplicationArchive(package_path_));
+    data = archive->GetFile(std::string("index.html"));
+  }
+  ASSERT_TRUE(data);
+  EXPECT_EQ("<html></html>", ToString(data));
+}
+
+TEST_F(ApplicationArchiveTest, InvalidUncompressedSize) {
+  ZipBuilder builder("");
+  builder.AddFileWithUncompressedSize("huge.js", "var x = 42;", true,
+                                      0xffffffff);
+  builder.AddFileWithUncompressedSize("ratio.js", "var x = 42;", true,
+                                      16 << 20);
+  ASSERT_TRUE(builder.Write(package_path_));
+
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(package_path_));
+  EXPECT_FALSE(archive->GetFile(std::string("huge.js")));
+  EXPECT_FALSE(archive->GetFile(std::string("ratio.js")));
+}
+
+TEST_F(ApplicationArchiveTest, InvalidPackage) {
+  const char kData[] = "this is not a zip file";
+  ASSERT_TRUE(file_util::WriteFile(package_path_, kData, sizeof(kData)));
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(package_path_));
+  EXPECT_FALSE(archive->GetFile(std::string("manifest.json")));
+
+  scoped_refptr<ApplicationArchive> missing_archive(
+      new ApplicationArchive(temp_dir_.path().AppendASCII("missing.xpk")));
+  EXPECT_FALSE(missing_archive->GetFile(std::string("manifest.json")));
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -11,6 +11,7 @@
 #include "base/files/file_path.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_string_value_serializer.h"
 #include "base/logging.h"
 #include "base/metrics/histogram.h"
 #include "base/path_service.h"
@@ -18,6 +19,7 @@
 #include "base/strings/utf_string_conversions.h"
 #include "base/threading/thread_restrictions.h"
 #include "xwalk/application/common/application.h"
+#include "xwalk/application/common/application_archive.h"
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/application_manifest_constants.h"
@@ -69,18 +71,44 @@ scoped_refptr<Application> LoadApplication(
   return application;
 }
 
+namespace {
+
+// Reads the manifest of an application installed without extracting its
+// package.
+Value* DeserializeManifestFromArchive(const base::FilePath& package_path,
+                                      std::string* error) {
+  scoped_refptr<ApplicationArchive> archive(
+      new ApplicationArchive(package_path));
+  scoped_refptr<base::RefCountedMemory> data =
+      archive->GetFile(base::FilePath(kManifestFilename));
+  if (!data)
+    return NULL;
+
+  std::string manifest(reinterpret_cast<const char*>(data->front()),
+                       data->size());
+  JSONStringValueSerializer serializer(&manifest);
+  return serializer.Deserialize(NULL, error);
+}
+
+}  // namespace
+
 DictionaryValue* LoadManifest(const base::FilePath& application_path,
                               std::string* error) {
-  base::FilePath manifest_path =
-      application_path.Append(kManifestFilename);
-  if (!base::PathExists(manifest_path)) {
-    *error = base::StringPrintf("%s",
-                                errors::kManifestUnreadable);
-    return NULL;
-  }
+  scoped_ptr<Value> root;
+  if (ApplicationArchive::IsArchivePath(application_path)) {
+    root.reset(DeserializeManifestFromArchive(application_path, error));
+  } else {
+    base::FilePath manifest_path =
+        application_path.Append(kManifestFilename);
+    if (!base::PathExists(manifest_path)) {
+      *error = base::StringPrintf("%s",
+                                  errors::kManifestUnreadable);
+      return NULL;
+    }
 
-  JSONFileValueSerializer serializer(manifest_path);
-  scoped_ptr<Value> root(serializer.Deserialize(NULL, error));
+    JSONFileValueSerializer serializer(manifest_path);
+    root.reset(serializer.Deserialize(NULL, error));
+  }
   if (!root.get()) {
     if (error->empty()) {
       // If |error| is empty, than the file could not be read.
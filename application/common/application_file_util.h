@@ -25,8 +25,10 @@ namespace application {
 
 class Application;
 
-// Loads and validates an application from the specified directory. Returns NULL
-// on failure, with a description of the error in |error|.
+// Loads and validates an application from the specified directory, or from
+// its package if it was installed without extracting it, see
+// ApplicationArchive. Returns NULL on failure, with a description of the
+// error in |error|.
 scoped_refptr<Application> LoadApplication(
     const base::FilePath& application_root,
     Manifest::SourceType source_type,
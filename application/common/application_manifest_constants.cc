@@ -21,6 +21,12 @@ const char kWebURLsKey[] = "app.urls";
 }  // namespace application_manifest_keys
 
 namespace application_manifest_errors {
+const char kInvalidAppMain[] =
+    "Invalid value for 'app.main'.";
+const char kInvalidAppMainScripts[] =
+    "Invalid value for 'app.main.scripts'. It must be a list of strings.";
+const char kInvalidAppMainSource[] =
+    "Invalid value for 'app.main.source'.";
 const char kInvalidDescription[] =
     "Invalid value for 'description'.";
 const char kInvalidKey[] =
@@ -22,6 +22,9 @@ namespace application_manifest_keys {
 }  // namespace application_manifest_keys
 
 namespace application_manifest_errors {
+  extern const char kInvalidAppMain[];
+  extern const char kInvalidAppMainScripts[];
+  extern const char kInvalidAppMainSource[];
   extern const char kInvalidDescription[];
   extern const char kInvalidKey[];
   extern const char kInvalidManifestVersion[];
@@ -0,0 +1,84 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_cache.h"
+
+#include "base/stl_util.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Enough for the resources of most applications, while bounding the memory
+// used by applications with many files.
+const size_t kMaxPathsPerApplication = 4096;
+
+base::LazyInstance<ApplicationResourceCache>::Leaky g_resource_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+ApplicationResourceCache* ApplicationResourceCache::GetInstance() {
+  return g_resource_cache.Pointer();
+}
+
+ApplicationResourceCache::ApplicationResourceCache()
+    : hits_(0),
+      misses_(0) {}
+
+ApplicationResourceCache::~ApplicationResourceCache() {
+  STLDeleteValues(&applications_);
+}
+
+bool ApplicationResourceCache::Lookup(const std::string& application_id,
+                                      const base::FilePath& relative_path,
+                                      base::FilePath* file_path) {
+  base::AutoLock l(lock_);
+  ApplicationMap::iterator it = applications_.find(application_id);
+  if (it != applications_.end()) {
+    PathCache::iterator path = it->second->Get(relative_path);
+    if (path != it->second->end()) {
+      hits_++;
+      *file_path = path->second;
+      return true;
+    }
+  }
+  misses_++;
+  return false;
+}
+
+void ApplicationResourceCache::Insert(const std::string& application_id,
+                                      const base::FilePath& relative_path,
+                                      const base::FilePath& file_path) {
+  DCHECK(!file_path.empty());
+  base::AutoLock l(lock_);
+  PathCache*& paths = applications_[application_id];
+  if (!paths)
+    paths = new PathCache(kMaxPathsPerApplication);
+  paths->Put(relative_path, file_path);
+}
+
+void ApplicationResourceCache::Invalidate(const std::string& application_id) {
+  base::AutoLock l(lock_);
+  ApplicationMap::iterator it = applications_.find(application_id);
+  if (it == applications_.end())
+    return;
+  delete it->second;
+  applications_.erase(it);
+}
+
+size_t ApplicationResourceCache::hits() const {
+  base::AutoLock l(lock_);
+  return hits_;
+}
+
+size_t ApplicationResourceCache::misses() const {
+  base::AutoLock l(lock_);
+  return misses_;
+}
+
+}  // namespace application
+}  // namespace xwalk
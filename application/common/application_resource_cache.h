@@ -0,0 +1,65 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+// Remembers, per application, the file path each relative resource path
+// resolved to with ApplicationResource::GetFilePath(), so resolving the
+// resources requested again doesn't need to touch the file system. Only
+// resources that were found are kept, so files added later are not missed.
+//
+// The entries of an application must be invalidated when its files change,
+// i.e. when it's installed again or uninstalled. Can be used from any thread.
+class ApplicationResourceCache {
+ public:
+  static ApplicationResourceCache* GetInstance();
+
+  // Returns false if |relative_path| wasn't resolved yet.
+  bool Lookup(const std::string& application_id,
+              const base::FilePath& relative_path,
+              base::FilePath* file_path);
+  void Insert(const std::string& application_id,
+              const base::FilePath& relative_path,
+              const base::FilePath& file_path);
+
+  void Invalidate(const std::string& application_id);
+
+  size_t hits() const;
+  size_t misses() const;
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<ApplicationResourceCache>;
+
+  ApplicationResourceCache();
+  ~ApplicationResourceCache();
+
+  typedef base::MRUCache<base::FilePath, base::FilePath> PathCache;
+  typedef std::map<std::string, PathCache*> ApplicationMap;
+
+  // Protects the members below.
+  mutable base::Lock lock_;
+  ApplicationMap applications_;
+  size_t hits_;
+  size_t misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_CACHE_H_
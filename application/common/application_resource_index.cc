@@ -0,0 +1,184 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_index.h"
+
+#include <cstdio>
+#include <string>
+
+#include "base/debug/trace_event.h"
+#include "base/file_util.h"
+#include "base/files/file_enumerator.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/strings/string_number_conversions.h"
+#include "crypto/secure_hash.h"
+#include "net/base/mime_util.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Version of the format of the saved index, indexes of other versions are
+// ignored.
+const int kIndexVersion = 1;
+
+// Bytes of the hash kept, enough to tell versions of a file apart.
+const size_t kHashSize = 16;
+
+const size_t kReadBufferSize = 64 * 1024;
+
+bool HashFile(const base::FilePath& path, std::string* hash) {
+  FILE* file = file_util::OpenFile(path, "rb");
+  if (!file)
+    return false;
+
+  scoped_ptr<crypto::SecureHash> secure_hash(
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256));
+  scoped_ptr<char[]> buffer(new char[kReadBufferSize]);
+  size_t bytes_read;
+  while ((bytes_read = fread(buffer.get(), 1, kReadBufferSize, file)) > 0)
+    secure_hash->Update(buffer.get(), bytes_read);
+  const bool success = !ferror(file);
+  file_util::CloseFile(file);
+  if (!success)
+    return false;
+
+  uint8 digest[kHashSize];
+  secure_hash->Finish(digest, sizeof(digest));
+  *hash = base::HexEncode(digest, sizeof(digest));
+  return true;
+}
+
+}  // namespace
+
+const base::FilePath::CharType ApplicationResourceIndex::kIndexExtension[] =
+    FILE_PATH_LITERAL(".index");
+
+ApplicationResourceIndex::Entry::Entry()
+    : size(0) {}
+
+// static
+base::FilePath ApplicationResourceIndex::GetIndexPath(
+    const base::FilePath& application_path) {
+  return application_path.AddExtension(kIndexExtension);
+}
+
+// static
+bool ApplicationResourceIndex::Create(const base::FilePath& application_path) {
+  TRACE_EVENT0("xwalk", "ApplicationResourceIndex::Create");
+  EntryMap entries;
+  if (!IndexFiles(application_path, &entries))
+    return false;
+
+  Pickle pickle;
+  pickle.WriteInt(kIndexVersion);
+  pickle.WriteUInt64(entries.size());
+  EntryMap::const_iterator it = entries.begin();
+  for (; it != entries.end(); ++it) {
+    const Entry& entry = it->second;
+    it->first.WriteToPickle(&pickle);
+    pickle.WriteInt64(entry.size);
+    pickle.WriteInt64(entry.last_modified.ToInternalValue());
+    pickle.WriteString(entry.hash);
+    pickle.WriteString(entry.mime_type);
+  }
+
+  const int size = static_cast<int>(pickle.size());
+  return file_util::WriteFile(GetIndexPath(application_path),
+                              static_cast<const char*>(pickle.data()),
+                              size) == size;
+}
+
+// static
+bool ApplicationResourceIndex::IndexFiles(
+    const base::FilePath& application_path, EntryMap* entries) {
+  base::FileEnumerator enumerator(application_path, true,
+                                  base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    base::FilePath relative_path;
+    if (!application_path.AppendRelativePath(path, &relative_path))
+      continue;
+
+    const base::FileEnumerator::FileInfo info = enumerator.GetInfo();
+    Entry entry;
+    entry.size = info.GetSize();
+    entry.last_modified = info.GetLastModifiedTime();
+    if (!HashFile(path, &entry.hash)) {
+      LOG(ERROR) << "Couldn't read " << path.value();
+      return false;
+    }
+    net::GetMimeTypeFromFile(path, &entry.mime_type);
+    (*entries)[relative_path.NormalizePathSeparators()] = entry;
+  }
+  return true;
+}
+
+ApplicationResourceIndex::ApplicationResourceIndex(
+    const base::FilePath& application_path)
+    : path_(GetIndexPath(application_path)),
+      loaded_(false) {}
+
+ApplicationResourceIndex::~ApplicationResourceIndex() {}
+
+void ApplicationResourceIndex::Load() {
+  base::AutoLock l(lock_);
+  if (loaded_)
+    return;
+  loaded_ = true;
+
+  std::string data;
+  if (!file_util::ReadFileToString(path_, &data))
+    return;
+
+  Pickle pickle(data.data(), data.size());
+  PickleIterator iter(pickle);
+  int version;
+  uint64 count;
+  if (!pickle.ReadInt(&iter, &version) || version != kIndexVersion ||
+      !pickle.ReadUInt64(&iter, &count)) {
+    LOG(WARNING) << "Ignoring invalid index " << path_.value();
+    return;
+  }
+
+  EntryMap entries;
+  for (uint64 i = 0; i < count; ++i) {
+    base::FilePath relative_path;
+    Entry entry;
+    int64 last_modified;
+    if (!relative_path.ReadFromPickle(&iter) ||
+        !pickle.ReadInt64(&iter, &entry.size) ||
+        !pickle.ReadInt64(&iter, &last_modified) ||
+        !pickle.ReadString(&iter, &entry.hash) ||
+        !pickle.ReadString(&iter, &entry.mime_type)) {
+      LOG(WARNING) << "Ignoring invalid index " << path_.value();
+      return;
+    }
+    entry.last_modified = base::Time::FromInternalValue(last_modified);
+    entries[relative_path] = entry;
+  }
+  entries_.swap(entries);
+}
+
+bool ApplicationResourceIndex::is_loaded() const {
+  base::AutoLock l(lock_);
+  return loaded_;
+}
+
+bool ApplicationResourceIndex::GetEntry(const base::FilePath& relative_path,
+                                        Entry* entry) const {
+  base::AutoLock l(lock_);
+  EntryMap::const_iterator it =
+      entries_.find(relative_path.NormalizePathSeparators());
+  if (it == entries_.end())
+    return false;
+  *entry = it->second;
+  return true;
+}
+
+}  // namespace application
+}  // namespace xwalk
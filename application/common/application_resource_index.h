@@ -0,0 +1,85 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
+#define XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
+
+#include <map>
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace application {
+
+// Size, modification time, hash and MIME type of every file of an installed
+// application, computed once when it's installed and saved next to it. The
+// app:// protocol handler uses it to send validators and lengths in its
+// responses, and to answer conditional and HEAD requests without opening the
+// files.
+//
+// Can be used from any thread, but Create() and Load() do IO, so they must not
+// be called from the UI or IO threads.
+class ApplicationResourceIndex
+    : public base::RefCountedThreadSafe<ApplicationResourceIndex> {
+ public:
+  struct Entry {
+    Entry();
+
+    int64 size;
+    base::Time last_modified;
+    // Hex encoded, truncated SHA-256 of the contents.
+    std::string hash;
+    std::string mime_type;
+  };
+
+  static const base::FilePath::CharType kIndexExtension[];
+
+  // Where the index of the application at |application_path| is saved.
+  static base::FilePath GetIndexPath(const base::FilePath& application_path);
+
+  // Indexes the files under |application_path| and saves the result at
+  // GetIndexPath(|application_path|).
+  static bool Create(const base::FilePath& application_path);
+
+  explicit ApplicationResourceIndex(const base::FilePath& application_path);
+
+  // Reads the saved index the first time it's called. Applications without
+  // an index, or with an invalid one, behave as if they had no files.
+  void Load();
+  bool is_loaded() const;
+
+  // Returns false if the index isn't loaded yet or has no such file.
+  bool GetEntry(const base::FilePath& relative_path, Entry* entry) const;
+
+  const base::FilePath& path() const { return path_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<ApplicationResourceIndex>;
+
+  typedef std::map<base::FilePath, Entry> EntryMap;
+
+  ~ApplicationResourceIndex();
+
+  static bool IndexFiles(const base::FilePath& application_path,
+                         EntryMap* entries);
+
+  const base::FilePath path_;
+
+  // Protects the members below. The entries don't change once loaded.
+  mutable base::Lock lock_;
+  bool loaded_;
+  EntryMap entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationResourceIndex);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_APPLICATION_RESOURCE_INDEX_H_
@@ -0,0 +1,114 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/application_resource_index.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+bool WriteString(const base::FilePath& path, const std::string& data) {
+  return file_util::WriteFile(path, data.data(), data.size()) ==
+      static_cast<int>(data.size());
+}
+
+}  // namespace
+
+class ApplicationResourceIndexTest : public testing::Test {
+ public:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    app_path_ = temp_dir_.path().AppendASCII("app");
+    ASSERT_TRUE(file_util::CreateDirectory(app_path_.AppendASCII("scripts")));
+    ASSERT_TRUE(WriteString(app_path_.AppendASCII("index.html"),
+                            "<html></html>"));
+    ASSERT_TRUE(WriteString(
+        app_path_.AppendASCII("scripts").AppendASCII("main.js"),
+        "var x = 42;"));
+  }
+
+ protected:
+  base::ScopedTempDir temp_dir_;
+  base::FilePath app_path_;
+};
+
+TEST_F(ApplicationResourceIndexTest, CreateAndLoad) {
+  ASSERT_TRUE(ApplicationResourceIndex::Create(app_path_));
+  EXPECT_TRUE(base::PathExists(
+      ApplicationResourceIndex::GetIndexPath(app_path_)));
+
+  scoped_refptr<ApplicationResourceIndex> index(
+      new ApplicationResourceIndex(app_path_));
+  ApplicationResourceIndex::Entry entry;
+  EXPECT_FALSE(index->is_loaded());
+  EXPECT_FALSE(index->GetEntry(base::FilePath(FILE_PATH_LITERAL("index.html")),
+                               &entry));
+
+  index->Load();
+  EXPECT_TRUE(index->is_loaded());
+  ASSERT_TRUE(index->GetEntry(base::FilePath(FILE_PATH_LITERAL("index.html")),
+                              &entry));
+  EXPECT_EQ(13, entry.size);
+  EXPECT_EQ("text/html", entry.mime_type);
+  EXPECT_EQ(32u, entry.hash.size());
+  EXPECT_FALSE(entry.last_modified.is_null());
+  const std::string index_hash = entry.hash;
+
+  ASSERT_TRUE(index->GetEntry(
+      base::FilePath(FILE_PATH_LITERAL("scripts/main.js")), &entry));
+  EXPECT_EQ(11, entry.size);
+  EXPECT_NE(index_hash, entry.hash);
+
+  EXPECT_FALSE(index->GetEntry(
+      base::FilePath(FILE_PATH_LITERAL("missing.html")), &entry));
+}
+
+TEST_F(ApplicationResourceIndexTest, HashChangesWithContents) {
+  ASSERT_TRUE(ApplicationResourceIndex::Create(app_path_));
+  scoped_refptr<ApplicationResourceIndex> index(
+      new ApplicationResourceIndex(app_path_));
+  index->Load();
+  ApplicationResourceIndex::Entry entry;
+  const base::FilePath relative_path(FILE_PATH_LITERAL("index.html"));
+  ASSERT_TRUE(index->GetEntry(relative_path, &entry));
+
+  ASSERT_TRUE(WriteString(app_path_.AppendASCII("index.html"),
+                          "<html><body></body></html>"));
+  ASSERT_TRUE(ApplicationResourceIndex::Create(app_path_));
+  scoped_refptr<ApplicationResourceIndex> new_index(
+      new ApplicationResourceIndex(app_path_));
+  new_index->Load();
+  ApplicationResourceIndex::Entry new_entry;
+  ASSERT_TRUE(new_index->GetEntry(relative_path, &new_entry));
+  EXPECT_NE(entry.hash, new_entry.hash);
+  EXPECT_EQ(26, new_entry.size);
+}
+
+TEST_F(ApplicationResourceIndexTest, MissingOrInvalidIndex) {
+  scoped_refptr<ApplicationResourceIndex> index(
+      new ApplicationResourceIndex(app_path_));
+  index->Load();
+  EXPECT_TRUE(index->is_loaded());
+  ApplicationResourceIndex::Entry entry;
+  EXPECT_FALSE(index->GetEntry(base::FilePath(FILE_PATH_LITERAL("index.html")),
+                               &entry));
+
+  ASSERT_TRUE(WriteString(ApplicationResourceIndex::GetIndexPath(app_path_),
+                          "not an index"));
+  scoped_refptr<ApplicationResourceIndex> invalid_index(
+      new ApplicationResourceIndex(app_path_));
+  invalid_index->Load();
+  EXPECT_FALSE(invalid_index->GetEntry(
+      base::FilePath(FILE_PATH_LITERAL("index.html")), &entry));
+}
+
+}  // namespace application
+}  // namespace xwalk
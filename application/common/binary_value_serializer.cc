@@ -0,0 +1,221 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/binary_value_serializer.h"
+
+#include <cstring>
+
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+
+namespace xwalk {
+namespace application {
+
+const int BinaryValueSerializer::kFormatVersion = 1;
+
+namespace {
+
+// Manifests are only a few levels deep, this protects the reader from
+// corrupted data.
+const int kMaxNestingDepth = 100;
+
+const char* const kErrorMessages[] = {
+  "",
+  "Invalid pickle.",
+  "Unsupported format version.",
+  "Invalid value.",
+  "Too much nesting.",
+};
+
+bool WriteValue(const base::Value& value, int depth, Pickle* pickle) {
+  if (depth > kMaxNestingDepth)
+    return false;
+
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool val;
+      value.GetAsBoolean(&val);
+      return pickle->WriteBool(val);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int val;
+      value.GetAsInteger(&val);
+      return pickle->WriteInt(val);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double val;
+      value.GetAsDouble(&val);
+      return pickle->WriteData(reinterpret_cast<const char*>(&val),
+                               sizeof(val));
+    }
+    case base::Value::TYPE_STRING: {
+      std::string val;
+      value.GetAsString(&val);
+      return pickle->WriteString(val);
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue& binary =
+          static_cast<const base::BinaryValue&>(value);
+      return pickle->WriteData(binary.GetBuffer(),
+                               static_cast<int>(binary.GetSize()));
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue& dict =
+          static_cast<const base::DictionaryValue&>(value);
+      pickle->WriteInt(static_cast<int>(dict.size()));
+      for (base::DictionaryValue::Iterator it(dict); !it.IsAtEnd();
+           it.Advance()) {
+        if (!pickle->WriteString(it.key()) ||
+            !WriteValue(it.value(), depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue& list = static_cast<const base::ListValue&>(value);
+      pickle->WriteInt(static_cast<int>(list.GetSize()));
+      for (base::ListValue::const_iterator it = list.begin();
+           it != list.end(); ++it) {
+        if (!WriteValue(**it, depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+  }
+  NOTREACHED();
+  return false;
+}
+
+base::Value* ReadValue(PickleIterator* iter, int depth,
+                       BinaryValueSerializer::ErrorCode* error) {
+  if (depth > kMaxNestingDepth) {
+    *error = BinaryValueSerializer::BINARY_TOO_MUCH_NESTING;
+    return NULL;
+  }
+
+  *error = BinaryValueSerializer::BINARY_INVALID_VALUE;
+  int type;
+  if (!iter->ReadInt(&type))
+    return NULL;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool val;
+      if (!iter->ReadBool(&val))
+        return NULL;
+      return new base::FundamentalValue(val);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int val;
+      if (!iter->ReadInt(&val))
+        return NULL;
+      return new base::FundamentalValue(val);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length) || length != sizeof(double))
+        return NULL;
+      double val;
+      memcpy(&val, data, sizeof(val));
+      return new base::FundamentalValue(val);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string val;
+      if (!iter->ReadString(&val))
+        return NULL;
+      return new base::StringValue(val);
+    }
+    case base::Value::TYPE_BINARY: {
+      const char* data;
+      int length;
+      if (!iter->ReadData(&data, &length))
+        return NULL;
+      return base::BinaryValue::CreateWithCopiedBuffer(data, length);
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return NULL;
+      scoped_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (int i = 0; i < size; ++i) {
+        std::string key;
+        if (!iter->ReadString(&key))
+          return NULL;
+        base::Value* value = ReadValue(iter, depth + 1, error);
+        if (!value)
+          return NULL;
+        dict->SetWithoutPathExpansion(key, value);
+      }
+      return dict.release();
+    }
+    case base::Value::TYPE_LIST: {
+      int size;
+      if (!iter->ReadLength(&size))
+        return NULL;
+      scoped_ptr<base::ListValue> list(new base::ListValue);
+      for (int i = 0; i < size; ++i) {
+        base::Value* value = ReadValue(iter, depth + 1, error);
+        if (!value)
+          return NULL;
+        list->Append(value);
+      }
+      return list.release();
+    }
+  }
+  return NULL;
+}
+
+}  // namespace
+
+BinaryValueSerializer::BinaryValueSerializer(std::string* data)
+    : data_(data) {}
+
+BinaryValueSerializer::~BinaryValueSerializer() {}
+
+bool BinaryValueSerializer::Serialize(const base::Value& root) {
+  Pickle pickle;
+  pickle.WriteInt(kFormatVersion);
+  if (!WriteValue(root, 0, &pickle))
+    return false;
+  data_->assign(static_cast<const char*>(pickle.data()), pickle.size());
+  return true;
+}
+
+base::Value* BinaryValueSerializer::Deserialize(int* error_code,
+                                                std::string* error_str) {
+  ErrorCode error = BINARY_NO_ERROR;
+  scoped_ptr<base::Value> value;
+
+  Pickle pickle(data_->data(), static_cast<int>(data_->size()));
+  PickleIterator iter(pickle);
+  int version;
+  if (!pickle.data() || !iter.ReadInt(&version))
+    error = BINARY_INVALID_PICKLE;
+  else if (version != kFormatVersion)
+    error = BINARY_UNSUPPORTED_VERSION;
+  else
+    value.reset(ReadValue(&iter, 0, &error));
+
+  if (value) {
+    error = BINARY_NO_ERROR;
+  } else if (error == BINARY_NO_ERROR) {
+    error = BINARY_INVALID_VALUE;
+  }
+
+  if (error_code)
+    *error_code = error;
+  if (error_str)
+    *error_str = kErrorMessages[error];
+  return value.release();
+}
+
+}  // namespace application
+}  // namespace xwalk
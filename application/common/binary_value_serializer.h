@@ -0,0 +1,54 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
+#define XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
+
+#include <string>
+
+#include "base/basictypes.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace application {
+
+// Serializes a base::Value to a Pickle, which is smaller than JSON and much
+// cheaper to read back: there is no text to parse, strings are copied as
+// they are and numbers keep their binary representation. Used to store the
+// manifests in the applications DB.
+//
+// The format isn't meant to be read by other programs, but it's stored on
+// disk, so any change must bump kFormatVersion.
+class BinaryValueSerializer : public base::ValueSerializer {
+ public:
+  enum ErrorCode {
+    BINARY_NO_ERROR = 0,
+    BINARY_INVALID_PICKLE,
+    BINARY_UNSUPPORTED_VERSION,
+    BINARY_INVALID_VALUE,
+    BINARY_TOO_MUCH_NESTING,
+  };
+
+  static const int kFormatVersion;
+
+  // |data| is where the value is written to by Serialize(), and read from
+  // by Deserialize(). Must outlive the serializer.
+  explicit BinaryValueSerializer(std::string* data);
+  virtual ~BinaryValueSerializer();
+
+  // base::ValueSerializer implementation.
+  virtual bool Serialize(const base::Value& root) OVERRIDE;
+  virtual base::Value* Deserialize(int* error_code,
+                                   std::string* error_str) OVERRIDE;
+
+ private:
+  std::string* data_;
+
+  DISALLOW_COPY_AND_ASSIGN(BinaryValueSerializer);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_BINARY_VALUE_SERIALIZER_H_
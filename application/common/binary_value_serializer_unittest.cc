@@ -0,0 +1,125 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/binary_value_serializer.h"
+
+#include "base/json/json_string_value_serializer.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/pickle.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// Looks like the manifest of a packaged application.
+base::DictionaryValue* CreateManifest() {
+  base::DictionaryValue* manifest = new base::DictionaryValue;
+  manifest->SetString("name", "Test Application");
+  manifest->SetString("version", "1.0.42");
+  manifest->SetString("description", "An application with a long enough "
+                      "description to look like a real one.");
+  manifest->SetString("app.launch.local_path", "index.html");
+  manifest->SetInteger("manifest_version", 1);
+  manifest->SetBoolean("offline_enabled", true);
+  manifest->SetDouble("scale", 1.5);
+  base::ListValue* permissions = new base::ListValue;
+  for (int i = 0; i < 10; ++i)
+    permissions->AppendString(base::StringPrintf("permission%d", i));
+  manifest->Set("permissions", permissions);
+  base::DictionaryValue* icons = new base::DictionaryValue;
+  icons->SetString("16", "icons/icon16.png");
+  icons->SetString("48", "icons/icon48.png");
+  icons->SetString("128", "icons/icon128.png");
+  manifest->Set("icons", icons);
+  return manifest;
+}
+
+}  // namespace
+
+TEST(BinaryValueSerializerTest, RoundTrip) {
+  scoped_ptr<base::DictionaryValue> value(CreateManifest());
+  value->Set("null", base::Value::CreateNullValue());
+  value->Set("binary", base::BinaryValue::CreateWithCopiedBuffer("a\0b", 3));
+  value->SetWithoutPathExpansion("key.with.dots", new base::ListValue);
+
+  std::string data;
+  BinaryValueSerializer serializer(&data);
+  ASSERT_TRUE(serializer.Serialize(*value));
+
+  int error_code;
+  std::string error;
+  scoped_ptr<base::Value> result(serializer.Deserialize(&error_code, &error));
+  ASSERT_TRUE(result);
+  EXPECT_EQ(BinaryValueSerializer::BINARY_NO_ERROR, error_code);
+  EXPECT_TRUE(error.empty());
+  EXPECT_TRUE(value->Equals(result.get()));
+}
+
+TEST(BinaryValueSerializerTest, InvalidData) {
+  std::string data("not a pickle");
+  BinaryValueSerializer serializer(&data);
+  int error_code;
+  std::string error;
+  EXPECT_FALSE(serializer.Deserialize(&error_code, &error));
+  EXPECT_EQ(BinaryValueSerializer::BINARY_INVALID_PICKLE, error_code);
+  EXPECT_FALSE(error.empty());
+
+  // Truncating the value breaks the pickle.
+  scoped_ptr<base::DictionaryValue> value(CreateManifest());
+  ASSERT_TRUE(serializer.Serialize(*value));
+  data.resize(data.size() / 2);
+  EXPECT_FALSE(serializer.Deserialize(&error_code, &error));
+}
+
+TEST(BinaryValueSerializerTest, UnsupportedVersion) {
+  Pickle pickle;
+  pickle.WriteInt(BinaryValueSerializer::kFormatVersion + 1);
+  pickle.WriteInt(base::Value::TYPE_NULL);
+  std::string data(static_cast<const char*>(pickle.data()), pickle.size());
+
+  BinaryValueSerializer serializer(&data);
+  int error_code;
+  EXPECT_FALSE(serializer.Deserialize(&error_code, NULL));
+  EXPECT_EQ(BinaryValueSerializer::BINARY_UNSUPPORTED_VERSION, error_code);
+}
+
+TEST(BinaryValueSerializerTest, CompareWithJSON) {
+  const int kIterations = 5000;
+  scoped_ptr<base::DictionaryValue> manifest(CreateManifest());
+
+  std::string json_data;
+  JSONStringValueSerializer json_serializer(&json_data);
+  ASSERT_TRUE(json_serializer.Serialize(*manifest));
+  std::string binary_data;
+  BinaryValueSerializer binary_serializer(&binary_data);
+  ASSERT_TRUE(binary_serializer.Serialize(*manifest));
+
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<base::Value> value(json_serializer.Deserialize(NULL, NULL));
+    ASSERT_TRUE(value);
+  }
+  const base::TimeDelta json_time = base::TimeTicks::Now() - start_time;
+
+  start_time = base::TimeTicks::Now();
+  for (int i = 0; i < kIterations; ++i) {
+    scoped_ptr<base::Value> value(binary_serializer.Deserialize(NULL, NULL));
+    ASSERT_TRUE(value);
+  }
+  const base::TimeDelta binary_time = base::TimeTicks::Now() - start_time;
+
+  LOG(INFO) << "Manifest size: " << json_data.size() << " bytes as JSON, "
+            << binary_data.size() << " bytes as binary. Reading it "
+            << kIterations << " times: "
+            << json_time.InMilliseconds() << "ms from JSON, "
+            << binary_time.InMilliseconds() << "ms from binary.";
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -7,7 +7,9 @@
 namespace xwalk {
 namespace application {
 
-DBStore::DBStore(base::FilePath path) : data_path_(path) {
+DBStore::DBStore(base::FilePath path)
+    : load_on_demand_(false),
+      data_path_(path) {
 }
 
 DBStore::~DBStore() {
@@ -5,6 +5,7 @@
 #ifndef XWALK_APPLICATION_COMMON_DB_STORE_H_
 #define XWALK_APPLICATION_COMMON_DB_STORE_H_
 
+#include <set>
 #include <string>
 
 #include "base/memory/scoped_ptr.h"
@@ -34,8 +35,33 @@ class DBStore {
   virtual bool Insert(const Application* application,
                       const base::Time install_time) = 0;
   virtual bool Remove(const std::string& key) = 0;
+
+  // The applications read from the database. When loading on demand, only
+  // the ones asked for with GetApplicationValue().
   const base::DictionaryValue* GetApplications() const { return db_.get(); }
 
+  // The ids of all the applications in the database, read or not.
+  const std::set<std::string>& GetApplicationIDs() const {
+    return application_ids_;
+  }
+  bool HasApplication(const std::string& id) const {
+    return application_ids_.find(id) != application_ids_.end();
+  }
+
+  // Returns the value stored for the application |id|, reading it from the
+  // database the first time when loading on demand. Returns NULL if there's
+  // no such application.
+  virtual const base::DictionaryValue* GetApplicationValue(
+      const std::string& id) = 0;
+
+  // By default InitDB() reads all the applications. When loading on demand it
+  // only reads their ids, so the cost of starting doesn't grow with the
+  // number of installed applications. Must be set before InitDB().
+  void set_load_on_demand(bool load_on_demand) {
+    load_on_demand_ = load_on_demand;
+  }
+  bool load_on_demand() const { return load_on_demand_; }
+
   void AddObserver(DBStore::Observer* observer) {
     observers_.AddObserver(observer);
   }
@@ -51,8 +77,16 @@ class DBStore {
   // each observer.
   virtual void SetValue(const std::string& key, base::Value* value) = 0;
 
+  // Sets the value of each key in |values|, writing them all to the database
+  // in a single transaction, which is much faster than calling SetValue()
+  // for each of them. Keys are not expanded, so use SetWithoutPathExpansion()
+  // for keys like "<id>.path".
+  virtual bool SetValues(scoped_ptr<base::DictionaryValue> values) = 0;
+
  protected:
   scoped_ptr<base::DictionaryValue> db_;
+  std::set<std::string> application_ids_;
+  bool load_on_demand_;
   base::FilePath data_path_;
   ObserverList<DBStore::Observer, true> observers_;
 };
@@ -4,12 +4,16 @@
 
 #include "xwalk/application/common/db_store_sqlite_impl.h"
 
+#include <utility>
+#include <vector>
+
 #include "base/file_util.h"
 #include "base/json/json_file_value_serializer.h"
 #include "base/json/json_string_value_serializer.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
 #include "xwalk/application/browser/application_store.h"
+#include "xwalk/application/common/binary_value_serializer.h"
 
 namespace xwalk {
 namespace application {
@@ -19,7 +23,10 @@ const base::FilePath::CharType DBStoreSqliteImpl::kDBFileName[] =
 
 // Switching the JSON format DB(version 0) to SQLite backend version 1,
 // should migrate all data from JSON DB to SQLite applications table.
-static const int kVersionNumber = 1;
+// Version 2 stores the manifests with BinaryValueSerializer instead of JSON,
+// which version 1 can't read.
+static const int kVersionNumber = 2;
+static const int kCompatibleVersionNumber = 2;
 
 namespace {
 
@@ -45,7 +52,7 @@ bool InitApplicationsTable(sql::Connection* db) {
   if (!db->DoesTableExist("applications")) {
     if (!db->Execute("CREATE TABLE applications ("
                      "id TEXT NOT NULL UNIQUE PRIMARY KEY,"
-                     "manifest TEXT NOT NULL,"
+                     "manifest BLOB NOT NULL,"
                      "path TEXT NOT NULL,"
                      "install_time REAL)"))
       return false;
@@ -54,6 +61,31 @@ bool InitApplicationsTable(sql::Connection* db) {
   return true;
 }
 
+// Creates the value of an application from the manifest, path and
+// install_time columns of |smt|, starting at |first_column|.
+base::DictionaryValue* CreateApplicationValue(const sql::Statement& smt,
+                                              int first_column) {
+  int error_code;
+  std::string error_msg;
+  std::string manifest_str;
+  smt.ColumnBlobAsString(first_column, &manifest_str);
+  BinaryValueSerializer serializer(&manifest_str);
+  base::Value* manifest = serializer.Deserialize(&error_code, &error_msg);
+  if (manifest == NULL) {
+    LOG(ERROR) << "An error occured when deserializing the manifest, "
+                  "the error message is: "
+               << error_msg;
+    return NULL;
+  }
+  std::string path = smt.ColumnString(first_column + 1);
+  double install_time = smt.ColumnDouble(first_column + 2);
+  base::DictionaryValue* value = new base::DictionaryValue;
+  value->Set(ApplicationStore::kManifestPath, manifest);
+  value->SetString(ApplicationStore::kApplicationPath, path);
+  value->SetDouble(ApplicationStore::kInstallTime, install_time);
+  return value;
+}
+
 }  // namespace
 
 DBStoreSqliteImpl::DBStoreSqliteImpl(const base::FilePath& path)
@@ -72,21 +104,44 @@ DBStoreSqliteImpl::DBStoreSqliteImpl(const base::FilePath& path)
     return;
   }
 
+  // With write-ahead logging a commit appends to the log instead of writing
+  // the database file and a rollback journal, and reading doesn't block on
+  // writing. Not on Tizen, where the package installer hands the DB and its
+  // rollback journal over to the user running the applications. The mode is
+  // stored in the DB, so it's set back there for DBs already using the log.
+#if defined(OS_TIZEN)
+  if (!sqlite_db_->Execute("PRAGMA journal_mode=DELETE"))
+    LOG(WARNING) << "Unable to use a rollback journal for the DB.";
+#else
+  if (!sqlite_db_->Execute("PRAGMA journal_mode=WAL"))
+    LOG(WARNING) << "Unable to enable write-ahead logging for the DB.";
+#endif
+
   sql::Transaction transaction(sqlite_db_.get());
   transaction.Begin();
 
-  if (!meta_table_.Init(sqlite_db_.get(), kVersionNumber, kVersionNumber) ||
-      meta_table_.GetVersionNumber() != kVersionNumber) {
+  if (!meta_table_.Init(sqlite_db_.get(), kVersionNumber,
+                        kCompatibleVersionNumber)) {
     LOG(ERROR) << "Unable to init the META table.";
     return;
   }
 
+  if (meta_table_.GetCompatibleVersionNumber() > kVersionNumber) {
+    LOG(ERROR) << "The applications DB is too new.";
+    return;
+  }
+
   if (!InitApplicationsTable(sqlite_db_.get())) {
     LOG(ERROR) << "Unable to open applications table.";
     sqlite_db_.reset();
     return;
   }
 
+  if (meta_table_.GetVersionNumber() < 2 && !UpgradeToVersion2()) {
+    LOG(ERROR) << "Unable to migrate the manifests to the binary format.";
+    return;
+  }
+
   base::FilePath v0_file = path.Append(FILE_PATH_LITERAL("applications_db"));
   if (base::PathExists(v0_file) &&
       !does_db_exist) {
@@ -130,11 +185,61 @@ bool DBStoreSqliteImpl::UpgradeToVersion1(const base::FilePath& v0_file) {
     if (!SetApplication(it.key(), value.get()))
       return false;
   }
-  meta_table_.SetVersionNumber(1);
 
   return true;
 }
 
+bool DBStoreSqliteImpl::UpgradeToVersion2() {
+  // Reads all the manifests before updating them, updating the rows being
+  // read by a statement isn't safe.
+  std::vector<std::pair<std::string, std::string> > manifests;
+  sql::Statement select_smt(sqlite_db_->GetUniqueStatement(
+      "SELECT id, manifest FROM applications"));
+  if (!select_smt.is_valid())
+    return false;
+  while (select_smt.Step()) {
+    manifests.push_back(std::make_pair(select_smt.ColumnString(0),
+                                       select_smt.ColumnString(1)));
+  }
+  if (!select_smt.Succeeded())
+    return false;
+
+  sql::Statement update_smt(sqlite_db_->GetUniqueStatement(
+      "UPDATE applications SET manifest = ? WHERE id = ?"));
+  if (!update_smt.is_valid())
+    return false;
+
+  for (size_t i = 0; i < manifests.size(); ++i) {
+    const std::string& id = manifests[i].first;
+    JSONStringValueSerializer json_serializer(&manifests[i].second);
+    int error_code;
+    std::string error_msg;
+    scoped_ptr<base::Value> manifest(
+        json_serializer.Deserialize(&error_code, &error_msg));
+    if (!manifest) {
+      LOG(ERROR) << "Unable to read the manifest of " << id
+                 << ", the error message is: " << error_msg;
+      return false;
+    }
+
+    std::string manifest_data;
+    BinaryValueSerializer serializer(&manifest_data);
+    if (!serializer.Serialize(*manifest))
+      return false;
+
+    update_smt.Reset(true);
+    update_smt.BindBlob(0, manifest_data.data(),
+                        static_cast<int>(manifest_data.size()));
+    update_smt.BindString(1, id);
+    if (!update_smt.Run())
+      return false;
+  }
+
+  meta_table_.SetVersionNumber(2);
+  meta_table_.SetCompatibleVersionNumber(2);
+  return true;
+}
+
 DBStoreSqliteImpl::~DBStoreSqliteImpl() {
   if (sqlite_db_.get())
     sqlite_db_.reset();
@@ -151,32 +256,32 @@ bool DBStoreSqliteImpl::InitDB() {
 
 bool DBStoreSqliteImpl::UpdateDBCache() {
   if (sqlite_db_.get() && sqlite_db_->is_open()) {
-    // Read all installed appliations information to db memory cache.
     db_.reset(new base::DictionaryValue);
+    application_ids_.clear();
+
+    // When loading on demand only the ids are read, the manifests are parsed
+    // in GetApplicationValue().
+    if (load_on_demand_) {
+      sql::Statement smt(sqlite_db_->GetUniqueStatement(
+          "SELECT id FROM applications"));
+      if (!smt.is_valid())
+        return false;
+      while (smt.Step())
+        application_ids_.insert(smt.ColumnString(0));
+      return smt.Succeeded();
+    }
+
+    // Read all installed appliations information to db memory cache.
     sql::Statement smt(sqlite_db_->GetUniqueStatement(
         "SELECT id, manifest, path, install_time FROM applications"));
     if (smt.is_valid()) {
-      std::string error_msg;
       while (smt.Step()) {
         std::string application_id = smt.ColumnString(0);
-
-        int error_code;
-        std::string manifest_str = smt.ColumnString(1);
-        JSONStringValueSerializer serializer(&manifest_str);
-        base::Value* manifest = serializer.Deserialize(&error_code, &error_msg);
-        if (manifest == NULL) {
-          LOG(ERROR) << "An error occured when deserializing the manifest, "
-                        "the error message is: "
-                     << error_msg;
+        base::DictionaryValue* value = CreateApplicationValue(smt, 1);
+        if (!value)
           return false;
-        }
-        std::string path = smt.ColumnString(2);
-        double install_time = smt.ColumnDouble(3);
-        base::DictionaryValue* value = new base::DictionaryValue;
-        value->Set(ApplicationStore::kManifestPath, manifest);
-        value->SetString(ApplicationStore::kApplicationPath, path);
-        value->SetDouble(ApplicationStore::kInstallTime, install_time);
         db_->Set(application_id, value);
+        application_ids_.insert(application_id);
       }
       return true;
     }
@@ -184,13 +289,42 @@ bool DBStoreSqliteImpl::UpdateDBCache() {
   return false;
 }
 
+const base::DictionaryValue* DBStoreSqliteImpl::GetApplicationValue(
+    const std::string& id) {
+  if (!db_initialized_ || !HasApplication(id))
+    return NULL;
+
+  base::DictionaryValue* value = NULL;
+  if (db_->GetDictionary(id, &value))
+    return value;
+
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
+      "SELECT manifest, path, install_time FROM applications WHERE id = ?"));
+  if (!smt.is_valid()) {
+    LOG(ERROR) << "Unable to read application info from DB.";
+    return NULL;
+  }
+  smt.BindString(0, id);
+  if (!smt.Step()) {
+    LOG(ERROR) << "Application " << id << " is missing from DB.";
+    return NULL;
+  }
+
+  value = CreateApplicationValue(smt, 0);
+  if (!value)
+    return NULL;
+  db_->Set(id, value);
+  return value;
+}
+
 bool DBStoreSqliteImpl::Insert(const Application* application,
                                const base::Time install_time) {
   if (!db_initialized_)
     return false;
 
   std::string application_id = application->ID();
-  if (!db_->HasKey(application_id)) {
+  if (!HasApplication(application_id)) {
     base::DictionaryValue* manifest =
         application->GetManifest()->value()->DeepCopy();
     scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
@@ -207,41 +341,130 @@ bool DBStoreSqliteImpl::Remove(const std::string& key) {
   if (!db_initialized_)
     return false;
 
-  if (!db_->HasKey(key)) {
+  if (!HasApplication(key)) {
     LOG(ERROR) << "Database key " << key << " is invalid.";
     return false;
   }
 
-  if (!db_->Remove(key, NULL)) {
+  // When loading on demand, the application may not be in the cache.
+  if (db_->HasKey(key) && !db_->Remove(key, NULL)) {
     LOG(ERROR) << "Cannot remove the record " << key
                << " from database cache.";
     return false;
   }
+  application_ids_.erase(key);
   ReportValueChanged(key, NULL);
   return Commit(key, "", NULL, ACTION_DELETE);
 }
 
 void DBStoreSqliteImpl::SetValue(const std::string& key, base::Value* value) {
-  if (!db_initialized_)
+  if (!db_initialized_) {
+    delete value;
     return;
+  }
+
+  CacheChanges changes;
+  if (UpdateValue(key, value, &changes))
+    ReportChanges(changes);
+  else
+    RevertChanges(changes);
+}
+
+bool DBStoreSqliteImpl::SetValues(scoped_ptr<base::DictionaryValue> values) {
+  if (!db_initialized_)
+    return false;
+
+  std::vector<std::string> keys;
+  for (base::DictionaryValue::Iterator it(*values); !it.IsAtEnd();
+       it.Advance())
+    keys.push_back(it.key());
+
+  sql::Transaction transaction(sqlite_db_.get());
+  if (!transaction.Begin())
+    return false;
+
+  // The transaction is rolled back when one of the values can't be set, and
+  // then none of the changes is kept in the cache.
+  CacheChanges changes;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    scoped_ptr<base::Value> value;
+    values->RemoveWithoutPathExpansion(keys[i], &value);
+    if (!UpdateValue(keys[i], value.release(), &changes)) {
+      LOG(ERROR) << "Unable to set the value of " << keys[i] << " in DB.";
+      RevertChanges(changes);
+      return false;
+    }
+  }
+
+  if (!transaction.Commit()) {
+    RevertChanges(changes);
+    return false;
+  }
 
+  ReportChanges(changes);
+  return true;
+}
+
+bool DBStoreSqliteImpl::UpdateValue(const std::string& key,
+                                    base::Value* value,
+                                    CacheChanges* changes) {
   std::string current_path(key);
   size_t delimiter_position = current_path.find('.');
   std::string application_id(current_path, 0, delimiter_position);
 
+  // Reads the current value of the application, so the change is committed
+  // as an update.
+  if (load_on_demand_)
+    GetApplicationValue(application_id);
+
   scoped_ptr<base::Value> new_value(value);
   base::Value* old_value = NULL;
   db_->Get(key, &old_value);
   if (!old_value || !value->Equals(old_value)) {
-    base::Value* changed_value = new_value.release();
-    db_->Set(key, changed_value);
-    ReportValueChanged(key, changed_value);
     // Update the record in sqlite database.
     std::string column;
     if (delimiter_position != std::string::npos)
       column = std::string(current_path, delimiter_position+1);
     Action action = !!old_value? ACTION_UPDATE:ACTION_INSERT;
-    Commit(application_id, column, changed_value, action);
+
+    // The later values of a batch may depend on this one, so the cache is
+    // updated right away.
+    CacheChange change;
+    change.key = key;
+    if (old_value)
+      change.old_value.reset(old_value->DeepCopy());
+    change.added_application = action == ACTION_INSERT && column.empty() &&
+        application_ids_.insert(application_id).second;
+    changes->push_back(change);
+
+    base::Value* changed_value = new_value.release();
+    db_->Set(key, changed_value);
+    return Commit(application_id, column, changed_value, action);
+  }
+  return true;
+}
+
+void DBStoreSqliteImpl::ReportChanges(const CacheChanges& changes) {
+  for (CacheChanges::const_iterator it = changes.begin();
+       it != changes.end(); ++it) {
+    base::Value* value = NULL;
+    db_->Get(it->key, &value);
+    ReportValueChanged(it->key, value);
+  }
+}
+
+void DBStoreSqliteImpl::RevertChanges(const CacheChanges& changes) {
+  for (CacheChanges::const_reverse_iterator it = changes.rbegin();
+       it != changes.rend(); ++it) {
+    if (it->old_value)
+      db_->Set(it->key, it->old_value->DeepCopy());
+    else
+      db_->Remove(it->key, NULL);
+
+    if (it->added_application) {
+      std::string application_id(it->key, 0, it->key.find('.'));
+      application_ids_.erase(application_id);
+    }
   }
 }
 
@@ -253,7 +476,7 @@ bool DBStoreSqliteImpl::SetApplication(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
+  BinaryValueSerializer serializer(&manifest);
   base::Value* manifest_value;
   if (!static_cast<base::DictionaryValue*>(value)->Get(
           ApplicationStore::kManifestPath, &manifest_value) ||
@@ -276,18 +499,15 @@ bool DBStoreSqliteImpl::SetApplication(
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "INSERT INTO applications (manifest, path, install_time, id) "
       "VALUES (?,?,?,?)"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to insert application info into DB.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), static_cast<int>(manifest.size()));
   smt.BindString(1, path);
   smt.BindDouble(2, install_time);
   smt.BindString(3, id);
@@ -296,7 +516,7 @@ bool DBStoreSqliteImpl::SetApplication(
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::UpdateApplication(
@@ -307,7 +527,7 @@ bool DBStoreSqliteImpl::UpdateApplication(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
+  BinaryValueSerializer serializer(&manifest);
   base::Value* manifest_value;
   if (!static_cast<base::DictionaryValue*>(value)->Get(
           ApplicationStore::kManifestPath, &manifest_value) ||
@@ -330,18 +550,15 @@ bool DBStoreSqliteImpl::UpdateApplication(
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "UPDATE applications SET manifest = ?, path = ?, "
       "install_time = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update application info in DB.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), static_cast<int>(manifest.size()));
   smt.BindString(1, path);
   smt.BindDouble(2, install_time);
   smt.BindString(3, id);
@@ -350,15 +567,12 @@ bool DBStoreSqliteImpl::UpdateApplication(
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::DeleteApplication(const std::string& id) {
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "DELETE FROM applications WHERE id = ?"));
   smt.BindString(0, id);
   if (!smt.Run()) {
@@ -367,7 +581,7 @@ bool DBStoreSqliteImpl::DeleteApplication(const std::string& id) {
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::SetManifestValue(
@@ -378,23 +592,20 @@ bool DBStoreSqliteImpl::SetManifestValue(
   }
 
   std::string manifest;
-  JSONStringValueSerializer serializer(&manifest);
+  BinaryValueSerializer serializer(&manifest);
   if (!serializer.Serialize(*value)) {
     LOG(ERROR) << "An error occured when serializing the manifest value.";
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "UPDATE applications SET manifest = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update manifest in db.";
     return false;
   }
-  smt.BindString(0, manifest);
+  smt.BindBlob(0, manifest.data(), static_cast<int>(manifest.size()));
   smt.BindString(1, id);
   if (!smt.Run()) {
     LOG(ERROR) << "Could not update application manifest "
@@ -402,7 +613,7 @@ bool DBStoreSqliteImpl::SetManifestValue(
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::SetInstallTimeValue(
@@ -419,11 +630,8 @@ bool DBStoreSqliteImpl::SetInstallTimeValue(
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "UPDATE applications SET install_time = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update install_time in db.";
@@ -437,7 +645,7 @@ bool DBStoreSqliteImpl::SetInstallTimeValue(
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::SetApplicationPathValue(
@@ -453,11 +661,8 @@ bool DBStoreSqliteImpl::SetApplicationPathValue(
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement smt(sqlite_db_->GetUniqueStatement(
+  sql::Statement smt(sqlite_db_->GetCachedStatement(
+      SQL_FROM_HERE,
       "UPDATE applications SET path = ? WHERE id = ?"));
   if (!smt.is_valid()) {
     LOG(ERROR) << "Unable to update path in db.";
@@ -470,7 +675,7 @@ bool DBStoreSqliteImpl::SetApplicationPathValue(
     return false;
   }
 
-  return transaction.Commit();
+  return true;
 }
 
 bool DBStoreSqliteImpl::Commit(const std::string& id,
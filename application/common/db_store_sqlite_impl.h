@@ -6,8 +6,10 @@
 #define XWALK_APPLICATION_COMMON_DB_STORE_SQLITE_IMPL_H_
 
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
+#include "base/memory/linked_ptr.h"
 #include "sql/connection.h"
 #include "sql/meta_table.h"
 #include "xwalk/application/common/db_store.h"
@@ -28,6 +30,9 @@ class DBStoreSqliteImpl: public DBStore {
   virtual bool Remove(const std::string& key) OVERRIDE;
   virtual bool InitDB() OVERRIDE;
   virtual void SetValue(const std::string& key, base::Value* value) OVERRIDE;
+  virtual bool SetValues(scoped_ptr<base::DictionaryValue> values) OVERRIDE;
+  virtual const base::DictionaryValue* GetApplicationValue(
+      const std::string& id) OVERRIDE;
 
  private:
   enum Action {
@@ -36,7 +41,24 @@ class DBStoreSqliteImpl: public DBStore {
     ACTION_UPDATE,
     ACTION_DELETE
   };
+  // A change made to the DB cache, kept until the change is committed to the
+  // sqlite DB, so it can be reverted if committing fails.
+  struct CacheChange {
+    std::string key;
+    // NULL if the key had no value.
+    linked_ptr<base::Value> old_value;
+    bool added_application;
+  };
+  typedef std::vector<CacheChange> CacheChanges;
+
   bool UpdateDBCache();
+  // Same as SetValue(), returning whether the DB was updated. The change made
+  // to the DB cache is appended to |changes|, and observers are not notified
+  // until ReportChanges() is called.
+  bool UpdateValue(const std::string& key, base::Value* value,
+                   CacheChanges* changes);
+  void ReportChanges(const CacheChanges& changes);
+  void RevertChanges(const CacheChanges& changes);
   bool Commit(const std::string& id,
               const std::string& column,
               base::Value* value,
@@ -44,6 +66,7 @@ class DBStoreSqliteImpl: public DBStore {
   void ReportValueChanged(const std::string& key,
                           const base::Value* value);
   bool UpgradeToVersion1(const base::FilePath& v0_file);
+  bool UpgradeToVersion2();
   bool SetApplication(const std::string& id, base::Value* value);
   bool UpdateApplication(const std::string& id, base::Value* value);
   bool DeleteApplication(const std::string& id);
@@ -7,14 +7,36 @@
 #include "base/file_util.h"
 #include "base/files/scoped_temp_dir.h"
 #include "base/json/json_file_value_serializer.h"
+#include "base/json/json_string_value_serializer.h"
 #include "base/logging.h"
 #include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+#include "sql/connection.h"
+#include "sql/meta_table.h"
+#include "sql/statement.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "xwalk/application/browser/application_store.h"
 
 namespace xwalk {
 namespace application {
 
+namespace {
+
+base::DictionaryValue* CreateApplicationValue(int i) {
+  base::DictionaryValue* value = new base::DictionaryValue;
+  value->SetString(ApplicationStore::kApplicationPath, "path");
+  base::DictionaryValue* manifest = new base::DictionaryValue;
+  manifest->SetString("name", base::StringPrintf("app%d", i));
+  manifest->SetString("version", "1.0");
+  manifest->SetString("app.launch.local_path", "index.html");
+  value->Set(ApplicationStore::kManifestPath, manifest);
+  value->SetDouble(ApplicationStore::kInstallTime, i);
+  return value;
+}
+
+}  // namespace
+
 class DBStoreSqliteImplTest : public testing::Test {
  public:
   virtual ~DBStoreSqliteImplTest() {
@@ -104,6 +126,69 @@ TEST_F(DBStoreSqliteImplTest, DBUpgradeToV1) {
   EXPECT_TRUE(db_value->Equals(db_store_->GetApplications()));
 }
 
+TEST_F(DBStoreSqliteImplTest, DBUpgradeToV2) {
+  const int kApplicationCount = 500;
+  base::FilePath tmp;
+  ASSERT_TRUE(PathService::Get(base::DIR_TEMP, &tmp));
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDirUnderPath(tmp));
+
+  // Version 1 stored the manifests as JSON.
+  scoped_ptr<base::DictionaryValue> db_value(new base::DictionaryValue);
+  int64 json_size = 0;
+  {
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(
+        temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+    sql::MetaTable meta_table;
+    ASSERT_TRUE(meta_table.Init(&db, 1, 1));
+    ASSERT_TRUE(db.Execute("CREATE TABLE applications ("
+                           "id TEXT NOT NULL UNIQUE PRIMARY KEY,"
+                           "manifest TEXT NOT NULL,"
+                           "path TEXT NOT NULL,"
+                           "install_time REAL)"));
+    for (int i = 0; i < kApplicationCount; ++i) {
+      std::string id = base::StringPrintf("test_id%d", i);
+      base::DictionaryValue* value = CreateApplicationValue(i);
+      db_value->SetWithoutPathExpansion(id, value);
+
+      base::DictionaryValue* manifest;
+      ASSERT_TRUE(value->GetDictionary(ApplicationStore::kManifestPath,
+                                       &manifest));
+      std::string manifest_str;
+      JSONStringValueSerializer serializer(&manifest_str);
+      ASSERT_TRUE(serializer.Serialize(*manifest));
+      json_size += manifest_str.size();
+
+      sql::Statement smt(db.GetUniqueStatement(
+          "INSERT INTO applications (manifest, path, install_time, id) "
+          "VALUES (?,?,?,?)"));
+      smt.BindString(0, manifest_str);
+      smt.BindString(1, "path");
+      smt.BindDouble(2, i);
+      smt.BindString(3, id);
+      ASSERT_TRUE(smt.Run());
+    }
+  }
+
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_TRUE(db_value->Equals(db_store_->GetApplications()));
+  db_store_.reset();
+
+  sql::Connection db;
+  ASSERT_TRUE(db.Open(temp_dir_.path().Append(DBStoreSqliteImpl::kDBFileName)));
+  sql::MetaTable meta_table;
+  ASSERT_TRUE(meta_table.Init(&db, 2, 2));
+  EXPECT_EQ(2, meta_table.GetVersionNumber());
+  EXPECT_EQ(2, meta_table.GetCompatibleVersionNumber());
+  sql::Statement smt(db.GetUniqueStatement(
+      "SELECT SUM(LENGTH(manifest)) FROM applications"));
+  ASSERT_TRUE(smt.Step());
+  LOG(INFO) << "The manifests of " << kApplicationCount << " applications "
+            << "take " << json_size << " bytes as JSON, "
+            << smt.ColumnInt64(0) << " bytes as binary.";
+}
+
 TEST_F(DBStoreSqliteImplTest, DBUpdate1) {
   TestInit();
   scoped_ptr<base::DictionaryValue> value(new base::DictionaryValue);
@@ -200,5 +285,155 @@ TEST_F(DBStoreSqliteImplTest, DBUpdate4) {
   EXPECT_TRUE(changed_value->Equals(db_value));
 }
 
+TEST_F(DBStoreSqliteImplTest, DBLoadOnDemand) {
+  const int kApplicationCount = 500;
+  TestInit();
+  scoped_ptr<base::DictionaryValue> values(new base::DictionaryValue);
+  for (int i = 0; i < kApplicationCount; ++i) {
+    values->SetWithoutPathExpansion(base::StringPrintf("test_id%d", i),
+                                    CreateApplicationValue(i));
+  }
+  ASSERT_TRUE(db_store_->SetValues(values.Pass()));
+
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  const base::TimeDelta load_all_time = base::TimeTicks::Now() - start_time;
+  EXPECT_EQ(static_cast<size_t>(kApplicationCount),
+            db_store_->GetApplications()->size());
+
+  start_time = base::TimeTicks::Now();
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  db_store_->set_load_on_demand(true);
+  ASSERT_TRUE(db_store_->InitDB());
+  const base::TimeDelta load_ids_time = base::TimeTicks::Now() - start_time;
+  EXPECT_EQ(static_cast<size_t>(kApplicationCount),
+            db_store_->GetApplicationIDs().size());
+  EXPECT_TRUE(db_store_->GetApplications()->empty());
+
+  LOG(INFO) << "Initializing the DB with " << kApplicationCount
+            << " applications took " << load_all_time.InMicroseconds()
+            << "us, reading only their ids took "
+            << load_ids_time.InMicroseconds() << "us.";
+
+  const base::DictionaryValue* value =
+      db_store_->GetApplicationValue("test_id42");
+  ASSERT_TRUE(value);
+  double install_time;
+  ASSERT_TRUE(value->GetDouble(ApplicationStore::kInstallTime, &install_time));
+  EXPECT_EQ(42, install_time);
+  EXPECT_EQ(1u, db_store_->GetApplications()->size());
+  EXPECT_FALSE(db_store_->GetApplicationValue("unknown_id"));
+
+  // Changing a value of an application not read yet updates it.
+  db_store_->SetValue(
+      std::string("test_id7.") + ApplicationStore::kApplicationPath,
+      base::Value::CreateStringValue("path2"));
+  ASSERT_TRUE(db_store_->Remove("test_id8"));
+  EXPECT_FALSE(db_store_->HasApplication("test_id8"));
+
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  std::string path;
+  ASSERT_TRUE(db_store_->GetApplications()->GetString(
+      std::string("test_id7.") + ApplicationStore::kApplicationPath, &path));
+  EXPECT_EQ("path2", path);
+  EXPECT_FALSE(db_store_->GetApplications()->HasKey("test_id8"));
+  EXPECT_EQ(static_cast<size_t>(kApplicationCount - 1),
+            db_store_->GetApplicationIDs().size());
+}
+
+TEST_F(DBStoreSqliteImplTest, DBSetValues) {
+  const int kApplicationCount = 2000;
+  TestInit();
+
+  base::TimeTicks start_time = base::TimeTicks::Now();
+  for (int i = 0; i < kApplicationCount; ++i) {
+    db_store_->SetValue(base::StringPrintf("single_id%d", i),
+                        CreateApplicationValue(i));
+  }
+  const base::TimeDelta single_time = base::TimeTicks::Now() - start_time;
+
+  scoped_ptr<base::DictionaryValue> values(new base::DictionaryValue);
+  for (int i = 0; i < kApplicationCount; ++i) {
+    values->SetWithoutPathExpansion(base::StringPrintf("batch_id%d", i),
+                                    CreateApplicationValue(i));
+  }
+  values->SetWithoutPathExpansion(
+      std::string("single_id0.") + ApplicationStore::kApplicationPath,
+      base::Value::CreateStringValue("path2"));
+  start_time = base::TimeTicks::Now();
+  ASSERT_TRUE(db_store_->SetValues(values.Pass()));
+  const base::TimeDelta batch_time = base::TimeTicks::Now() - start_time;
+
+  LOG(INFO) << "Installing " << kApplicationCount << " applications took "
+            << single_time.InMilliseconds() << "ms one by one, "
+            << batch_time.InMilliseconds() << "ms in a batch.";
+
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_EQ(static_cast<size_t>(2 * kApplicationCount),
+            db_store_->GetApplicationIDs().size());
+  std::string path;
+  ASSERT_TRUE(db_store_->GetApplications()->GetString(
+      std::string("single_id0.") + ApplicationStore::kApplicationPath,
+      &path));
+  EXPECT_EQ("path2", path);
+}
+
+TEST_F(DBStoreSqliteImplTest, DBSetValuesFailure) {
+  TestInit();
+  db_store_->SetValue("test_id0", CreateApplicationValue(0));
+
+  scoped_ptr<base::DictionaryValue> values(new base::DictionaryValue);
+  values->SetWithoutPathExpansion("test_id1", CreateApplicationValue(1));
+  values->SetWithoutPathExpansion(
+      std::string("test_id0.") + ApplicationStore::kApplicationPath,
+      base::Value::CreateStringValue("path2"));
+  // Can't be inserted without a manifest.
+  values->SetWithoutPathExpansion("test_id2", new base::DictionaryValue);
+  EXPECT_FALSE(db_store_->SetValues(values.Pass()));
+
+  // None of the changes is kept in the cache, like in the DB.
+  EXPECT_FALSE(db_store_->GetApplications()->HasKey("test_id1"));
+  EXPECT_FALSE(db_store_->HasApplication("test_id1"));
+  std::string path;
+  ASSERT_TRUE(db_store_->GetApplications()->GetString(
+      std::string("test_id0.") + ApplicationStore::kApplicationPath,
+      &path));
+  EXPECT_EQ("path", path);
+  EXPECT_EQ(1u, db_store_->GetApplicationIDs().size());
+
+  ASSERT_TRUE(db_store_->InitDB());
+  EXPECT_FALSE(db_store_->HasApplication("test_id1"));
+  EXPECT_EQ(1u, db_store_->GetApplicationIDs().size());
+}
+
+TEST_F(DBStoreSqliteImplTest, DBUpgradeToV1ManyApplications) {
+  const int kApplicationCount = 2000;
+  base::FilePath tmp;
+  ASSERT_TRUE(PathService::Get(base::DIR_TEMP, &tmp));
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDirUnderPath(tmp));
+
+  scoped_ptr<base::DictionaryValue> db_value(new base::DictionaryValue);
+  for (int i = 0; i < kApplicationCount; ++i) {
+    db_value->SetWithoutPathExpansion(base::StringPrintf("test_id%d", i),
+                                      CreateApplicationValue(i));
+  }
+  base::FilePath v0_db_file(
+      temp_dir_.path().AppendASCII("applications_db"));
+  JSONFileValueSerializer serializer(v0_db_file);
+  ASSERT_TRUE(serializer.Serialize(*db_value.get()));
+
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  db_store_.reset(new DBStoreSqliteImpl(temp_dir_.path()));
+  ASSERT_TRUE(db_store_->InitDB());
+  LOG(INFO) << "Migrating " << kApplicationCount << " applications took "
+            << (base::TimeTicks::Now() - start_time).InMilliseconds()
+            << "ms.";
+
+  ASSERT_FALSE(base::PathExists(v0_db_file));
+  EXPECT_TRUE(db_value->Equals(db_store_->GetApplications()));
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -7,6 +7,7 @@
 #include <set>
 
 #include "base/stl_util.h"
+#include "xwalk/application/common/manifest_handlers/main_document_handler.h"
 
 namespace xwalk {
 namespace application {
@@ -51,8 +52,7 @@ ManifestHandlerRegistry::~ManifestHandlerRegistry() {
 ManifestHandlerRegistry* ManifestHandlerRegistry::GetInstance() {
   if (!registry_) {
     std::vector<ManifestHandler*> handlers;
-    // FIXME: Add manifest handlers here like this:
-    // handlers.push_back(new xxxHandler);
+    handlers.push_back(new MainDocumentHandler);
 
     registry_ = new ManifestHandlerRegistry(handlers);
   }
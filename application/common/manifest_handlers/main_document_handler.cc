@@ -0,0 +1,154 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_handlers/main_document_handler.h"
+
+#include "base/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_util.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/values.h"
+#include "net/base/escape.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/application_resource.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+
+namespace keys = application_manifest_keys;
+namespace errors = application_manifest_errors;
+
+namespace application {
+
+namespace {
+
+// Reads |script| if it can be inlined in a document, which is not the case
+// for large scripts or the ones that would end the script element early.
+bool ReadInlinableScript(const base::FilePath& application_path,
+                         const std::string& script,
+                         std::string* contents) {
+  const base::FilePath path = ApplicationResource::GetFilePath(
+      application_path, base::FilePath::FromUTF8Unsafe(script),
+      ApplicationResource::SYMLINKS_MUST_RESOLVE_WITHIN_ROOT);
+  int64 size;
+  if (path.empty() || !file_util::GetFileSize(path, &size) ||
+      size > MainDocumentHandler::kMaxInlinedScriptSize ||
+      !file_util::ReadFileToString(path, contents))
+    return false;
+
+  const std::string lower_contents = StringToLowerASCII(*contents);
+  return lower_contents.find("</script") == std::string::npos &&
+      lower_contents.find("<!--") == std::string::npos;
+}
+
+std::string GenerateMainDocument(const Application* application,
+                                 const std::vector<std::string>& scripts) {
+  std::string head;
+  std::string body;
+  for (size_t i = 0; i < scripts.size(); ++i) {
+    const std::string src = net::EscapeForHTML(scripts[i]);
+    std::string contents;
+    if (ReadInlinableScript(application->Path(), scripts[i], &contents)) {
+      // Keeps the name of the script in stack traces and in the inspector.
+      body += "<script>\n" + contents + "\n//# sourceURL=" +
+          application->GetResourceURL(scripts[i]).spec() + "\n</script>\n";
+    } else {
+      head += "<link rel=\"preload\" href=\"" + src + "\" as=\"script\">\n";
+      body += "<script src=\"" + src + "\"></script>\n";
+    }
+  }
+  return "<!DOCTYPE html>\n<head>\n" + head + "</head>\n<body>\n" + body;
+}
+
+}  // namespace
+
+MainDocumentInfo::MainDocumentInfo()
+    : has_generated_document_(false),
+      is_document_generated_(false) {}
+
+MainDocumentInfo::~MainDocumentInfo() {}
+
+// static
+const MainDocumentInfo* MainDocumentInfo::Get(const Application* application) {
+  return static_cast<MainDocumentInfo*>(
+      application->GetManifestData(keys::kAppMainKey));
+}
+
+std::string MainDocumentInfo::GetGeneratedDocument(
+    const Application* application) const {
+  if (!has_generated_document_)
+    return std::string();
+
+  base::AutoLock lock(lock_);
+  if (!is_document_generated_) {
+    generated_document_ = GenerateMainDocument(application, main_scripts_);
+    is_document_generated_ = true;
+  }
+  return generated_document_;
+}
+
+const int64 MainDocumentHandler::kMaxInlinedScriptSize = 16 * 1024;
+
+MainDocumentHandler::MainDocumentHandler() {}
+
+MainDocumentHandler::~MainDocumentHandler() {}
+
+bool MainDocumentHandler::Parse(scoped_refptr<Application> application,
+                                string16* error) {
+  const Manifest* manifest = application->GetManifest();
+  const base::DictionaryValue* dict = NULL;
+  if (!manifest->GetDictionary(keys::kAppMainKey, &dict)) {
+    *error = ASCIIToUTF16(errors::kInvalidAppMain);
+    return false;
+  }
+
+  std::string main_source;
+  if (manifest->HasPath(keys::kAppMainSourceKey) &&
+      !manifest->GetString(keys::kAppMainSourceKey, &main_source)) {
+    *error = ASCIIToUTF16(errors::kInvalidAppMainSource);
+    return false;
+  }
+
+  std::vector<std::string> main_scripts;
+  if (manifest->HasPath(keys::kAppMainScriptsKey)) {
+    const base::ListValue* list = NULL;
+    if (!manifest->GetList(keys::kAppMainScriptsKey, &list)) {
+      *error = ASCIIToUTF16(errors::kInvalidAppMainScripts);
+      return false;
+    }
+    for (size_t i = 0; i < list->GetSize(); ++i) {
+      std::string script;
+      if (!list->GetString(i, &script)) {
+        *error = ASCIIToUTF16(errors::kInvalidAppMainScripts);
+        return false;
+      }
+      main_scripts.push_back(script);
+    }
+  }
+
+  if (!main_source.empty() && !main_scripts.empty())
+    LOG(WARNING) << "An app should not has more than one main document.";
+
+  scoped_ptr<MainDocumentInfo> info(new MainDocumentInfo);
+  info->set_main_scripts(main_scripts);
+  if (!main_source.empty()) {
+    info->set_main_url(application->GetResourceURL(main_source));
+  } else if (!main_scripts.empty()) {
+    // When no main.source is defined but main.scripts are, we implicitly
+    // create a main document.
+    info->set_main_url(
+        application->GetResourceURL(kGeneratedMainDocumentFilename));
+    info->set_has_generated_document(true);
+  }
+
+  application->SetManifestData(keys::kAppMainKey, info.release());
+  return true;
+}
+
+std::vector<std::string> MainDocumentHandler::Keys() const {
+  return std::vector<std::string>(1, keys::kAppMainKey);
+}
+
+}  // namespace application
+}  // namespace xwalk
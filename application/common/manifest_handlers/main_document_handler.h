@@ -0,0 +1,87 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_MANIFEST_HANDLERS_MAIN_DOCUMENT_HANDLER_H_
+#define XWALK_APPLICATION_COMMON_MANIFEST_HANDLERS_MAIN_DOCUMENT_HANDLER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/synchronization/lock.h"
+#include "url/gurl.h"
+#include "xwalk/application/common/application.h"
+#include "xwalk/application/common/manifest_handler.h"
+
+namespace xwalk {
+namespace application {
+
+// The main document of an application, parsed from app.main.
+class MainDocumentInfo : public Application::ManifestData {
+ public:
+  MainDocumentInfo();
+  virtual ~MainDocumentInfo();
+
+  // Returns NULL for applications without app.main.
+  static const MainDocumentInfo* Get(const Application* application);
+
+  // The URL of app.main.source, or of the document generated for
+  // app.main.scripts when there's no source.
+  const GURL& main_url() const { return main_url_; }
+  void set_main_url(const GURL& url) { main_url_ = url; }
+
+  const std::vector<std::string>& main_scripts() const { return main_scripts_; }
+  void set_main_scripts(const std::vector<std::string>& scripts) {
+    main_scripts_ = scripts;
+  }
+
+  bool has_generated_document() const { return has_generated_document_; }
+  void set_has_generated_document(bool has_generated_document) {
+    has_generated_document_ = has_generated_document;
+  }
+
+  // Returns the document loading app.main.scripts, built the first time it's
+  // requested from the scripts of |application|. That reads files, so this
+  // must be called in a thread allowing IO, but not in the UI or IO threads.
+  // Empty for applications with app.main.source.
+  std::string GetGeneratedDocument(const Application* application) const;
+
+ private:
+  GURL main_url_;
+  std::vector<std::string> main_scripts_;
+  bool has_generated_document_;
+
+  // Protects the members below, the document is built in a worker thread.
+  mutable base::Lock lock_;
+  mutable bool is_document_generated_;
+  mutable std::string generated_document_;
+
+  DISALLOW_COPY_AND_ASSIGN(MainDocumentInfo);
+};
+
+// Parses app.main. The applications giving only app.main.scripts get a
+// generated main document, see MainDocumentInfo::GetGeneratedDocument().
+// Small scripts are inlined in the document, saving a request each when the
+// application starts; the document starts preloading the other ones before
+// running any script.
+class MainDocumentHandler : public ManifestHandler {
+ public:
+  MainDocumentHandler();
+  virtual ~MainDocumentHandler();
+
+  virtual bool Parse(scoped_refptr<Application> application,
+                     string16* error) OVERRIDE;
+  virtual std::vector<std::string> Keys() const OVERRIDE;
+
+  // Scripts larger than this are loaded from the application instead of
+  // being inlined in the generated document.
+  static const int64 kMaxInlinedScriptSize;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MainDocumentHandler);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_MANIFEST_HANDLERS_MAIN_DOCUMENT_HANDLER_H_
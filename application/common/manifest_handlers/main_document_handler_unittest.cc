@@ -0,0 +1,128 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_handlers/main_document_handler.h"
+
+#include <string>
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+
+namespace keys = application_manifest_keys;
+
+namespace application {
+
+namespace {
+
+bool WriteString(const base::FilePath& path, const std::string& data) {
+  return file_util::WriteFile(path, data.data(), data.size()) ==
+      static_cast<int>(data.size());
+}
+
+}  // namespace
+
+class MainDocumentHandlerTest : public testing::Test {
+ public:
+  virtual void SetUp() OVERRIDE {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    manifest_.SetString(keys::kNameKey, "no name");
+    manifest_.SetString(keys::kVersionKey, "0");
+    manifest_.SetInteger(keys::kManifestVersionKey, 2);
+  }
+
+ protected:
+  scoped_refptr<Application> CreateApplication() {
+    std::string error;
+    scoped_refptr<Application> application = Application::Create(
+        temp_dir_.path(), Manifest::INTERNAL, manifest_, "", &error);
+    EXPECT_TRUE(error.empty()) << error;
+    return application;
+  }
+
+  void SetMainScripts(base::ListValue* scripts) {
+    manifest_.Set(keys::kAppMainScriptsKey, scripts);
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::DictionaryValue manifest_;
+};
+
+TEST_F(MainDocumentHandlerTest, NoMain) {
+  scoped_refptr<Application> application = CreateApplication();
+  ASSERT_TRUE(application);
+  EXPECT_FALSE(MainDocumentInfo::Get(application.get()));
+}
+
+TEST_F(MainDocumentHandlerTest, MainSource) {
+  manifest_.SetString(keys::kAppMainSourceKey, "main.html");
+  scoped_refptr<Application> application = CreateApplication();
+  ASSERT_TRUE(application);
+  const MainDocumentInfo* info = MainDocumentInfo::Get(application.get());
+  ASSERT_TRUE(info);
+  EXPECT_EQ(application->GetResourceURL("main.html"), info->main_url());
+  EXPECT_FALSE(info->has_generated_document());
+  EXPECT_TRUE(info->GetGeneratedDocument(application.get()).empty());
+}
+
+TEST_F(MainDocumentHandlerTest, MainScripts) {
+  base::ListValue* scripts = new base::ListValue;
+  scripts->AppendString("small.js");
+  scripts->AppendString("tag.js");
+  scripts->AppendString("large.js");
+  scripts->AppendString("missing.js");
+  SetMainScripts(scripts);
+
+  scoped_refptr<Application> application = CreateApplication();
+  ASSERT_TRUE(application);
+  const MainDocumentInfo* info = MainDocumentInfo::Get(application.get());
+  ASSERT_TRUE(info);
+  EXPECT_EQ(application->GetResourceURL(kGeneratedMainDocumentFilename),
+            info->main_url());
+  EXPECT_EQ(4u, info->main_scripts().size());
+  EXPECT_TRUE(info->has_generated_document());
+
+  // The scripts are only read when the document is requested.
+  ASSERT_TRUE(WriteString(temp_dir_.path().AppendASCII("small.js"),
+                          "var small = 1;"));
+  ASSERT_TRUE(WriteString(temp_dir_.path().AppendASCII("tag.js"),
+                          "document.write('</script>');"));
+  const std::string large_script(
+      MainDocumentHandler::kMaxInlinedScriptSize + 1, ' ');
+  ASSERT_TRUE(WriteString(temp_dir_.path().AppendASCII("large.js"),
+                          large_script));
+
+  const std::string document = info->GetGeneratedDocument(application.get());
+  EXPECT_NE(std::string::npos, document.find("var small = 1;"));
+  EXPECT_EQ(std::string::npos, document.find("<script src=\"small.js\">"));
+  const char* const kLoadedScripts[] = { "tag.js", "large.js", "missing.js" };
+  for (size_t i = 0; i < arraysize(kLoadedScripts); ++i) {
+    const std::string script(kLoadedScripts[i]);
+    EXPECT_NE(std::string::npos,
+              document.find("<script src=\"" + script + "\">")) << script;
+    EXPECT_NE(std::string::npos,
+              document.find("<link rel=\"preload\" href=\"" + script + "\""))
+        << script;
+  }
+}
+
+TEST_F(MainDocumentHandlerTest, InvalidMainScripts) {
+  base::ListValue* scripts = new base::ListValue;
+  scripts->AppendInteger(42);
+  SetMainScripts(scripts);
+
+  std::string error;
+  scoped_refptr<Application> application = Application::Create(
+      temp_dir_.path(), Manifest::INTERNAL, manifest_, "", &error);
+  EXPECT_FALSE(application);
+  EXPECT_FALSE(error.empty());
+}
+
+}  // namespace application
+}  // namespace xwalk
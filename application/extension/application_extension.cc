@@ -25,6 +25,8 @@ ApplicationExtension::ApplicationExtension(
   set_name("xwalk.app");
   set_javascript_api(ResourceBundle::GetSharedInstance().GetRawDataResource(
       IDR_XWALK_APPLICATION_API).as_string());
+  // Reading the manifest might take a while, don't delay other extensions.
+  set_needs_dedicated_thread(true);
 }
 
 XWalkExtensionInstance* ApplicationExtension::CreateInstance() {
@@ -0,0 +1,127 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "content/public/browser/web_contents.h"
+#include "content/public/test/browser_test_utils.h"
+#include "content/public/test/test_utils.h"
+#include "net/base/net_util.h"
+#include "xwalk/application/common/application_resource_cache.h"
+#include "xwalk/application/test/application_browsertest.h"
+#include "xwalk/runtime/browser/runtime.h"
+#include "xwalk/runtime/browser/runtime_registry.h"
+
+using xwalk::application::ApplicationResourceCache;
+
+namespace {
+
+const int kResourceCount = 500;
+
+const char kManifest[] =
+    "{\n"
+    "  \"name\": \"resource_test\",\n"
+    "  \"manifest_version\": 1,\n"
+    "  \"version\": \"1.0\",\n"
+    "  \"app\": {\n"
+    "    \"launch\": {\n"
+    "      \"local_path\": \"index.html\"\n"
+    "    }\n"
+    "  }\n"
+    "}\n";
+
+// Requests the resources one after the other, so the time measured is the
+// sum of the latencies of the requests. Returns -1 if any of them fails.
+const char kIndex[] =
+    "<!DOCTYPE html>\n"
+    "<script>\n"
+    "function loadResources(count) {\n"
+    "  var start = Date.now();\n"
+    "  for (var i = 0; i < count; ++i) {\n"
+    "    var xhr = new XMLHttpRequest();\n"
+    "    xhr.open('GET', 'resources/' + i + '.txt', false);\n"
+    "    xhr.send();\n"
+    "    if (xhr.status != 200 || xhr.responseText != String(i))\n"
+    "      return -1;\n"
+    "  }\n"
+    "  return Date.now() - start;\n"
+    "}\n"
+    "</script>\n";
+
+bool WriteString(const base::FilePath& path, const std::string& data) {
+  return file_util::WriteFile(path, data.data(), data.size()) ==
+      static_cast<int>(data.size());
+}
+
+}  // namespace
+
+class ApplicationResourceBrowserTest : public ApplicationBrowserTest {
+ public:
+  virtual void SetUpCommandLine(CommandLine* command_line) OVERRIDE;
+
+ protected:
+  // Returns the time taken to load all the resources, in milliseconds.
+  int LoadResources(content::WebContents* web_contents);
+
+  base::ScopedTempDir app_dir_;
+};
+
+void ApplicationResourceBrowserTest::SetUpCommandLine(
+    CommandLine* command_line) {
+  ApplicationBrowserTest::SetUpCommandLine(command_line);
+  ASSERT_TRUE(app_dir_.CreateUniqueTempDir());
+  const base::FilePath& path = app_dir_.path();
+  ASSERT_TRUE(WriteString(path.AppendASCII("manifest.json"), kManifest));
+  ASSERT_TRUE(WriteString(path.AppendASCII("index.html"), kIndex));
+
+  const base::FilePath resources_dir = path.AppendASCII("resources");
+  ASSERT_TRUE(file_util::CreateDirectory(resources_dir));
+  for (int i = 0; i < kResourceCount; ++i) {
+    ASSERT_TRUE(WriteString(
+        resources_dir.AppendASCII(base::StringPrintf("%d.txt", i)),
+        base::IntToString(i)));
+  }
+
+  GURL url = net::FilePathToFileURL(path);
+  command_line->AppendArg(url.spec());
+}
+
+int ApplicationResourceBrowserTest::LoadResources(
+    content::WebContents* web_contents) {
+  int elapsed = -1;
+  EXPECT_TRUE(content::ExecuteScriptAndExtractInt(
+      web_contents,
+      base::StringPrintf(
+          "window.domAutomationController.send(loadResources(%d));",
+          kResourceCount),
+      &elapsed));
+  return elapsed;
+}
+
+// Loads many small resources twice, the second time their paths are already
+// resolved so they don't need the worker pool.
+IN_PROC_BROWSER_TEST_F(ApplicationResourceBrowserTest, ManyResources) {
+  content::RunAllPendingInMessageLoop();
+  ASSERT_GE(GetRuntimeNumber(), 1);
+  xwalk::Runtime* main_runtime = xwalk::RuntimeRegistry::Get()->runtimes()[0];
+  content::WaitForLoadStop(main_runtime->web_contents());
+
+  ApplicationResourceCache* cache = ApplicationResourceCache::GetInstance();
+  const size_t hits = cache->hits();
+  const int cold_time = LoadResources(main_runtime->web_contents());
+  ASSERT_GE(cold_time, 0);
+
+  const size_t cold_hits = cache->hits();
+  const int warm_time = LoadResources(main_runtime->web_contents());
+  ASSERT_GE(warm_time, 0);
+
+  EXPECT_LT(cold_hits - hits, static_cast<size_t>(kResourceCount));
+  EXPECT_GE(cache->hits() - cold_hits, static_cast<size_t>(kResourceCount));
+
+  LOG(INFO) << "Average latency for " << kResourceCount << " resources: "
+            << static_cast<double>(cold_time) / kResourceCount << "ms cold, "
+            << static_cast<double>(warm_time) / kResourceCount << "ms warm.";
+}
@@ -4,6 +4,7 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_function_handler.h"
 
+#include <string.h>
 #include "base/location.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
@@ -18,6 +19,16 @@ XWalkExtensionFunctionInfo::XWalkExtensionFunctionInfo(
     arguments_(arguments.Pass()),
     post_result_cb_(post_result_cb) {}
 
+XWalkExtensionFunctionInfo::XWalkExtensionFunctionInfo(
+    const std::string& name,
+    scoped_ptr<base::ListValue> arguments,
+    const PostResultCallback& post_result_cb,
+    const PostBinaryResultCallback& post_binary_result_cb)
+  : name_(name),
+    arguments_(arguments.Pass()),
+    post_result_cb_(post_result_cb),
+    post_binary_result_cb_(post_binary_result_cb) {}
+
 XWalkExtensionFunctionInfo::~XWalkExtensionFunctionInfo() {}
 
 XWalkExtensionFunctionHandler::XWalkExtensionFunctionHandler(
@@ -62,6 +73,10 @@ void XWalkExtensionFunctionHandler::HandleMessage(scoped_ptr<base::Value> msg) {
           function_name,
           make_scoped_ptr(static_cast<base::ListValue*>(msg.release())),
           base::Bind(&XWalkExtensionFunctionHandler::DispatchResult,
+                     weak_factory_.GetWeakPtr(),
+                     base::MessageLoopProxy::current(),
+                     callback_id),
+          base::Bind(&XWalkExtensionFunctionHandler::DispatchBinaryResult,
                      weak_factory_.GetWeakPtr(),
                      base::MessageLoopProxy::current(),
                      callback_id)));
@@ -116,10 +131,57 @@ void XWalkExtensionFunctionHandler::DispatchResult(
     handler->PostMessageToInstance(result.PassAs<base::Value>());
 }
 
+// static
+bool XWalkExtensionFunctionHandler::ParseBinaryMessage(
+    const char* data, size_t size, std::string* tag,
+    const char** payload, size_t* payload_size) {
+  if (!size)
+    return false;
+
+  const size_t tag_size = static_cast<unsigned char>(data[0]);
+  if (size < 1 + tag_size)
+    return false;
+
+  tag->assign(data + 1, tag_size);
+  *payload = data + 1 + tag_size;
+  *payload_size = size - 1 - tag_size;
+  return true;
+}
+
+// static
+void XWalkExtensionFunctionHandler::DispatchBinaryResult(
+    const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
+    scoped_refptr<base::MessageLoopProxy> client_task_runner,
+    const std::string& callback_id,
+    const char* data, size_t size) {
+  // The data is only valid during this call, it can't be posted around.
+  DCHECK(client_task_runner->BelongsToCurrentThread());
+
+  if (callback_id.empty())
+    return;
+
+  if (handler)
+    handler->PostBinaryMessageToInstance(callback_id, data, size);
+}
+
 void XWalkExtensionFunctionHandler::PostMessageToInstance(
     scoped_ptr<base::Value> msg) {
   instance_->PostMessageToJS(msg.Pass());
 }
 
+void XWalkExtensionFunctionHandler::PostBinaryMessageToInstance(
+    const std::string& tag, const char* data, size_t size) {
+  DCHECK_LE(tag.size(), 255u);
+
+  binary_message_.resize(1 + tag.size() + size);
+  binary_message_[0] = static_cast<char>(tag.size());
+  memcpy(&binary_message_[1], tag.data(), tag.size());
+  if (size)
+    memcpy(&binary_message_[1 + tag.size()], data, size);
+
+  instance_->PostBinaryMessageToJS(&binary_message_[0],
+                                   binary_message_.size());
+}
+
 }  // namespace extensions
 }  // namespace xwalk
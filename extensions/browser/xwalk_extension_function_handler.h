@@ -7,6 +7,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include "base/bind.h"
 #include "base/memory/weak_ptr.h"
 #include "base/message_loop/message_loop_proxy.h"
@@ -23,10 +24,17 @@ class XWalkExtensionFunctionInfo {
  public:
   typedef base::Callback<void(scoped_ptr<base::ListValue> result)>
       PostResultCallback;
+  typedef base::Callback<void(const char* data, size_t size)>
+      PostBinaryResultCallback;
 
   XWalkExtensionFunctionInfo(const std::string& name,
                              scoped_ptr<base::ListValue> arguments,
                              const PostResultCallback& post_result_cb);
+  XWalkExtensionFunctionInfo(
+      const std::string& name,
+      scoped_ptr<base::ListValue> arguments,
+      const PostResultCallback& post_result_cb,
+      const PostBinaryResultCallback& post_binary_result_cb);
 
   ~XWalkExtensionFunctionInfo();
 
@@ -39,6 +47,15 @@ class XWalkExtensionFunctionInfo {
     post_result_cb_.Run(result.Pass());
   };
 
+  // Same as above, but the result is received by the JavaScript callback as
+  // a single ArrayBuffer, without being converted to a base::Value. The
+  // |data| is copied, so the caller keeps its ownership. Unlike PostResult,
+  // it must be called from the thread that handled the function.
+  void PostBinaryResult(const char* data, size_t size) const {
+    if (!post_binary_result_cb_.is_null())
+      post_binary_result_cb_.Run(data, size);
+  }
+
   std::string name() const {
     return name_;
   }
@@ -51,11 +68,16 @@ class XWalkExtensionFunctionInfo {
     return post_result_cb_;
   }
 
+  PostBinaryResultCallback post_binary_result_cb() const {
+    return post_binary_result_cb_;
+  }
+
  private:
   std::string name_;
   scoped_ptr<base::ListValue> arguments_;
 
   PostResultCallback post_result_cb_;
+  PostBinaryResultCallback post_binary_result_cb_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionFunctionInfo);
 };
@@ -102,6 +124,16 @@ class XWalkExtensionFunctionHandler {
     handlers_[function_name] = callback;
   }
 
+  // Binary messages exchanged with the internal extension JavaScript code
+  // start with a tag identifying their destination: one byte with the length
+  // of the tag, followed by the tag itself. The remaining bytes are the
+  // payload. Messages posted with PostBinaryResult() are tagged with the
+  // callback id, the ones sent by internal.postBinaryMessage() with the tag
+  // given by the caller. Returns false if the message is malformed.
+  static bool ParseBinaryMessage(const char* data, size_t size,
+                                 std::string* tag,
+                                 const char** payload, size_t* payload_size);
+
  private:
   static void DispatchResult(
       const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
@@ -109,12 +141,24 @@ class XWalkExtensionFunctionHandler {
       const std::string& callback_id,
       scoped_ptr<base::ListValue> result);
 
+  static void DispatchBinaryResult(
+      const base::WeakPtr<XWalkExtensionFunctionHandler>& handler,
+      scoped_refptr<base::MessageLoopProxy> client_task_runner,
+      const std::string& callback_id,
+      const char* data, size_t size);
+
   void PostMessageToInstance(scoped_ptr<base::Value> msg);
+  void PostBinaryMessageToInstance(const std::string& tag,
+                                   const char* data, size_t size);
 
   typedef std::map<std::string, FunctionHandler> FunctionHandlerMap;
   FunctionHandlerMap handlers_;
 
   XWalkExtensionInstance* instance_;
+
+  // Reused for framing the binary results, so posting them doesn't allocate.
+  std::vector<char> binary_message_;
+
   base::WeakPtrFactory<XWalkExtensionFunctionHandler> weak_factory_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionFunctionHandler);
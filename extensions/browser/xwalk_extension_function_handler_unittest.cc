@@ -17,6 +17,10 @@ void DispatchResult(std::string* str, scoped_ptr<base::ListValue> result) {
   result->GetString(0, str);
 }
 
+void DispatchBinaryResult(std::string* str, const char* data, size_t size) {
+  str->assign(data, size);
+}
+
 void StoreFunctionInfo(XWalkExtensionFunctionInfo** info_ptr,
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   *info_ptr = info.release();
@@ -56,6 +60,50 @@ TEST(XWalkExtensionFunctionHandlerTest, PostResult) {
   EXPECT_EQ(str, kTestString);
 }
 
+TEST(XWalkExtensionFunctionHandlerTest, PostBinaryResult) {
+  std::string str;
+
+  XWalkExtensionFunctionInfo info(
+      "test",
+      make_scoped_ptr(new base::ListValue()).Pass(),
+      base::Bind(&DispatchResult, &str),
+      base::Bind(&DispatchBinaryResult, &str));
+
+  info.PostBinaryResult(kTestString, sizeof(kTestString) - 1);
+  EXPECT_EQ(str, kTestString);
+
+  // Posting a binary result without a callback should not crash.
+  XWalkExtensionFunctionInfo info_without_binary(
+      "test",
+      make_scoped_ptr(new base::ListValue()).Pass(),
+      base::Bind(&DispatchResult, &str));
+  info_without_binary.PostBinaryResult(kTestString, sizeof(kTestString) - 1);
+}
+
+TEST(XWalkExtensionFunctionHandlerTest, ParseBinaryMessage) {
+  const char kMessage[] = "\x03" "tag" "payload";
+  std::string tag;
+  const char* payload;
+  size_t payload_size;
+
+  ASSERT_TRUE(XWalkExtensionFunctionHandler::ParseBinaryMessage(
+      kMessage, sizeof(kMessage) - 1, &tag, &payload, &payload_size));
+  EXPECT_EQ("tag", tag);
+  EXPECT_EQ("payload", std::string(payload, payload_size));
+
+  // Only the tag, no payload.
+  ASSERT_TRUE(XWalkExtensionFunctionHandler::ParseBinaryMessage(
+      kMessage, 4, &tag, &payload, &payload_size));
+  EXPECT_EQ("tag", tag);
+  EXPECT_EQ(0u, payload_size);
+
+  // Empty and truncated messages.
+  EXPECT_FALSE(XWalkExtensionFunctionHandler::ParseBinaryMessage(
+      kMessage, 0, &tag, &payload, &payload_size));
+  EXPECT_FALSE(XWalkExtensionFunctionHandler::ParseBinaryMessage(
+      kMessage, 3, &tag, &payload, &payload_size));
+}
+
 TEST(XWalkExtensionFunctionHandlerTest, RegisterAndHandleFunction) {
   XWalkExtensionFunctionHandler handler(NULL);
 
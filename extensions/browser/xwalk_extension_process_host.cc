@@ -9,6 +9,7 @@
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/files/file_path.h"
+#include "base/stl_util.h"
 #include "content/public/browser/browser_child_process_host.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_process_host.h"
@@ -33,15 +34,19 @@ namespace extensions {
 class XWalkExtensionProcessHost::RenderProcessMessageFilter
     : public IPC::ChannelProxy::MessageFilter {
  public:
-  explicit RenderProcessMessageFilter(XWalkExtensionProcessHost* eph)
-      : eph_(eph) {}
+  RenderProcessMessageFilter(XWalkExtensionProcessHost* eph,
+                             content::RenderProcessHost* render_process_host)
+      : eph_(eph),
+        render_process_host_(render_process_host),
+        render_process_id_(render_process_host->GetID()),
+        channel_(NULL) {}
 
   // This exists to fulfill the requirement for delayed reply handling, since it
   // needs to send a message back if the parameters couldn't be correctly read
   // from the original message received. See DispatchDealyReplyWithSendParams().
   bool Send(IPC::Message* message) {
     if (eph_)
-      return eph_->render_process_host_->Send(message);
+      return render_process_host_->Send(message);
     delete message;
     return false;
   }
@@ -50,8 +55,26 @@ class XWalkExtensionProcessHost::RenderProcessMessageFilter
     eph_ = NULL;
   }
 
+  // The render process is blocked until it gets a reply, so one is always
+  // sent, with an empty handle if there's no channel for it. Must be called
+  // in the IO thread.
+  void SendEmptyReply(scoped_ptr<IPC::Message> reply) {
+    XWalkExtensionProcessHostMsg_GetExtensionProcessChannel::WriteReplyParams(
+        reply.get(), IPC::ChannelHandle());
+    if (channel_)
+      channel_->Send(reply.release());
+  }
+
  private:
   // IPC::ChannelProxy::MessageFilter implementation.
+  virtual void OnFilterAdded(IPC::Channel* channel) OVERRIDE {
+    channel_ = channel;
+  }
+
+  virtual void OnChannelClosing() OVERRIDE {
+    channel_ = NULL;
+  }
+
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE {
     bool handled = true;
     IPC_BEGIN_MESSAGE_MAP(RenderProcessMessageFilter, message)
@@ -65,13 +88,25 @@ class XWalkExtensionProcessHost::RenderProcessMessageFilter
 
   void OnGetExtensionProcessChannel(IPC::Message* reply) {
     scoped_ptr<IPC::Message> scoped_reply(reply);
-    if (eph_)
-      eph_->OnGetExtensionProcessChannel(scoped_reply.Pass());
+    if (eph_ && eph_->HasRenderProcess(render_process_id_)) {
+      eph_->OnGetExtensionProcessChannel(render_process_id_,
+                                         scoped_reply.Pass());
+      return;
+    }
+
+    LOG(WARNING) << "No extension process channel for render process "
+                 << render_process_id_ << ".";
+    SendEmptyReply(scoped_reply.Pass());
   }
 
   virtual ~RenderProcessMessageFilter() {}
 
   XWalkExtensionProcessHost* eph_;
+  content::RenderProcessHost* render_process_host_;
+  int render_process_id_;
+
+  // Only used in the IO thread.
+  IPC::Channel* channel_;
 };
 
 #if defined(OS_WIN)
@@ -90,17 +125,26 @@ class ExtensionSandboxedProcessLauncherDelegate
 };
 #endif
 
+XWalkExtensionProcessHost::RenderProcessData::RenderProcessData()
+    : render_process_host(NULL),
+      channel_handle(""),
+      is_channel_ready(false) {}
+
+XWalkExtensionProcessHost::RenderProcessData::~RenderProcessData() {
+  if (!message_filter)
+    return;
+
+  // Removed before the channel was ready, the render process still waits.
+  if (pending_reply)
+    message_filter->SendEmptyReply(pending_reply.Pass());
+  message_filter->Invalidate();
+}
+
 XWalkExtensionProcessHost::XWalkExtensionProcessHost(
-    content::RenderProcessHost* render_process_host,
     const base::FilePath& external_extensions_path,
     XWalkExtensionProcessHost::Delegate* delegate)
-    : ep_rp_channel_handle_(""),
-      render_process_host_(render_process_host),
-      render_process_message_filter_(new RenderProcessMessageFilter(this)),
-      external_extensions_path_(external_extensions_path),
-      is_extension_process_channel_ready_(false),
+    : external_extensions_path_(external_extensions_path),
       delegate_(delegate) {
-  render_process_host_->GetChannel()->AddFilter(render_process_message_filter_);
   BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
       base::Bind(&XWalkExtensionProcessHost::StartProcess,
       base::Unretained(this)));
@@ -108,14 +152,80 @@ XWalkExtensionProcessHost::XWalkExtensionProcessHost(
 
 XWalkExtensionProcessHost::~XWalkExtensionProcessHost() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
-  render_process_message_filter_->Invalidate();
+  STLDeleteValues(&render_processes_);
   StopProcess();
 }
 
+void XWalkExtensionProcessHost::AddRenderProcess(
+    content::RenderProcessHost* render_process_host) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  scoped_ptr<RenderProcessData> data(new RenderProcessData);
+  data->render_process_host = render_process_host;
+  data->message_filter =
+      new RenderProcessMessageFilter(this, render_process_host);
+  render_process_host->GetChannel()->AddFilter(data->message_filter);
+  render_process_filters_[render_process_host->GetID()] = data->message_filter;
+
+  // Posted after adding the filter, so the data is in place before the filter
+  // gets any message.
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::AddRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_host->GetID(),
+                 base::Passed(&data)));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcess(
+    content::RenderProcessHost* render_process_host) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  RenderProcessFilterMap::iterator it =
+      render_process_filters_.find(render_process_host->GetID());
+  if (it != render_process_filters_.end()) {
+    // The channel deletes the filter in the IO thread, once it is removed.
+    if (render_process_host->GetChannel())
+      render_process_host->GetChannel()->RemoveFilter(it->second);
+    render_process_filters_.erase(it);
+  }
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread,
+                 base::Unretained(this), render_process_host->GetID()));
+}
+
+void XWalkExtensionProcessHost::AddRenderProcessOnIOThread(
+    int render_process_id, scoped_ptr<RenderProcessData> data) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  CHECK(process_);
+  CHECK(!ContainsKey(render_processes_, render_process_id));
+  render_processes_[render_process_id] = data.release();
+
+  process_->GetHost()->Send(
+      new XWalkExtensionProcessMsg_CreateRenderProcessChannel(
+          render_process_id));
+}
+
+void XWalkExtensionProcessHost::RemoveRenderProcessOnIOThread(
+    int render_process_id) {
+  CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+
+  delete it->second;
+  render_processes_.erase(it);
+
+  if (process_) {
+    process_->GetHost()->Send(
+        new XWalkExtensionProcessMsg_CloseRenderProcessChannel(
+            render_process_id));
+  }
+}
+
 void XWalkExtensionProcessHost::StartProcess() {
   CHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
   CHECK(!process_);
 
+  start_time_ = base::TimeTicks::Now();
+
   process_.reset(content::BrowserChildProcessHost::Create(
       content::PROCESS_TYPE_CONTENT_END, this));
 
@@ -128,6 +238,16 @@ void XWalkExtensionProcessHost::StartProcess() {
   cmd_line->AppendSwitchASCII(switches::kProcessType,
                               switches::kXWalkExtensionProcess);
   cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
+
+  static const char* const kForwardSwitches[] = {
+    switches::kXWalkExtensionMessageBatchingWindow,
+    switches::kXWalkExtensionMessageBatchingSize,
+    switches::kXWalkDumpExtensionMessageStats,
+    switches::kXWalkExtensionWorkerThreads,
+  };
+  cmd_line->CopySwitchesFrom(*CommandLine::ForCurrentProcess(),
+                             kForwardSwitches, arraysize(kForwardSwitches));
+
   process_->Launch(
 #if defined(OS_WIN)
       new ExtensionSandboxedProcessLauncherDelegate(),
@@ -145,10 +265,20 @@ void XWalkExtensionProcessHost::StopProcess() {
   process_.reset();
 }
 
+bool XWalkExtensionProcessHost::HasRenderProcess(
+    int render_process_id) const {
+  return ContainsKey(render_processes_, render_process_id);
+}
+
 void XWalkExtensionProcessHost::OnGetExtensionProcessChannel(
-    scoped_ptr<IPC::Message> reply) {
-  pending_reply_for_render_process_ = reply.Pass();
-  ReplyChannelHandleToRenderProcess();
+    int render_process_id, scoped_ptr<IPC::Message> reply) {
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  DCHECK(it != render_processes_.end());
+
+  RenderProcessData* data = it->second;
+  data->pending_reply = reply.Pass();
+  data->request_time = base::TimeTicks::Now();
+  ReplyChannelHandleToRenderProcess(data);
 }
 
 bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
@@ -173,38 +303,47 @@ void XWalkExtensionProcessHost::OnChannelError() {
 
   VLOG(1) << "\n\nExtensionProcess crashed";
   if (delegate_)
-    delegate_->OnExtensionProcessDied(this, render_process_host_->GetID());
+    delegate_->OnExtensionProcessDied(this);
 }
 
 void XWalkExtensionProcessHost::OnProcessLaunched() {
-  VLOG(1) << "\n\nExtensionProcess was started!";
+  VLOG(1) << "\n\nExtensionProcess was started in "
+          << (base::TimeTicks::Now() - start_time_).InMilliseconds() << "ms!";
 }
 
 void XWalkExtensionProcessHost::OnRenderChannelCreated(
-    const IPC::ChannelHandle& handle) {
-  is_extension_process_channel_ready_ = true;
-  ep_rp_channel_handle_ = handle;
-  ReplyChannelHandleToRenderProcess();
+    int render_process_id, const IPC::ChannelHandle& handle) {
+  RenderProcessDataMap::iterator it = render_processes_.find(render_process_id);
+  if (it == render_processes_.end())
+    return;
+
+  RenderProcessData* data = it->second;
+  data->is_channel_ready = true;
+  data->channel_handle = handle;
+  ReplyChannelHandleToRenderProcess(data);
 }
 
-void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
+void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess(
+    RenderProcessData* data) {
   // Replying the channel handle to RP depends on two events:
   // - EP already notified EPH that new channel was created (for RP<->EP).
   // - RP already asked for the channel handle.
   //
   // The order for this events is not determined, so we call this function from
   // both, and the second execution will send the reply.
-  if (!is_extension_process_channel_ready_
-      || !pending_reply_for_render_process_)
+  if (!data->is_channel_ready || !data->pending_reply)
     return;
 
   XWalkExtensionProcessHostMsg_GetExtensionProcessChannel::WriteReplyParams(
-      pending_reply_for_render_process_.get(), ep_rp_channel_handle_);
+      data->pending_reply.get(), data->channel_handle);
 
-  render_process_host_->Send(pending_reply_for_render_process_.release());
-}
+  VLOG(1) << "Render process " << data->render_process_host->GetID()
+          << " waited "
+          << (base::TimeTicks::Now() - data->request_time).InMilliseconds()
+          << "ms for the extension process channel.";
 
+  data->render_process_host->Send(data->pending_reply.release());
+}
 
 }  // namespace extensions
 }  // namespace xwalk
-
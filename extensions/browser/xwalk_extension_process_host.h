@@ -5,9 +5,11 @@
 #ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 #define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_PROCESS_HOST_H_
 
+#include <map>
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/time/time.h"
 #include "content/public/browser/browser_child_process_host_delegate.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_channel_proxy.h"
@@ -23,32 +25,65 @@ namespace extensions {
 // This class represents the browser side of the browser <-> extension process
 // communication channel. It has to run some operations in IO thread for
 // creating the extra process.
+//
+// The process is started, and the extensions loaded, as soon as the host is
+// created, so it can be created ahead of time, before the render processes
+// that will use it exist. An extension process can serve a single render
+// process, or be shared by many of them, see AddRenderProcess().
 class XWalkExtensionProcessHost
     : public content::BrowserChildProcessHostDelegate {
  public:
   class Delegate {
    public:
-    virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph,
-      int render_process_id) {}
+    virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph) {}
 
    protected:
     ~Delegate() {}
   };
 
-  XWalkExtensionProcessHost(content::RenderProcessHost* render_process_host,
-                            const base::FilePath& external_extensions_path,
+  XWalkExtensionProcessHost(const base::FilePath& external_extensions_path,
                             XWalkExtensionProcessHost::Delegate* delegate);
   virtual ~XWalkExtensionProcessHost();
 
+  // Gives |render_process_host| a channel of its own to the extension
+  // process. Both should be called in the UI thread, and the render process
+  // must be removed once its host closes, so the filter added to its IPC
+  // channel is removed too.
+  void AddRenderProcess(content::RenderProcessHost* render_process_host);
+  void RemoveRenderProcess(content::RenderProcessHost* render_process_host);
+
  private:
   class RenderProcessMessageFilter;
 
+  // Lives in the IO thread.
+  struct RenderProcessData {
+    RenderProcessData();
+    ~RenderProcessData();
+
+    content::RenderProcessHost* render_process_host;
+    scoped_refptr<RenderProcessMessageFilter> message_filter;
+    scoped_ptr<IPC::Message> pending_reply;
+    IPC::ChannelHandle channel_handle;
+    bool is_channel_ready;
+
+    // Used to measure for how long the render process waited the channel.
+    base::TimeTicks request_time;
+  };
+
   void StartProcess();
   void StopProcess();
 
+  void AddRenderProcessOnIOThread(int render_process_id,
+                                  scoped_ptr<RenderProcessData> data);
+  void RemoveRenderProcessOnIOThread(int render_process_id);
+
+  bool HasRenderProcess(int render_process_id) const;
+
   // Handler for message from Render Process host, it is a synchronous message,
   // that will be replied only when the extension process channel is created.
-  void OnGetExtensionProcessChannel(scoped_ptr<IPC::Message> reply);
+  // The render process must have been added.
+  void OnGetExtensionProcessChannel(int render_process_id,
+                                    scoped_ptr<IPC::Message> reply);
 
   // content::BrowserChildProcessHostDelegate implementation.
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
@@ -56,26 +91,31 @@ class XWalkExtensionProcessHost
   virtual void OnProcessLaunched() OVERRIDE;
 
   // Message Handlers.
-  void OnRenderChannelCreated(const IPC::ChannelHandle& channel_id);
+  void OnRenderChannelCreated(int render_process_id,
+                              const IPC::ChannelHandle& channel_id);
 
-  void ReplyChannelHandleToRenderProcess();
+  void ReplyChannelHandleToRenderProcess(RenderProcessData* data);
 
   scoped_ptr<content::BrowserChildProcessHost> process_;
-  IPC::ChannelHandle ep_rp_channel_handle_;
-  content::RenderProcessHost* render_process_host_;
-  scoped_ptr<IPC::Message> pending_reply_for_render_process_;
 
-  // We use this filter to know when RP asked for the extension process channel.
-  // We keep the reference to invalidate the filter once we don't need it
-  // anymore.
+  // For each render process, we use a filter to know when it asked for the
+  // extension process channel. We keep the reference to invalidate the filter
+  // once we don't need it anymore.
   //
   // TODO(cmarcelo): Avoid having an extra filter, see if we can embed this
   // handling in the existing filter we have in ExtensionData struct.
-  scoped_refptr<RenderProcessMessageFilter> render_process_message_filter_;
+  typedef std::map<int, RenderProcessData*> RenderProcessDataMap;
+  RenderProcessDataMap render_processes_;
+
+  // The filters added to the IPC channels of the render processes, used in
+  // the UI thread to remove them.
+  typedef std::map<int, scoped_refptr<RenderProcessMessageFilter> >
+      RenderProcessFilterMap;
+  RenderProcessFilterMap render_process_filters_;
 
   base::FilePath external_extensions_path_;
 
-  bool is_extension_process_channel_ready_;
+  base::TimeTicks start_time_;
 
   XWalkExtensionProcessHost::Delegate* delegate_;
 };
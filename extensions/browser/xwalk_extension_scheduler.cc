@@ -0,0 +1,226 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_scheduler.h"
+
+#include <algorithm>
+#include <vector>
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/debug/trace_event.h"
+#include "base/logging.h"
+#include "base/sequenced_task_runner.h"
+#include "base/stl_util.h"
+#include "base/threading/thread.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Extensions asking for a thread after this limit share the default one.
+const size_t kMaxDedicatedThreads = 16;
+
+// Keeps the server alive until all the tasks deleting its instances have run,
+// the last one to release it schedules the deletion of the server.
+class ServerDeleter : public base::RefCountedThreadSafe<ServerDeleter> {
+ public:
+  ServerDeleter(scoped_ptr<XWalkExtensionServer> server,
+                scoped_refptr<base::SequencedTaskRunner> task_runner)
+      : server_(server.Pass()),
+        task_runner_(task_runner) {}
+
+  void DeleteInstancesOnCurrentThread() {
+    server_->DeleteInstancesOnCurrentThread();
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<ServerDeleter>;
+
+  ~ServerDeleter() {
+    task_runner_->DeleteSoon(FROM_HERE, server_.release());
+  }
+
+  scoped_ptr<XWalkExtensionServer> server_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  DISALLOW_COPY_AND_ASSIGN(ServerDeleter);
+};
+
+}  // namespace
+
+XWalkExtensionScheduler::Stats::Stats()
+    : queue_depth(0),
+      max_queue_depth(0),
+      tasks_run(0) {}
+
+XWalkExtensionScheduler::XWalkExtensionScheduler(
+    scoped_refptr<base::SequencedTaskRunner> default_task_runner)
+    : default_task_runner_(default_task_runner),
+      thread_per_extension_(CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkExtensionThreadPerExtension)) {}
+
+XWalkExtensionScheduler::~XWalkExtensionScheduler() {
+  // Stops the threads, running the tasks still in their queues.
+  STLDeleteValues(&threads_);
+}
+
+void XWalkExtensionScheduler::StartThreadsForServer(
+    const XWalkExtensionServer& server) {
+  std::vector<std::string> names = server.GetExtensionNames();
+  std::vector<std::string>::const_iterator it = names.begin();
+
+  base::AutoLock l(lock_);
+  for (; it != names.end(); ++it) {
+    const std::string& name = *it;
+    if (ContainsKey(threads_, name))
+      continue;
+    if (!thread_per_extension_ && !server.ExtensionNeedsDedicatedThread(name))
+      continue;
+
+    if (threads_.size() >= kMaxDedicatedThreads) {
+      LOG(WARNING) << "Too many extension threads, extension '" << name
+                   << "' will use the shared extension thread.";
+      continue;
+    }
+
+    scoped_ptr<base::Thread> thread(
+        new base::Thread(("XWalkExtensionThread_" + name).c_str()));
+
+    // Like the shared extension thread, uses an IO main loop so extensions
+    // can watch file descriptors.
+    base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
+    if (!thread->StartWithOptions(options)) {
+      LOG(WARNING) << "Couldn't start thread for extension '" << name << "'.";
+      continue;
+    }
+
+    threads_[name] = thread.release();
+  }
+}
+
+scoped_refptr<base::SequencedTaskRunner>
+XWalkExtensionScheduler::GetTaskRunnerForExtension(
+    const std::string& extension_name) {
+  base::AutoLock l(lock_);
+  ThreadMap::const_iterator it = threads_.find(extension_name);
+  if (it == threads_.end())
+    return default_task_runner_;
+  return it->second->message_loop_proxy();
+}
+
+void XWalkExtensionScheduler::PostTask(const std::string& extension_name,
+                                       const base::Closure& task) {
+  {
+    base::AutoLock l(lock_);
+    Stats& stats = stats_[extension_name];
+    stats.queue_depth++;
+    stats.max_queue_depth = std::max(stats.max_queue_depth, stats.queue_depth);
+  }
+
+  GetTaskRunnerForExtension(extension_name)->PostTask(
+      FROM_HERE,
+      base::Bind(&XWalkExtensionScheduler::RunTask, base::Unretained(this),
+                 extension_name, base::TimeTicks::Now(), task));
+}
+
+void XWalkExtensionScheduler::RunTask(const std::string& extension_name,
+                                      base::TimeTicks post_time,
+                                      const base::Closure& task) {
+  TRACE_EVENT1("xwalk", "XWalkExtensionScheduler::RunTask",
+               "extension", TRACE_STR_COPY(extension_name.c_str()));
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  task.Run();
+  const base::TimeTicks end_time = base::TimeTicks::Now();
+
+  const base::TimeDelta queueing_time = start_time - post_time;
+  if (!extension_name.empty()) {
+    XWalkExtensionMessageStats::GetInstance()->RecordQueueingTime(
+        extension_name, queueing_time);
+  }
+
+  base::AutoLock l(lock_);
+  Stats& stats = stats_[extension_name];
+  stats.queue_depth--;
+  stats.tasks_run++;
+  stats.total_queueing_time += queueing_time;
+  stats.max_queueing_time = std::max(stats.max_queueing_time, queueing_time);
+  stats.total_run_time += end_time - start_time;
+}
+
+void XWalkExtensionScheduler::DeleteServerSoon(
+    scoped_ptr<XWalkExtensionServer> server) {
+  std::vector<scoped_refptr<base::SequencedTaskRunner> > task_runners;
+  task_runners.push_back(default_task_runner_);
+  {
+    base::AutoLock l(lock_);
+    ThreadMap::const_iterator it = threads_.begin();
+    for (; it != threads_.end(); ++it)
+      task_runners.push_back(it->second->message_loop_proxy());
+  }
+
+  // The tasks run after the ones already posted for the server, so the
+  // instances are deleted after handling their pending messages.
+  scoped_refptr<ServerDeleter> deleter(
+      new ServerDeleter(server.Pass(), default_task_runner_));
+  for (size_t i = 0; i < task_runners.size(); ++i) {
+    task_runners[i]->PostTask(
+        FROM_HERE,
+        base::Bind(&ServerDeleter::DeleteInstancesOnCurrentThread, deleter));
+  }
+}
+
+void XWalkExtensionScheduler::StopThreads() {
+  ThreadMap threads;
+  {
+    base::AutoLock l(lock_);
+    threads = threads_;
+  }
+
+  // Not holding the lock, the tasks still queued may need it.
+  ThreadMap::iterator it = threads.begin();
+  for (; it != threads.end(); ++it)
+    it->second->Stop();
+
+  base::AutoLock l(lock_);
+  threads_.clear();
+  STLDeleteValues(&threads);
+}
+
+bool XWalkExtensionScheduler::GetStats(const std::string& extension_name,
+                                       Stats* stats) const {
+  base::AutoLock l(lock_);
+  StatsMap::const_iterator it = stats_.find(extension_name);
+  if (it == stats_.end())
+    return false;
+  *stats = it->second;
+  return true;
+}
+
+void XWalkExtensionScheduler::LogStats() const {
+  base::AutoLock l(lock_);
+  StatsMap::const_iterator it = stats_.begin();
+  for (; it != stats_.end(); ++it) {
+    const Stats& stats = it->second;
+    if (!stats.tasks_run)
+      continue;
+    const int64 tasks_run = static_cast<int64>(stats.tasks_run);
+    VLOG(1) << "Extension '" << it->first << "'"
+            << (ContainsKey(threads_, it->first) ? " (dedicated thread)" : "")
+            << ": " << stats.tasks_run << " tasks, max queue depth "
+            << stats.max_queue_depth << ", average queueing time "
+            << (stats.total_queueing_time / tasks_run).InMicroseconds()
+            << "us, max queueing time "
+            << stats.max_queueing_time.InMicroseconds() << "us, average run"
+            << " time "
+            << (stats.total_run_time / tasks_run).InMicroseconds()
+            << "us.";
+  }
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,103 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_SCHEDULER_H_
+#define XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_SCHEDULER_H_
+
+#include <map>
+#include <string>
+#include "base/callback_forward.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class SequencedTaskRunner;
+class Thread;
+}
+
+namespace xwalk {
+namespace extensions {
+
+class XWalkExtensionServer;
+
+// Decides in which thread the messages for each in-process extension are
+// handled. By default all the extensions share the extension thread, but the
+// ones that need it get a thread of their own, so a slow extension doesn't
+// delay the messages of the others. All the messages for an extension go to
+// the same thread, which keeps the order of the messages for each instance.
+//
+// It also keeps track, per extension, of how many tasks are waiting to run
+// and for how long they waited.
+class XWalkExtensionScheduler {
+ public:
+  struct Stats {
+    Stats();
+
+    // Tasks posted that didn't run yet.
+    size_t queue_depth;
+    size_t max_queue_depth;
+
+    uint64 tasks_run;
+
+    // Time between posting a task and starting to run it.
+    base::TimeDelta total_queueing_time;
+    base::TimeDelta max_queueing_time;
+
+    base::TimeDelta total_run_time;
+  };
+
+  explicit XWalkExtensionScheduler(
+      scoped_refptr<base::SequencedTaskRunner> default_task_runner);
+  ~XWalkExtensionScheduler();
+
+  // Starts the threads for the extensions registered in |server| that need
+  // one, see XWalkExtension::needs_dedicated_thread(). If the switch
+  // kXWalkExtensionThreadPerExtension is present, every extension gets its
+  // own thread. Threads are shared by the servers of all render processes.
+  void StartThreadsForServer(const XWalkExtensionServer& server);
+
+  // Can be called from any thread. An empty |extension_name| refers to
+  // messages not related to a particular extension.
+  scoped_refptr<base::SequencedTaskRunner> GetTaskRunnerForExtension(
+      const std::string& extension_name);
+  void PostTask(const std::string& extension_name, const base::Closure& task);
+
+  // Deletes the instances of |server| in the threads they were created, and
+  // after that deletes the server in the default task runner.
+  void DeleteServerSoon(scoped_ptr<XWalkExtensionServer> server);
+
+  // Stops the dedicated threads, running the tasks still in their queues.
+  // Must be called while the default task runner still runs tasks, since the
+  // servers are deleted there. After this, all the extensions use the
+  // default task runner.
+  void StopThreads();
+
+  bool GetStats(const std::string& extension_name, Stats* stats) const;
+  void LogStats() const;
+
+ private:
+  void RunTask(const std::string& extension_name, base::TimeTicks post_time,
+               const base::Closure& task);
+
+  scoped_refptr<base::SequencedTaskRunner> default_task_runner_;
+  bool thread_per_extension_;
+
+  // Protects the members below.
+  mutable base::Lock lock_;
+
+  typedef std::map<std::string, base::Thread*> ThreadMap;
+  ThreadMap threads_;
+
+  typedef std::map<std::string, Stats> StatsMap;
+  StatsMap stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionScheduler);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_BROWSER_XWALK_EXTENSION_SCHEDULER_H_
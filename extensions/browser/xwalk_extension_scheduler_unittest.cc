@@ -0,0 +1,123 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/browser/xwalk_extension_scheduler.h"
+
+#include <vector>
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/synchronization/waitable_event.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionScheduler;
+using xwalk::extensions::XWalkExtensionServer;
+
+namespace {
+
+class TestExtension : public XWalkExtension {
+ public:
+  TestExtension(const std::string& name, bool needs_dedicated_thread) {
+    set_name(name);
+    set_needs_dedicated_thread(needs_dedicated_thread);
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return NULL;
+  }
+};
+
+void AppendValue(std::vector<int>* values, int value) {
+  values->push_back(value);
+}
+
+void CheckRunsOnThread(scoped_refptr<base::SequencedTaskRunner> task_runner,
+                       bool* result, base::WaitableEvent* done) {
+  *result = task_runner->RunsTasksOnCurrentThread();
+  done->Signal();
+}
+
+class XWalkExtensionSchedulerTest : public testing::Test {
+ public:
+  XWalkExtensionSchedulerTest()
+      : scheduler_(base::MessageLoopProxy::current()) {
+    server_.RegisterExtension(scoped_ptr<XWalkExtension>(
+        new TestExtension("light", false)));
+    server_.RegisterExtension(scoped_ptr<XWalkExtension>(
+        new TestExtension("heavy", true)));
+    scheduler_.StartThreadsForServer(server_);
+  }
+
+ protected:
+  base::MessageLoop message_loop_;
+  XWalkExtensionServer server_;
+  XWalkExtensionScheduler scheduler_;
+};
+
+}  // namespace
+
+TEST_F(XWalkExtensionSchedulerTest, HeavyExtensionsGetTheirOwnThread) {
+  scoped_refptr<base::SequencedTaskRunner> default_task_runner =
+      base::MessageLoopProxy::current();
+  EXPECT_EQ(default_task_runner.get(),
+            scheduler_.GetTaskRunnerForExtension("").get());
+  EXPECT_EQ(default_task_runner.get(),
+            scheduler_.GetTaskRunnerForExtension("light").get());
+
+  scoped_refptr<base::SequencedTaskRunner> heavy_task_runner =
+      scheduler_.GetTaskRunnerForExtension("heavy");
+  EXPECT_NE(default_task_runner.get(), heavy_task_runner.get());
+
+  bool runs_on_heavy_thread = false;
+  base::WaitableEvent done(false, false);
+  scheduler_.PostTask("heavy", base::Bind(&CheckRunsOnThread,
+                                          heavy_task_runner,
+                                          &runs_on_heavy_thread, &done));
+  done.Wait();
+  EXPECT_TRUE(runs_on_heavy_thread);
+}
+
+TEST_F(XWalkExtensionSchedulerTest, TasksRunInOrderAndAreCounted) {
+  const int kTaskCount = 100;
+  std::vector<int> values;
+  for (int i = 0; i < kTaskCount; ++i)
+    scheduler_.PostTask("heavy", base::Bind(&AppendValue, &values, i));
+
+  // Posted directly to the thread, so it runs after the scheduler finished
+  // accounting the tasks above.
+  base::WaitableEvent done(false, false);
+  scheduler_.GetTaskRunnerForExtension("heavy")->PostTask(
+      FROM_HERE,
+      base::Bind(&base::WaitableEvent::Signal, base::Unretained(&done)));
+  done.Wait();
+
+  ASSERT_EQ(static_cast<size_t>(kTaskCount), values.size());
+  for (int i = 0; i < kTaskCount; ++i)
+    EXPECT_EQ(i, values[i]);
+
+  XWalkExtensionScheduler::Stats stats;
+  ASSERT_TRUE(scheduler_.GetStats("heavy", &stats));
+  EXPECT_EQ(static_cast<uint64>(kTaskCount), stats.tasks_run);
+  EXPECT_EQ(0u, stats.queue_depth);
+  EXPECT_GE(stats.max_queue_depth, 1u);
+  EXPECT_FALSE(scheduler_.GetStats("light", &stats));
+}
+
+TEST_F(XWalkExtensionSchedulerTest, StopThreadsRunsPendingTasks) {
+  const int kTaskCount = 10;
+  std::vector<int> values;
+  for (int i = 0; i < kTaskCount; ++i)
+    scheduler_.PostTask("heavy", base::Bind(&AppendValue, &values, i));
+
+  scheduler_.StopThreads();
+  EXPECT_EQ(static_cast<size_t>(kTaskCount), values.size());
+
+  // The extension falls back to the default task runner.
+  EXPECT_EQ(base::MessageLoopProxy::current().get(),
+            scheduler_.GetTaskRunnerForExtension("heavy").get());
+}
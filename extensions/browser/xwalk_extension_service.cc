@@ -13,7 +13,10 @@
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message_macros.h"
+#include "ipc/ipc_sync_message.h"
+#include "xwalk/extensions/browser/xwalk_extension_scheduler.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
@@ -30,26 +33,27 @@ g_register_extensions_callback;
 
 base::FilePath g_external_extensions_path_for_testing_;
 
+// A spare extension process not used after this time is stopped, it is
+// started again for the next render process.
+const int kSpareExtensionProcessIdleTimeoutInSeconds = 60;
+
 }
 
 // This object intercepts messages destined to a XWalkExtensionServer and
-// dispatch them to its task runner. A message loop proxy of a thread is a
-// task runner. Like other filters, this filter will run in the IO-thread.
-//
-// In the case of in process extensions, we will pass the task runner of the
-// extension thread.
+// dispatch them to the thread chosen by the XWalkExtensionScheduler for the
+// extension they refer to. Like other filters, this filter will run in the
+// IO-thread.
 class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter {
  public:
-  ExtensionServerMessageFilter(
-      scoped_refptr<base::SequencedTaskRunner> task_runner,
-      XWalkExtensionServer* server)
-      : task_runner_(task_runner),
+  ExtensionServerMessageFilter(XWalkExtensionScheduler* scheduler,
+                               XWalkExtensionServer* server)
+      : scheduler_(scheduler),
         server_(server) {}
 
   // Tells the filter to stop dispatching messages to the server.
   void Invalidate() {
     base::AutoLock l(lock_);
-    task_runner_ = NULL;
+    scheduler_ = NULL;
     server_ = NULL;
   }
 
@@ -62,8 +66,8 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter {
       base::AutoLock l(lock_);
       if (!server_)
         return false;
-      task_runner_->PostTask(
-          FROM_HERE,
+      scheduler_->PostTask(
+          GetExtensionNameForMessage(message),
           base::Bind(
               base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
               base::Unretained(server_), message));
@@ -72,11 +76,47 @@ class ExtensionServerMessageFilter : public IPC::ChannelProxy::MessageFilter {
     return false;
   }
 
+  // Keeps track of the extension of each instance, so all the messages of an
+  // instance are handled in the same thread. Returns an empty name for the
+  // messages that are not related to an instance.
+  std::string GetExtensionNameForMessage(const IPC::Message& message) {
+    if (message.type() == XWalkExtensionServerMsg_GetExtensions::ID ||
+        message.type() == XWalkExtensionServerMsg_GetExtensionAPI::ID)
+      return std::string();
+
+    if (message.type() == XWalkExtensionServerMsg_CreateInstance::ID) {
+      XWalkExtensionServerMsg_CreateInstance::Param param;
+      if (!XWalkExtensionServerMsg_CreateInstance::Read(&message, &param))
+        return std::string();
+      instance_extensions_[param.a] = param.b;
+      return param.b;
+    }
+
+    // All the other messages have the instance id as first parameter.
+    PickleIterator iter = message.is_sync() ?
+        IPC::SyncMessage::GetDataIterator(&message) : PickleIterator(message);
+    int64 instance_id;
+    if (!iter.ReadInt64(&instance_id))
+      return std::string();
+
+    InstanceExtensionMap::iterator it = instance_extensions_.find(instance_id);
+    if (it == instance_extensions_.end())
+      return std::string();
+
+    std::string name = it->second;
+    if (message.type() == XWalkExtensionServerMsg_DestroyInstance::ID)
+      instance_extensions_.erase(it);
+    return name;
+  }
+
   // This lock is used to protect access to filter members.
   base::Lock lock_;
 
-  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  XWalkExtensionScheduler* scheduler_;
   XWalkExtensionServer* server_;
+
+  typedef std::map<int64_t, std::string> InstanceExtensionMap;
+  InstanceExtensionMap instance_extensions_;
 };
 
 XWalkExtensionService::XWalkExtensionService(XWalkExtensionService::Delegate*
@@ -91,9 +131,34 @@ XWalkExtensionService::XWalkExtensionService(XWalkExtensionService::Delegate*
   // IO main loop is needed by extensions watching file descriptors events.
   base::Thread::Options options(base::MessageLoop::TYPE_IO, 0);
   extension_thread_.StartWithOptions(options);
+
+  scheduler_.reset(
+      new XWalkExtensionScheduler(extension_thread_.message_loop_proxy()));
 }
 
 XWalkExtensionService::~XWalkExtensionService() {
+  // The filters of the render processes still alive refer to the scheduler
+  // and may get messages in the IO-thread until their channel goes away.
+  RenderProcessToExtensionDataMap::iterator it = extension_data_map_.begin();
+  for (; it != extension_data_map_.end(); ++it)
+    it->second->in_process_message_filter_->Invalidate();
+
+  scheduler_->LogStats();
+
+  // The tasks posted by the scheduler refer to it, so the threads must be
+  // stopped before the scheduler is destroyed. The dedicated threads go
+  // first: the servers are deleted in the extension thread once their
+  // instances are deleted in all the threads.
+  scheduler_->StopThreads();
+  extension_thread_.Stop();
+  XWalkExtensionMessageStats::GetInstance()->DumpIfRequested();
+
+  if (shared_extension_process_host_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              shared_extension_process_host_.release());
+  }
+  StopSpareExtensionProcess();
+
   // This object should have been released and asked to be deleted in the
   // extension thread.
   if (!extension_data_map_.empty())
@@ -103,6 +168,13 @@ XWalkExtensionService::~XWalkExtensionService() {
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
     const base::FilePath& path) {
   external_extensions_path_ = path;
+
+  // A spare process started before might have loaded the extensions from
+  // another path.
+  StopSpareExtensionProcess();
+
+  // Get the extension process ready for the first render process.
+  PrestartExtensionProcess();
 }
 
 void XWalkExtensionService::OnRenderProcessHostCreated(
@@ -120,6 +192,8 @@ void XWalkExtensionService::OnRenderProcessHostCreated(
         external_extensions_path_);
   }
 
+  scheduler_->StartThreadsForServer(*data->in_process_server_);
+
   extension_data_map_[host->GetID()] = data;
 }
 
@@ -163,7 +237,7 @@ void XWalkExtensionService::OnRenderProcessHostClosed(
   // Invalidate the objects in the different threads so they stop posting
   // messages to each other. This is important because we'll schedule the
   // deletion of both objects to their respective threads.
-  ExtensionServerMessageFilter* message_filter =
+  scoped_refptr<ExtensionServerMessageFilter> message_filter =
       data->in_process_message_filter_;
   CHECK(message_filter);
 
@@ -177,18 +251,24 @@ void XWalkExtensionService::OnRenderProcessHostClosed(
   in_process_server->Invalidate();
 
   // This will cause the filter to be deleted in the IO-thread.
-  host->GetChannel()->RemoveFilter(message_filter);
+  host->GetChannel()->RemoveFilter(message_filter.get());
 
-  extension_thread_.message_loop()->DeleteSoon(
-      FROM_HERE, in_process_server.release());
+  scheduler_->DeleteServerSoon(in_process_server.Pass());
 
   scoped_ptr<XWalkExtensionProcessHost> eph =
       data->extension_process_host_.Pass();
 
-  if (eph)
+  // Removing the render process also removes the filter added to its
+  // channel, which would outlive the extension process host otherwise.
+  if (eph) {
+    eph->RemoveRenderProcess(host);
     BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE, eph.release());
+  } else if (shared_extension_process_host_) {
+    shared_extension_process_host_->RemoveRenderProcess(host);
+  }
 
   extension_data_map_.erase(host->GetID());
+  delete data;
 }
 
 void XWalkExtensionService::CreateInProcessExtensionServer(
@@ -198,13 +278,16 @@ void XWalkExtensionService::CreateInProcessExtensionServer(
   IPC::ChannelProxy* channel = host->GetChannel();
 
   ExtensionServerMessageFilter* message_filter =
-      new ExtensionServerMessageFilter(extension_thread_.message_loop_proxy(),
+      new ExtensionServerMessageFilter(scheduler_.get(),
                                        in_process_server.get());
   channel->AddFilter(message_filter);
   in_process_server->Initialize(channel);
+  in_process_server->EnableMessageBatchingFromCommandLine(
+      extension_thread_.message_loop_proxy());
 
   // The filter is owned by the IPC channel but we keep a reference to remove
-  // it from the Channel later during a RenderProcess shutdown.
+  // it from the Channel later during a RenderProcess shutdown, and to
+  // invalidate it if the service goes away first.
   data->in_process_message_filter_ = message_filter;
 
   delegate_->RegisterInternalExtensionsInServer(in_process_server.get());
@@ -217,24 +300,84 @@ void XWalkExtensionService::CreateInProcessExtensionServer(
 
 void XWalkExtensionService::CreateExtensionProcessHost(
     content::RenderProcessHost* host, ExtensionData* data) {
-  data->extension_process_host_ = make_scoped_ptr(
-      new XWalkExtensionProcessHost(host, external_extensions_path_, this));
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkSharedExtensionProcess)) {
+    // The extension process is started with the first render process (if it
+    // wasn't prestarted), and the following ones just get a new channel to it.
+    PrestartExtensionProcess();
+    shared_extension_process_host_->AddRenderProcess(host);
+    return;
+  }
+
+  // Use the spare process if there's one, its extensions are probably loaded
+  // already, so the render process won't wait for that.
+  scoped_ptr<XWalkExtensionProcessHost> eph =
+      spare_extension_process_host_.Pass();
+  if (!eph)
+    eph.reset(new XWalkExtensionProcessHost(external_extensions_path_, this));
+  eph->AddRenderProcess(host);
+  data->extension_process_host_ = eph.Pass();
+
+  // And start another one for the next render process.
+  PrestartExtensionProcess();
+}
+
+void XWalkExtensionService::PrestartExtensionProcess() {
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess))
+    return;
+
+  if (cmd_line->HasSwitch(switches::kXWalkSharedExtensionProcess)) {
+    if (!shared_extension_process_host_) {
+      shared_extension_process_host_.reset(
+          new XWalkExtensionProcessHost(external_extensions_path_, this));
+    }
+    return;
+  }
+
+  if (spare_extension_process_host_)
+    return;
+
+  spare_extension_process_host_.reset(
+      new XWalkExtensionProcessHost(external_extensions_path_, this));
+  spare_extension_process_timer_.Start(
+      FROM_HERE,
+      base::TimeDelta::FromSeconds(kSpareExtensionProcessIdleTimeoutInSeconds),
+      this, &XWalkExtensionService::StopSpareExtensionProcess);
+}
+
+void XWalkExtensionService::StopSpareExtensionProcess() {
+  spare_extension_process_timer_.Stop();
+  if (spare_extension_process_host_) {
+    BrowserThread::DeleteSoon(BrowserThread::IO, FROM_HERE,
+                              spare_extension_process_host_.release());
+  }
 }
 
 void XWalkExtensionService::OnExtensionProcessDied(
-    XWalkExtensionProcessHost* eph, int render_process_id) {
+    XWalkExtensionProcessHost* eph) {
   // When this is called it means that XWalkExtensionProcessHost is about
   // to be deleted. We should invalidate our reference to it so we avoid a
   // segfault when trying to delete it within
   // XWalkExtensionService::OnRenderProcessHostClosed();
 
-  ExtensionData* data = extension_data_map_[render_process_id];
+  if (eph == shared_extension_process_host_.get()) {
+    shared_extension_process_host_.release();
+    return;
+  }
 
-  if (data) {
-    XWalkExtensionProcessHost* extension_process_host =
-        data->extension_process_host_.release();
+  if (eph == spare_extension_process_host_.get()) {
+    spare_extension_process_host_.release();
+    return;
+  }
 
-    CHECK(extension_process_host == eph);
+  RenderProcessToExtensionDataMap::iterator it = extension_data_map_.begin();
+  for (; it != extension_data_map_.end(); ++it) {
+    ExtensionData* data = it->second;
+    if (data->extension_process_host_.get() == eph) {
+      data->extension_process_host_.release();
+      return;
+    }
   }
 }
 
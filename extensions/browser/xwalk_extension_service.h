@@ -11,8 +11,10 @@
 #include "base/callback_forward.h"
 #include "base/containers/scoped_ptr_hash_map.h"
 #include "base/files/file_path.h"
+#include "base/memory/ref_counted.h"
 #include "base/memory/scoped_ptr.h"
 #include "base/threading/thread.h"
+#include "base/timer/timer.h"
 #include "content/public/browser/notification_observer.h"
 #include "content/public/browser/notification_registrar.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
@@ -27,6 +29,7 @@ namespace extensions {
 
 class ExtensionServerMessageFilter;
 class XWalkExtension;
+class XWalkExtensionScheduler;
 class XWalkExtensionServer;
 
 // This is the entry point for Crosswalk extensions. Its responsible for keeping
@@ -66,19 +69,20 @@ class XWalkExtensionService : public content::NotificationObserver,
   struct ExtensionData {
     ExtensionData();
     ~ExtensionData();
-    // The servers will live on the extension thread.
+    // The servers will live on the extension thread, but the instances of
+    // some extensions live on their own threads, see XWalkExtensionScheduler.
     scoped_ptr<XWalkExtensionServer> in_process_server_;
 
     // This object lives on the IO-thread.
-    ExtensionServerMessageFilter* in_process_message_filter_;
+    scoped_refptr<ExtensionServerMessageFilter> in_process_message_filter_;
 
-    // This object lives on the IO-thread.
+    // This object lives on the IO-thread. Not used when the extension
+    // process is shared.
     scoped_ptr<XWalkExtensionProcessHost> extension_process_host_;
   };
 
   // XWalkExtensionProcessHost::Delegate implementation.
-  virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph,
-      int render_process_id);
+  virtual void OnExtensionProcessDied(XWalkExtensionProcessHost* eph);
 
   // NotificationObserver implementation.
   virtual void Observe(int type, const content::NotificationSource& source,
@@ -91,16 +95,36 @@ class XWalkExtensionService : public content::NotificationObserver,
   void CreateExtensionProcessHost(content::RenderProcessHost* host,
       ExtensionData* data);
 
+  // Starts an extension process before there's a render process to use it,
+  // so its launch and the loading of the extensions don't block the page
+  // load. It becomes the shared extension process if that's enabled.
+  void PrestartExtensionProcess();
+  void StopSpareExtensionProcess();
+
   // The server that handles in process extensions will live in the
   // extension_thread_.
   base::Thread extension_thread_;
 
+  // Chooses the thread for the messages of each in-process extension.
+  scoped_ptr<XWalkExtensionScheduler> scheduler_;
+
   content::NotificationRegistrar registrar_;
 
   Delegate* delegate_;
 
   base::FilePath external_extensions_path_;
 
+  // Serves all the render processes when switches::kXWalkSharedExtensionProcess
+  // is present. This object lives on the IO-thread.
+  scoped_ptr<XWalkExtensionProcessHost> shared_extension_process_host_;
+
+  // Extension process started ahead of time for the next render process.
+  // This object lives on the IO-thread.
+  scoped_ptr<XWalkExtensionProcessHost> spare_extension_process_host_;
+
+  // Stops the spare process when no render process claims it for a while.
+  base::OneShotTimer<XWalkExtensionService> spare_extension_process_timer_;
+
   typedef std::map<int, ExtensionData*> RenderProcessToExtensionDataMap;
   RenderProcessToExtensionDataMap extension_data_map_;
 
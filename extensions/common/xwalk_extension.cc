@@ -9,7 +9,7 @@
 namespace xwalk {
 namespace extensions {
 
-XWalkExtension::XWalkExtension() {}
+XWalkExtension::XWalkExtension() : needs_dedicated_thread_(false) {}
 
 XWalkExtension::~XWalkExtension() {}
 
@@ -31,10 +31,34 @@ void XWalkExtensionInstance::SetSendSyncReplyCallback(
   send_sync_reply_ = callback;
 }
 
+void XWalkExtensionInstance::SetPostBinaryMessageCallback(
+    const PostBinaryMessageCallback& callback) {
+  post_binary_message_ = callback;
+}
+
+void XWalkExtensionInstance::SetSendReplyCallback(
+    const SendReplyCallback& callback) {
+  send_reply_ = callback;
+}
+
 void XWalkExtensionInstance::HandleSyncMessage(
     scoped_ptr<base::Value> msg) {
   LOG(FATAL) << "Sending sync message to extension which doesn't support it!";
 }
 
+void XWalkExtensionInstance::HandleRequest(int request_id,
+                                           scoped_ptr<base::Value> msg) {
+  // Reply anyway, so the JavaScript side doesn't wait forever.
+  LOG(WARNING) << "Sending request to extension which doesn't support it!";
+  SendReplyToJS(request_id,
+                scoped_ptr<base::Value>(base::Value::CreateNullValue()));
+}
+
+void XWalkExtensionInstance::HandleBinaryMessage(const char* data,
+                                                 size_t size) {
+  LOG(WARNING) << "Ignoring binary message sent to extension which doesn't "
+               << "support it.";
+}
+
 }  // namespace extensions
 }  // namespace xwalk
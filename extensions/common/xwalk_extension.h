@@ -44,6 +44,12 @@ class XWalkExtension {
   // objects outside the namespace that is implicitly created using its name.
   virtual const base::ListValue& entry_points() const;
 
+  // Whether the instances of this extension should run on a thread of their
+  // own, instead of sharing the extension thread with the other in-process
+  // extensions. Useful for extensions that may block for a long time, so
+  // they don't delay the messages of unrelated extensions.
+  bool needs_dedicated_thread() const { return needs_dedicated_thread_; }
+
  protected:
   XWalkExtension();
   void set_name(const std::string& name) { name_ = name; }
@@ -53,6 +59,9 @@ class XWalkExtension {
   void set_entry_points(const std::vector<std::string>& entry_points) {
     entry_points_.AppendStrings(entry_points);
   }
+  void set_needs_dedicated_thread(bool needs_dedicated_thread) {
+    needs_dedicated_thread_ = needs_dedicated_thread;
+  }
 
  private:
   // Name of extension, used for dispatching messages.
@@ -67,6 +76,8 @@ class XWalkExtension {
   // extra conversions later on.
   base::ListValue entry_points_;
 
+  bool needs_dedicated_thread_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExtension);
 };
 
@@ -89,15 +100,33 @@ class XWalkExtensionInstance {
   // can be sent after HandleSyncMessage() function returns.
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg);
 
+  // Allow to handle requests sent from JavaScript code using
+  // extension.sendRequest(). Unlike sync messages, the renderer doesn't block
+  // and many requests can be pending at the same time. Each request should be
+  // answered by calling SendReplyToJS() with the same |request_id|, which can
+  // happen after HandleRequest() returns.
+  virtual void HandleRequest(int request_id, scoped_ptr<base::Value> msg);
+
+  // Allow to handle binary messages sent from JavaScript code using
+  // extension.postBinaryMessage(). The |data| is owned by the caller and is
+  // only valid during the execution of this function.
+  virtual void HandleBinaryMessage(const char* data, size_t size);
+
   // Callbacks used by extension instance to communicate back to JS. These are
   // set by the extension system. Callbacks will take the ownership of the
   // message.
   typedef base::Callback<void(scoped_ptr<base::Value> msg)> PostMessageCallback;
   typedef base::Callback<void(scoped_ptr<base::Value> msg)>
       SendSyncReplyCallback;
+  typedef base::Callback<void(const char* data, size_t size)>
+      PostBinaryMessageCallback;
+  typedef base::Callback<void(int request_id, scoped_ptr<base::Value> reply)>
+      SendReplyCallback;
 
   void SetPostMessageCallback(const PostMessageCallback& callback);
   void SetSendSyncReplyCallback(const SendSyncReplyCallback& callback);
+  void SetPostBinaryMessageCallback(const PostBinaryMessageCallback& callback);
+  void SetSendReplyCallback(const SendReplyCallback& callback);
 
   // Function to be used by extensions Instances to post messages back to
   // JavaScript in the renderer process. This function will take the ownership
@@ -106,6 +135,19 @@ class XWalkExtensionInstance {
     post_message_.Run(msg.Pass());
   }
 
+  // Function to be used by extensions Instances to post raw bytes back to
+  // JavaScript, where they'll be received as an ArrayBuffer. The data is
+  // copied, so the caller keeps the ownership of |data|.
+  void PostBinaryMessageToJS(const char* data, size_t size) {
+    post_binary_message_.Run(data, size);
+  }
+
+  // Answers the request identified by |request_id|, resolving it in the
+  // JavaScript side. This function will take the ownership of the reply.
+  void SendReplyToJS(int request_id, scoped_ptr<base::Value> reply) {
+    send_reply_.Run(request_id, reply.Pass());
+  }
+
  protected:
   XWalkExtensionInstance();
 
@@ -117,6 +159,8 @@ class XWalkExtensionInstance {
  private:
   PostMessageCallback post_message_;
   SendSyncReplyCallback send_sync_reply_;
+  PostBinaryMessageCallback post_binary_message_;
+  SendReplyCallback send_reply_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionInstance);
 };
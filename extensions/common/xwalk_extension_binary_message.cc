@@ -0,0 +1,83 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+
+#include <string.h>
+#include "base/logging.h"
+#include "base/process/process_handle.h"
+
+#if defined(OS_ANDROID)
+#include "third_party/ashmem/ashmem.h"
+#elif defined(OS_POSIX)
+#include <sys/stat.h>
+#endif
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Returns whether the segment of |shared_memory| holds at least |size| bytes.
+// The size comes from the peer process, so it can't be trusted: mapping more
+// than the segment has and reading it would crash this process.
+bool SegmentHoldsSize(const base::SharedMemory& shared_memory,
+                      uint32_t size) {
+#if defined(OS_ANDROID)
+  int region_size = ashmem_get_size_region(shared_memory.handle().fd);
+  return region_size >= 0 && static_cast<uint32_t>(region_size) >= size;
+#elif defined(OS_POSIX)
+  struct stat st;
+  if (fstat(shared_memory.handle().fd, &st) != 0)
+    return false;
+  return st.st_size >= 0 && static_cast<uint64_t>(st.st_size) >= size;
+#else
+  // Segments are never sent on other platforms, see CopyToSharedMemory().
+  return false;
+#endif
+}
+
+}  // namespace
+
+const size_t kSharedBinaryMessageThreshold = 64 * 1024;
+
+bool CopyToSharedMemory(const char* data, size_t size,
+                        base::SharedMemoryHandle* handle) {
+  // On Windows sharing a segment requires the handle of the peer process,
+  // which isn't known by the extension server or client, so we always send
+  // the data inline there.
+#if defined(OS_POSIX)
+  base::SharedMemory shared_memory;
+  if (!shared_memory.CreateAndMapAnonymous(size))
+    return false;
+
+  memcpy(shared_memory.memory(), data, size);
+
+  // On POSIX the process handle is ignored, the file descriptor is duplicated
+  // and will be closed by the IPC layer once it was sent.
+  return shared_memory.GiveToProcess(base::GetCurrentProcessHandle(), handle);
+#else
+  return false;
+#endif
+}
+
+scoped_ptr<base::SharedMemory> MapSharedBinaryMessage(
+    base::SharedMemoryHandle handle, uint32_t size) {
+  scoped_ptr<base::SharedMemory> shared_memory(
+      new base::SharedMemory(handle, true));
+  if (!size || !SegmentHoldsSize(*shared_memory, size)) {
+    LOG(WARNING) << "Invalid size " << size << " for the shared memory of "
+                 << "a binary message.";
+    return scoped_ptr<base::SharedMemory>();
+  }
+  if (!shared_memory->Map(size)) {
+    LOG(WARNING) << "Couldn't map shared memory for binary message of size "
+                 << size << ".";
+    return scoped_ptr<base::SharedMemory>();
+  }
+  return shared_memory.Pass();
+}
+
+}  // namespace extensions
+}  // namespace xwalk
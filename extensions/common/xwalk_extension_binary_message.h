@@ -0,0 +1,53 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
+
+#include <stdint.h>
+#include <string>
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+
+namespace IPC {
+class Message;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Binary messages with at least this size are transferred using a shared
+// memory segment instead of being copied into the IPC message.
+extern const size_t kSharedBinaryMessageThreshold;
+
+// Copies |data| into a newly created shared memory segment. On success the
+// |handle| can be sent to the peer process, which becomes its owner. Returns
+// false if the segment couldn't be created.
+bool CopyToSharedMemory(const char* data, size_t size,
+                        base::SharedMemoryHandle* handle);
+
+// Maps a segment received in a shared binary message. Returns an empty
+// pointer if the segment couldn't be mapped, or if |size| is zero or larger
+// than the segment.
+scoped_ptr<base::SharedMemory> MapSharedBinaryMessage(
+    base::SharedMemoryHandle handle, uint32_t size);
+
+// Creates the IPC message carrying |data| to |instance_id|, choosing between
+// the inline (InlineMessage) and the shared memory (SharedMessage) variant
+// depending on the size of the payload.
+template <typename InlineMessage, typename SharedMessage>
+IPC::Message* CreateBinaryMessage(int64_t instance_id, const char* data,
+                                  size_t size) {
+  base::SharedMemoryHandle handle;
+  if (size >= kSharedBinaryMessageThreshold &&
+      CopyToSharedMemory(data, size, &handle)) {
+    return new SharedMessage(instance_id, handle, static_cast<uint32_t>(size));
+  }
+  return new InlineMessage(instance_id, std::string(data, size));
+}
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_BINARY_MESSAGE_H_
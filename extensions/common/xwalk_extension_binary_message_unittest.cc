@@ -0,0 +1,45 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+
+#include <string.h>
+#include <string>
+#include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::CopyToSharedMemory;
+using xwalk::extensions::MapSharedBinaryMessage;
+
+#if defined(OS_POSIX)
+
+TEST(XWalkExtensionBinaryMessageTest, MapsSegmentOfTheGivenSize) {
+  const std::string data(4096, 'x');
+  base::SharedMemoryHandle handle;
+  ASSERT_TRUE(CopyToSharedMemory(data.data(), data.size(), &handle));
+
+  scoped_ptr<base::SharedMemory> shared_memory =
+      MapSharedBinaryMessage(handle, data.size());
+  ASSERT_TRUE(shared_memory);
+  EXPECT_EQ(0, memcmp(data.data(), shared_memory->memory(), data.size()));
+}
+
+TEST(XWalkExtensionBinaryMessageTest, RejectsSizeLargerThanSegment) {
+  const std::string data(4096, 'x');
+  base::SharedMemoryHandle handle;
+  ASSERT_TRUE(CopyToSharedMemory(data.data(), data.size(), &handle));
+
+  EXPECT_FALSE(MapSharedBinaryMessage(handle, 64 * 1024 * 1024));
+}
+
+TEST(XWalkExtensionBinaryMessageTest, RejectsZeroSize) {
+  const std::string data(4096, 'x');
+  base::SharedMemoryHandle handle;
+  ASSERT_TRUE(CopyToSharedMemory(data.data(), data.size(), &handle));
+
+  EXPECT_FALSE(MapSharedBinaryMessage(handle, 0));
+}
+
+#endif  // defined(OS_POSIX)
@@ -0,0 +1,169 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
+
+#include <algorithm>
+#include "base/command_line.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+base::LazyInstance<XWalkExtensionMessageStats>::Leaky g_message_stats =
+    LAZY_INSTANCE_INITIALIZER;
+
+// The histograms named after an extension can't use the UMA macros, which
+// cache the histogram of the first name they see. They are cached by
+// XWalkExtensionMessageStats instead, histograms are never deleted.
+base::HistogramBase* GetExtensionTimeHistogram(
+    const std::string& name, const std::string& extension_name) {
+  return base::Histogram::FactoryTimeGet(
+      name + "." + extension_name,
+      base::TimeDelta::FromMilliseconds(1),
+      base::TimeDelta::FromSeconds(10),
+      50, base::HistogramBase::kUmaTargetedHistogramFlag);
+}
+
+int64 AverageInMicroseconds(base::TimeDelta total, uint64 count) {
+  if (!count)
+    return 0;
+  return (total / static_cast<int64>(count)).InMicroseconds();
+}
+
+}  // namespace
+
+XWalkExtensionMessageStats::ExtensionStats::ExtensionStats()
+    : queued_message_count(0),
+      sync_message_count(0) {
+  for (int i = 0; i < DIRECTION_COUNT; ++i) {
+    message_count[i] = 0;
+    byte_count[i] = 0;
+  }
+}
+
+// static
+XWalkExtensionMessageStats* XWalkExtensionMessageStats::GetInstance() {
+  return g_message_stats.Pointer();
+}
+
+XWalkExtensionMessageStats::ExtensionHistograms::ExtensionHistograms()
+    : queueing_time(NULL),
+      round_trip_time(NULL) {}
+
+XWalkExtensionMessageStats::XWalkExtensionMessageStats() {}
+
+XWalkExtensionMessageStats::~XWalkExtensionMessageStats() {}
+
+void XWalkExtensionMessageStats::RecordMessage(
+    const std::string& extension_name, Direction direction, size_t size) {
+  DCHECK_LT(direction, DIRECTION_COUNT);
+  if (direction == TO_NATIVE)
+    UMA_HISTOGRAM_COUNTS("XWalk.Extensions.MessageSizeToNative", size);
+  else
+    UMA_HISTOGRAM_COUNTS("XWalk.Extensions.MessageSizeToJS", size);
+
+  base::AutoLock l(lock_);
+  ExtensionStats& stats = stats_[extension_name];
+  stats.message_count[direction]++;
+  stats.byte_count[direction] += size;
+}
+
+void XWalkExtensionMessageStats::RecordQueueingTime(
+    const std::string& extension_name, base::TimeDelta queueing_time) {
+  UMA_HISTOGRAM_TIMES("XWalk.Extensions.MessageQueueingTime", queueing_time);
+
+  base::HistogramBase* histogram;
+  {
+    base::AutoLock l(lock_);
+    ExtensionStats& stats = stats_[extension_name];
+    stats.queued_message_count++;
+    stats.total_queueing_time += queueing_time;
+    stats.max_queueing_time = std::max(stats.max_queueing_time, queueing_time);
+
+    ExtensionHistograms& histograms = histograms_[extension_name];
+    if (!histograms.queueing_time) {
+      histograms.queueing_time = GetExtensionTimeHistogram(
+          "XWalk.Extensions.MessageQueueingTime", extension_name);
+    }
+    histogram = histograms.queueing_time;
+  }
+  histogram->AddTime(queueing_time);
+}
+
+void XWalkExtensionMessageStats::RecordSyncRoundTripTime(
+    const std::string& extension_name, base::TimeDelta round_trip_time) {
+  UMA_HISTOGRAM_TIMES("XWalk.Extensions.SyncMessageRoundTripTime",
+                      round_trip_time);
+
+  base::HistogramBase* histogram;
+  {
+    base::AutoLock l(lock_);
+    ExtensionStats& stats = stats_[extension_name];
+    stats.sync_message_count++;
+    stats.total_round_trip_time += round_trip_time;
+    stats.max_round_trip_time =
+        std::max(stats.max_round_trip_time, round_trip_time);
+
+    ExtensionHistograms& histograms = histograms_[extension_name];
+    if (!histograms.round_trip_time) {
+      histograms.round_trip_time = GetExtensionTimeHistogram(
+          "XWalk.Extensions.SyncMessageRoundTripTime", extension_name);
+    }
+    histogram = histograms.round_trip_time;
+  }
+  histogram->AddTime(round_trip_time);
+}
+
+bool XWalkExtensionMessageStats::GetStats(const std::string& extension_name,
+                                          ExtensionStats* stats) const {
+  base::AutoLock l(lock_);
+  StatsMap::const_iterator it = stats_.find(extension_name);
+  if (it == stats_.end())
+    return false;
+  *stats = it->second;
+  return true;
+}
+
+void XWalkExtensionMessageStats::Dump() const {
+  base::AutoLock l(lock_);
+  StatsMap::const_iterator it = stats_.begin();
+  for (; it != stats_.end(); ++it) {
+    const ExtensionStats& stats = it->second;
+    LOG(INFO) << "Extension '" << it->first << "': "
+              << stats.message_count[TO_NATIVE] << " messages ("
+              << stats.byte_count[TO_NATIVE] << " bytes) to native, "
+              << stats.message_count[TO_JS] << " messages ("
+              << stats.byte_count[TO_JS] << " bytes) to JS, "
+              << "average queueing time "
+              << AverageInMicroseconds(stats.total_queueing_time,
+                                       stats.queued_message_count)
+              << "us, max queueing time "
+              << stats.max_queueing_time.InMicroseconds() << "us, "
+              << stats.sync_message_count << " sync messages, average round"
+              << " trip time "
+              << AverageInMicroseconds(stats.total_round_trip_time,
+                                       stats.sync_message_count)
+              << "us, max round trip time "
+              << stats.max_round_trip_time.InMicroseconds() << "us.";
+  }
+}
+
+void XWalkExtensionMessageStats::DumpIfRequested() const {
+  if (CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkDumpExtensionMessageStats))
+    Dump();
+}
+
+void XWalkExtensionMessageStats::Reset() {
+  base::AutoLock l(lock_);
+  stats_.clear();
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,104 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_STATS_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_STATS_H_
+
+#include <map>
+#include <string>
+#include "base/basictypes.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class HistogramBase;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// Collects, per extension, statistics about the messages exchanged between
+// the extension instances and their JavaScript code: how many messages and
+// bytes went in each direction, how long the messages waited in the
+// extension thread before being handled and how long the sync messages took
+// to be answered. Each process has its own statistics.
+//
+// Besides keeping the totals, each sample is added to the UMA histograms.
+// When the switch kXWalkDumpExtensionMessageStats is present, the totals are
+// logged at shutdown, see DumpIfRequested().
+//
+// Can be used from any thread.
+class XWalkExtensionMessageStats {
+ public:
+  enum Direction {
+    TO_NATIVE,
+    TO_JS,
+    DIRECTION_COUNT
+  };
+
+  struct ExtensionStats {
+    ExtensionStats();
+
+    uint64 message_count[DIRECTION_COUNT];
+    uint64 byte_count[DIRECTION_COUNT];
+
+    // Time between a message arriving and the extension thread handling it.
+    uint64 queued_message_count;
+    base::TimeDelta total_queueing_time;
+    base::TimeDelta max_queueing_time;
+
+    // Time the JavaScript code was blocked waiting for a sync reply.
+    uint64 sync_message_count;
+    base::TimeDelta total_round_trip_time;
+    base::TimeDelta max_round_trip_time;
+  };
+
+  static XWalkExtensionMessageStats* GetInstance();
+
+  void RecordMessage(const std::string& extension_name, Direction direction,
+                     size_t size);
+  void RecordQueueingTime(const std::string& extension_name,
+                          base::TimeDelta queueing_time);
+  void RecordSyncRoundTripTime(const std::string& extension_name,
+                               base::TimeDelta round_trip_time);
+
+  bool GetStats(const std::string& extension_name,
+                ExtensionStats* stats) const;
+
+  void Dump() const;
+  void DumpIfRequested() const;
+
+  // Only used by tests.
+  void Reset();
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<XWalkExtensionMessageStats>;
+
+  XWalkExtensionMessageStats();
+  ~XWalkExtensionMessageStats();
+
+  // The histograms of each extension, looked up only once.
+  struct ExtensionHistograms {
+    ExtensionHistograms();
+
+    base::HistogramBase* queueing_time;
+    base::HistogramBase* round_trip_time;
+  };
+
+  mutable base::Lock lock_;
+
+  typedef std::map<std::string, ExtensionStats> StatsMap;
+  StatsMap stats_;
+
+  typedef std::map<std::string, ExtensionHistograms> HistogramMap;
+  HistogramMap histograms_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionMessageStats);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_MESSAGE_STATS_H_
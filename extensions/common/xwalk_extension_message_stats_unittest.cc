@@ -0,0 +1,44 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionMessageStats;
+
+TEST(XWalkExtensionMessageStatsTest, StatsAreKeptPerExtension) {
+  XWalkExtensionMessageStats* message_stats =
+      XWalkExtensionMessageStats::GetInstance();
+  message_stats->Reset();
+
+  message_stats->RecordMessage("echo", XWalkExtensionMessageStats::TO_NATIVE,
+                               10);
+  message_stats->RecordMessage("echo", XWalkExtensionMessageStats::TO_NATIVE,
+                               20);
+  message_stats->RecordMessage("echo", XWalkExtensionMessageStats::TO_JS, 5);
+  message_stats->RecordQueueingTime("echo",
+                                    base::TimeDelta::FromMilliseconds(3));
+  message_stats->RecordQueueingTime("echo",
+                                    base::TimeDelta::FromMilliseconds(1));
+  message_stats->RecordSyncRoundTripTime("sync",
+                                         base::TimeDelta::FromMilliseconds(7));
+
+  XWalkExtensionMessageStats::ExtensionStats stats;
+  ASSERT_TRUE(message_stats->GetStats("echo", &stats));
+  EXPECT_EQ(2u, stats.message_count[XWalkExtensionMessageStats::TO_NATIVE]);
+  EXPECT_EQ(30u, stats.byte_count[XWalkExtensionMessageStats::TO_NATIVE]);
+  EXPECT_EQ(1u, stats.message_count[XWalkExtensionMessageStats::TO_JS]);
+  EXPECT_EQ(5u, stats.byte_count[XWalkExtensionMessageStats::TO_JS]);
+  EXPECT_EQ(2u, stats.queued_message_count);
+  EXPECT_EQ(4, stats.total_queueing_time.InMilliseconds());
+  EXPECT_EQ(3, stats.max_queueing_time.InMilliseconds());
+  EXPECT_EQ(0u, stats.sync_message_count);
+
+  ASSERT_TRUE(message_stats->GetStats("sync", &stats));
+  EXPECT_EQ(1u, stats.sync_message_count);
+  EXPECT_EQ(7, stats.max_round_trip_time.InMilliseconds());
+
+  EXPECT_FALSE(message_stats->GetStats("unknown", &stats));
+}
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include "base/memory/shared_memory.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_message_macros.h"
@@ -27,9 +28,18 @@ enum {
 IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_RegisterExtensions,  // NOLINT(*)
                      base::FilePath /* extensions path */)
 
+// Asks the Extension Process to create a channel for a Render Process. A
+// shared Extension Process receives one of these for each Render Process.
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CreateRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
+IPC_MESSAGE_CONTROL1(XWalkExtensionProcessMsg_CloseRenderProcessChannel,  // NOLINT(*)
+                     int /* render process id */)
+
 // This implies that extensions are all loaded and Extension Process
-// is ready to be used.
-IPC_MESSAGE_CONTROL1(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
+// is ready to be used by the Render Process.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessHostMsg_RenderProcessChannelCreated, // NOLINT(*)
+                     int /* render process id */,
                      IPC::ChannelHandle /* channel id */)
 
 // Message from Render Process to Browser Process. This message needs
@@ -44,9 +54,13 @@ IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionProcessHostMsg_GetExtensionProcessChan
 #undef IPC_MESSAGE_START
 #define IPC_MESSAGE_START XWalkExtensionClientServerMsgStart
 
+// Only the hash and size of the JavaScript API travel at registration, the
+// source itself is requested with XWalkExtensionServerMsg_GetExtensionAPI the
+// first time the extension is used.
 IPC_STRUCT_BEGIN(XWalkExtensionServerMsg_ExtensionRegisterParams)
   IPC_STRUCT_MEMBER(std::string, name)
-  IPC_STRUCT_MEMBER(std::string, js_api)
+  IPC_STRUCT_MEMBER(uint32_t, js_api_hash)
+  IPC_STRUCT_MEMBER(uint32_t, js_api_size)
   IPC_STRUCT_MEMBER(std::vector<std::string>, entry_points)
 IPC_STRUCT_END()
 
@@ -62,6 +76,45 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
                      int64_t /* instance id */,
                      base::ListValue /* contents */)
 
+// Used when message batching is enabled in the server, each element of the
+// list is a message posted by the instance, in the order they were posted.
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessagesToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::ListValue /* messages */)
+
+// Binary messages carry raw bytes and skip the base::Value conversion. Small
+// payloads are copied in the message itself, larger ones are written to a
+// shared memory segment and only its handle travels through the channel.
+IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostBinaryMessageToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::string /* data */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_PostSharedBinaryMessageToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::SharedMemoryHandle /* data */,
+                     uint32_t /* size */)
+
+IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostBinaryMessageToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     std::string /* data */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostSharedBinaryMessageToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     base::SharedMemoryHandle /* data */,
+                     uint32_t /* size */)
+
+// Asynchronous request/reply pair. The request id is chosen by the client and
+// used to match the reply, so many requests can be in flight per instance.
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_SendRequestToNative,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     base::ListValue /* contents */)
+
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostReplyToJS,  // NOLINT(*)
+                     int64_t /* instance id */,
+                     int /* request id */,
+                     base::ListValue /* contents */)
+
 IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
                             int64_t /* instance id */,
                             base::ListValue /* input contents */,
@@ -70,6 +123,10 @@ IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  //
 IPC_SYNC_MESSAGE_CONTROL0_1(XWalkExtensionServerMsg_GetExtensions,  // NOLINT(*)
                             std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams> /* output contents */) // NOLINT(*)
 
+IPC_SYNC_MESSAGE_CONTROL1_1(XWalkExtensionServerMsg_GetExtensionAPI,  // NOLINT(*)
+                            std::string /* extension name */,
+                            std::string /* JavaScript API */)
+
 IPC_MESSAGE_CONTROL1(XWalkExtensionServerMsg_DestroyInstance,  // NOLINT(*)
                      int64_t /* instance id */)
 
@@ -4,30 +4,159 @@
 
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/debug/trace_event.h"
 #include "base/file_util.h"
 #include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
+#include "base/hash.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/sequenced_task_runner.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_sender.h"
+#include "ipc/ipc_sync_message.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
 namespace extensions {
 
+// Holds the messages posted to JS that weren't sent yet when batching is
+// enabled. Messages can be posted from any thread, so the pending batches are
+// protected by a lock. It's reference counted because the delayed tasks that
+// flush the batches might outlive the server.
+class XWalkExtensionServer::MessageBatcher
+    : public base::RefCountedThreadSafe<MessageBatcher> {
+ public:
+  MessageBatcher(XWalkExtensionServer* server,
+                 scoped_refptr<base::SequencedTaskRunner> task_runner,
+                 base::TimeDelta window, size_t max_batch_size)
+      : server_(server),
+        task_runner_(task_runner),
+        window_(window),
+        max_batch_size_(max_batch_size) {}
+
+  void AddMessage(int64_t instance_id, scoped_ptr<base::Value> msg) {
+    base::AutoLock l(lock_);
+    if (!server_)
+      return;
+
+    base::ListValue*& batch = pending_batches_[instance_id];
+    if (!batch) {
+      batch = new base::ListValue;
+      task_runner_->PostDelayedTask(
+          FROM_HERE,
+          base::Bind(&MessageBatcher::Flush, this, instance_id),
+          window_);
+    }
+
+    batch->Append(msg.release());
+    if (batch->GetSize() >= max_batch_size_)
+      FlushLocked(instance_id);
+  }
+
+  // Sends the pending batch for |instance_id|, if any. Called when the window
+  // expires, but also before other messages to the same instance that must
+  // not overtake the batch.
+  void Flush(int64_t instance_id) {
+    base::AutoLock l(lock_);
+    FlushLocked(instance_id);
+  }
+
+  // Drops all the pending batches and stops using the server.
+  void Invalidate() {
+    base::AutoLock l(lock_);
+    server_ = NULL;
+    STLDeleteValues(&pending_batches_);
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<MessageBatcher>;
+
+  ~MessageBatcher() {
+    STLDeleteValues(&pending_batches_);
+  }
+
+  void FlushLocked(int64_t instance_id) {
+    lock_.AssertAcquired();
+    PendingBatchesMap::iterator it = pending_batches_.find(instance_id);
+    if (it == pending_batches_.end())
+      return;
+
+    scoped_ptr<base::ListValue> batch(it->second);
+    pending_batches_.erase(it);
+    if (server_)
+      server_->SendMessagesToJS(instance_id, batch.Pass());
+  }
+
+  base::Lock lock_;
+  XWalkExtensionServer* server_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  base::TimeDelta window_;
+  size_t max_batch_size_;
+
+  typedef std::map<int64_t, base::ListValue*> PendingBatchesMap;
+  PendingBatchesMap pending_batches_;
+
+  DISALLOW_COPY_AND_ASSIGN(MessageBatcher);
+};
+
 XWalkExtensionServer::XWalkExtensionServer()
-    : sender_(NULL) {}
+    : sender_(NULL),
+      messages_posted_to_js_(0),
+      ipc_messages_posted_to_js_(0) {}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
+  if (message_batcher_)
+    message_batcher_->Invalidate();
   DeleteInstanceMap();
-  STLDeleteValues(&extensions_);
+
+  ExtensionMap::iterator it = extensions_.begin();
+  for (; it != extensions_.end(); ++it) {
+    if (!ContainsKey(borrowed_extensions_, it->first))
+      delete it->second;
+  }
 }
 
+namespace {
+
+// All the messages handled by the server, except the ones asking for the
+// extensions, have the instance id as first parameter.
+bool ReadInstanceId(const IPC::Message& message, int64_t* instance_id) {
+  if (message.type() == XWalkExtensionServerMsg_GetExtensions::ID ||
+      message.type() == XWalkExtensionServerMsg_GetExtensionAPI::ID)
+    return false;
+  PickleIterator iter = message.is_sync() ?
+      IPC::SyncMessage::GetDataIterator(&message) : PickleIterator(message);
+  return iter.ReadInt64(instance_id);
+}
+
+}  // namespace
+
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
+  // Instances are not known until created, so CreateInstance is not counted.
+  std::string extension_name;
+  int64_t instance_id;
+  if (ReadInstanceId(message, &instance_id))
+    extension_name = GetExtensionNameForInstance(instance_id);
+  if (!extension_name.empty()) {
+    XWalkExtensionMessageStats::GetInstance()->RecordMessage(
+        extension_name, XWalkExtensionMessageStats::TO_NATIVE,
+        message.size());
+  }
+  TRACE_EVENT2("xwalk", "XWalkExtensionServer::OnMessageReceived",
+               "extension", TRACE_STR_COPY(extension_name.c_str()),
+               "size", message.size());
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionServer, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_CreateInstance,
@@ -36,11 +165,20 @@ bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
         OnDestroyInstance)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostMessageToNative,
         OnPostMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_PostBinaryMessageToNative,
+        OnPostBinaryMessageToNative)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionServerMsg_PostSharedBinaryMessageToNative,
+        OnPostSharedBinaryMessageToNative)
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionServerMsg_SendSyncMessageToNative,
         OnSendSyncMessageToNative)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_SendRequestToNative,
+        OnSendRequestToNative)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensions,
         OnGetExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_GetExtensionAPI,
+        OnGetExtensionAPI)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -66,24 +204,33 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
                  base::Unretained(this), instance_id));
 
+  instance->SetPostBinaryMessageCallback(
+      base::Bind(&XWalkExtensionServer::PostBinaryMessageToJSCallback,
+                 base::Unretained(this), instance_id));
+
+  instance->SetSendReplyCallback(
+      base::Bind(&XWalkExtensionServer::SendReplyToJSCallback,
+                 base::Unretained(this), instance_id));
+
   InstanceExecutionData data;
   data.instance = instance;
+  data.extension_name = name;
   data.pending_reply = NULL;
+  data.task_runner = base::MessageLoopProxy::current();
 
+  base::AutoLock l(instances_lock_);
   instances_[instance_id] = data;
 }
 
 void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
     const base::ListValue& msg) {
-  InstanceMap::const_iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
+  XWalkExtensionInstance* instance = GetInstance(instance_id);
+  if (!instance) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
                  << instance_id;
     return;
   }
 
-  const InstanceExecutionData& data = it->second;
-
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
   // have param traits for serialization) and we pass the ownership to to
@@ -92,7 +239,65 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   scoped_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  data.instance->HandleMessage(value.Pass());
+  instance->HandleMessage(value.Pass());
+}
+
+XWalkExtensionInstance* XWalkExtensionServer::GetInstance(
+    int64_t instance_id) {
+  base::AutoLock l(instances_lock_);
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end())
+    return NULL;
+  return it->second.instance;
+}
+
+std::string XWalkExtensionServer::GetExtensionNameForInstance(
+    int64_t instance_id) {
+  base::AutoLock l(instances_lock_);
+  InstanceMap::const_iterator it = instances_.find(instance_id);
+  if (it == instances_.end())
+    return std::string();
+  return it->second.extension_name;
+}
+
+void XWalkExtensionServer::RecordMessageToJS(int64_t instance_id,
+                                             size_t size) {
+  std::string extension_name = GetExtensionNameForInstance(instance_id);
+  if (extension_name.empty())
+    return;
+  XWalkExtensionMessageStats::GetInstance()->RecordMessage(
+      extension_name, XWalkExtensionMessageStats::TO_JS, size);
+}
+
+void XWalkExtensionServer::OnPostBinaryMessageToNative(int64_t instance_id,
+    const std::string& data) {
+  XWalkExtensionInstance* instance = GetInstance(instance_id);
+  if (!instance) {
+    LOG(WARNING) << "Can't PostBinaryMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  instance->HandleBinaryMessage(data.data(), data.size());
+}
+
+void XWalkExtensionServer::OnPostSharedBinaryMessageToNative(
+    int64_t instance_id, base::SharedMemoryHandle handle, uint32_t size) {
+  // Map the segment even if the instance is gone, so the handle is closed.
+  scoped_ptr<base::SharedMemory> shared_memory =
+      MapSharedBinaryMessage(handle, size);
+  if (!shared_memory)
+    return;
+
+  XWalkExtensionInstance* instance = GetInstance(instance_id);
+  if (!instance) {
+    LOG(WARNING) << "Can't PostBinaryMessage to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  instance->HandleBinaryMessage(
+      static_cast<const char*>(shared_memory->memory()), size);
 }
 
 void XWalkExtensionServer::Initialize(IPC::Sender* sender) {
@@ -108,6 +313,65 @@ bool XWalkExtensionServer::Send(IPC::Message* msg) {
   return sender_->Send(msg);
 }
 
+bool XWalkExtensionServer::SendToJS(int64_t instance_id, IPC::Message* msg,
+                                    size_t message_count) {
+  RecordMessageToJS(instance_id, msg->size());
+
+  base::AutoLock l(sender_lock_);
+  if (!sender_)
+    return false;
+  messages_posted_to_js_ += message_count;
+  ipc_messages_posted_to_js_++;
+  return sender_->Send(msg);
+}
+
+void XWalkExtensionServer::EnableMessageBatching(
+    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    base::TimeDelta window, size_t max_batch_size) {
+  DCHECK(!message_batcher_);
+  DCHECK_GT(max_batch_size, 0u);
+  message_batcher_ = new MessageBatcher(this, task_runner, window,
+                                        max_batch_size);
+}
+
+void XWalkExtensionServer::EnableMessageBatchingFromCommandLine(
+    scoped_refptr<base::SequencedTaskRunner> task_runner) {
+  const size_t kDefaultMaxBatchSize = 64;
+
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  int window_in_ms = 0;
+  if (!base::StringToInt(cmd_line->GetSwitchValueASCII(
+          switches::kXWalkExtensionMessageBatchingWindow), &window_in_ms) ||
+      window_in_ms <= 0)
+    return;
+
+  size_t max_batch_size = kDefaultMaxBatchSize;
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionMessageBatchingSize)) {
+    if (!base::StringToSizeT(cmd_line->GetSwitchValueASCII(
+            switches::kXWalkExtensionMessageBatchingSize), &max_batch_size) ||
+        max_batch_size == 0) {
+      LOG(WARNING) << "Invalid value for --"
+                   << switches::kXWalkExtensionMessageBatchingSize
+                   << ", using default.";
+      max_batch_size = kDefaultMaxBatchSize;
+    }
+  }
+
+  EnableMessageBatching(task_runner,
+                        base::TimeDelta::FromMilliseconds(window_in_ms),
+                        max_batch_size);
+}
+
+uint64 XWalkExtensionServer::messages_posted_to_js() const {
+  base::AutoLock l(sender_lock_);
+  return messages_posted_to_js_;
+}
+
+uint64 XWalkExtensionServer::ipc_messages_posted_to_js() const {
+  base::AutoLock l(sender_lock_);
+  return ipc_messages_posted_to_js_;
+}
+
 namespace {
 
 bool ValidateExtensionIdentifier(const std::string& name) {
@@ -176,30 +440,111 @@ bool XWalkExtensionServer::RegisterExtension(
   return true;
 }
 
+void XWalkExtensionServer::RegisterExtensionsFrom(
+    const XWalkExtensionServer& server) {
+  DCHECK(extensions_.empty());
+  extensions_ = server.extensions_;
+  extension_symbols_ = server.extension_symbols_;
+
+  ExtensionMap::const_iterator it = extensions_.begin();
+  for (; it != extensions_.end(); ++it)
+    borrowed_extensions_.insert(it->first);
+}
+
+std::vector<std::string> XWalkExtensionServer::GetExtensionNames() const {
+  std::vector<std::string> names;
+  ExtensionMap::const_iterator it = extensions_.begin();
+  for (; it != extensions_.end(); ++it)
+    names.push_back(it->first);
+  return names;
+}
+
+bool XWalkExtensionServer::ExtensionNeedsDedicatedThread(
+    const std::string& name) const {
+  ExtensionMap::const_iterator it = extensions_.find(name);
+  return it != extensions_.end() && it->second->needs_dedicated_thread();
+}
+
 void XWalkExtensionServer::PostMessageToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
+  if (message_batcher_) {
+    message_batcher_->AddMessage(instance_id, msg.Pass());
+    return;
+  }
+
   base::ListValue wrapped_msg;
   wrapped_msg.Append(msg.release());
-  Send(new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+  SendToJS(instance_id,
+           new XWalkExtensionClientMsg_PostMessageToJS(instance_id,
+                                                       wrapped_msg), 1);
+}
+
+void XWalkExtensionServer::SendMessagesToJS(
+    int64_t instance_id, scoped_ptr<base::ListValue> msgs) {
+  const size_t message_count = msgs->GetSize();
+  if (message_count == 1) {
+    SendToJS(instance_id,
+             new XWalkExtensionClientMsg_PostMessageToJS(instance_id, *msgs),
+             1);
+    return;
+  }
+  SendToJS(instance_id,
+           new XWalkExtensionClientMsg_PostMessagesToJS(instance_id, *msgs),
+           message_count);
+}
+
+void XWalkExtensionServer::PostBinaryMessageToJSCallback(
+    int64_t instance_id, const char* data, size_t size) {
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+  IPC::Message* msg =
+      CreateBinaryMessage<XWalkExtensionClientMsg_PostBinaryMessageToJS,
+                          XWalkExtensionClientMsg_PostSharedBinaryMessageToJS>(
+                              instance_id, data, size);
+  // Large payloads travel in shared memory, so count the payload instead.
+  RecordMessageToJS(instance_id, size);
+  Send(msg);
+}
+
+void XWalkExtensionServer::SendReplyToJSCallback(
+    int64_t instance_id, int request_id, scoped_ptr<base::Value> reply) {
+  // Messages posted before the reply should be delivered first.
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+
+  base::ListValue wrapped_reply;
+  wrapped_reply.Append(reply.release());
+  IPC::Message* msg = new XWalkExtensionClientMsg_PostReplyToJS(
+      instance_id, request_id, wrapped_reply);
+  RecordMessageToJS(instance_id, msg->size());
+  Send(msg);
 }
 
 void XWalkExtensionServer::SendSyncReplyToJSCallback(
     int64_t instance_id, scoped_ptr<base::Value> reply) {
+  IPC::Message* pending_reply = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
 
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
-    return;
+    pending_reply = it->second.pending_reply;
+    it->second.pending_reply = NULL;
   }
 
-  InstanceExecutionData& data = it->second;
-  if (!data.pending_reply) {
+  if (!pending_reply) {
     LOG(WARNING) << "There's no pending SyncMessage for instance id: "
                  << instance_id;
     return;
   }
 
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
+
   base::ListValue wrapped_reply;
   wrapped_reply.Append(reply.release());
 
@@ -208,17 +553,44 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
   // improved in ipc_message_utils.h so we don't need to inline the code here.
   XWalkExtensionServerMsg_SendSyncMessageToNative::ReplyParam
       reply_param(wrapped_reply);
-  IPC::WriteParam(data.pending_reply, reply_param);
-  Send(data.pending_reply);
-
-  data.pending_reply = NULL;
+  IPC::WriteParam(pending_reply, reply_param);
+  RecordMessageToJS(instance_id, pending_reply->size());
+  Send(pending_reply);
 }
 
 void XWalkExtensionServer::DeleteInstanceMap() {
-  InstanceMap::iterator it = instances_.begin();
+  InstanceMap instances;
+  {
+    base::AutoLock l(instances_lock_);
+    instances.swap(instances_);
+  }
+  DeleteInstances(&instances);
+}
+
+void XWalkExtensionServer::DeleteInstancesOnCurrentThread() {
+  InstanceMap instances;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.begin();
+    while (it != instances_.end()) {
+      const InstanceExecutionData& data = it->second;
+      if (data.task_runner && !data.task_runner->RunsTasksOnCurrentThread()) {
+        ++it;
+        continue;
+      }
+      instances.insert(*it);
+      instances_.erase(it++);
+    }
+  }
+  DeleteInstances(&instances);
+}
+
+// static
+void XWalkExtensionServer::DeleteInstances(InstanceMap* instances) {
+  InstanceMap::iterator it = instances->begin();
   int pending_replies_left = 0;
 
-  for (; it != instances_.end(); ++it) {
+  for (; it != instances->end(); ++it) {
     delete it->second.instance;
     if (it->second.pending_reply) {
       pending_replies_left++;
@@ -226,7 +598,7 @@ void XWalkExtensionServer::DeleteInstanceMap() {
     }
   }
 
-  instances_.clear();
+  instances->clear();
 
   if (pending_replies_left > 0) {
     LOG(WARNING) << pending_replies_left
@@ -258,21 +630,26 @@ bool XWalkExtensionServer::ValidateExtensionEntryPoints(
 
 void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
     const base::ListValue& msg, IPC::Message* ipc_reply) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
-                 << instance_id;
-    return;
-  }
+  XWalkExtensionInstance* instance = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't SendSyncMessage to invalid Extension instance id: "
+                   << instance_id;
+      return;
+    }
 
-  InstanceExecutionData& data = it->second;
-  if (data.pending_reply) {
-    LOG(WARNING) << "There's already a pending Sync Message for "
-                 << "Extension instance id: " << instance_id;
-    return;
-  }
+    InstanceExecutionData& data = it->second;
+    if (data.pending_reply) {
+      LOG(WARNING) << "There's already a pending Sync Message for "
+                   << "Extension instance id: " << instance_id;
+      return;
+    }
 
-  data.pending_reply = ipc_reply;
+    data.pending_reply = ipc_reply;
+    instance = data.instance;
+  }
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
@@ -282,22 +659,43 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   // can be costly depending on the size of Value.
   scoped_ptr<base::Value> value;
   const_cast<base::ListValue*>(&msg)->Remove(0, &value);
-  XWalkExtensionInstance* instance = data.instance;
-
   instance->HandleSyncMessage(value.Pass());
 }
 
-void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
-  InstanceMap::iterator it = instances_.find(instance_id);
-  if (it == instances_.end()) {
-    LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
+void XWalkExtensionServer::OnSendRequestToNative(int64_t instance_id,
+    int request_id, const base::ListValue& msg) {
+  XWalkExtensionInstance* instance = GetInstance(instance_id);
+  if (!instance) {
+    LOG(WARNING) << "Can't SendRequest to invalid Extension instance id: "
+                 << instance_id;
     return;
   }
 
-  InstanceExecutionData& data = it->second;
+  // See OnPostMessageToNative() about the const_cast.
+  scoped_ptr<base::Value> value;
+  const_cast<base::ListValue*>(&msg)->Remove(0, &value);
+  instance->HandleRequest(request_id, value.Pass());
+}
+
+void XWalkExtensionServer::OnDestroyInstance(int64_t instance_id) {
+  XWalkExtensionInstance* instance = NULL;
+  {
+    base::AutoLock l(instances_lock_);
+    InstanceMap::iterator it = instances_.find(instance_id);
+    if (it == instances_.end()) {
+      LOG(WARNING) << "Can't destroy inexistent instance:" << instance_id;
+      return;
+    }
+
+    instance = it->second.instance;
+    instances_.erase(it);
+  }
+
+  delete instance;
 
-  delete data.instance;
-  instances_.erase(it);
+  // Deliver messages posted by the instance before it was destroyed.
+  if (message_batcher_)
+    message_batcher_->Flush(instance_id);
 
   Send(new XWalkExtensionClientMsg_InstanceDestroyed(instance_id));
 }
@@ -310,7 +708,9 @@ void XWalkExtensionServer::OnGetExtensions(
     XWalkExtension* extension = it->second;
 
     extension_parameters.name = extension->name();
-    extension_parameters.js_api = extension->javascript_api();
+    const std::string& js_api = extension->javascript_api();
+    extension_parameters.js_api_hash = base::Hash(js_api);
+    extension_parameters.js_api_size = js_api.size();
 
     const base::ListValue& entry_points = extension->entry_points();
     base::ListValue::const_iterator entry_it = entry_points.begin();
@@ -324,7 +724,21 @@ void XWalkExtensionServer::OnGetExtensions(
   }
 }
 
+void XWalkExtensionServer::OnGetExtensionAPI(const std::string& name,
+                                             std::string* js_api) {
+  ExtensionMap::const_iterator it = extensions_.find(name);
+  if (it == extensions_.end()) {
+    LOG(WARNING) << "Can't get JavaScript API of extension: " << name
+        << ". Extension is not registered.";
+    return;
+  }
+  *js_api = it->second->javascript_api();
+}
+
 void XWalkExtensionServer::Invalidate() {
+  if (message_batcher_)
+    message_batcher_->Invalidate();
+
   base::AutoLock l(sender_lock_);
   sender_ = NULL;
 }
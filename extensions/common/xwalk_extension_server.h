@@ -11,7 +11,10 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
+#include "base/memory/shared_memory.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
@@ -20,6 +23,7 @@ struct XWalkExtensionServerMsg_ExtensionRegisterParams;
 
 namespace base {
 class FilePath;
+class SequencedTaskRunner;
 }
 
 namespace content {
@@ -54,40 +58,121 @@ class XWalkExtensionServer : public IPC::Listener {
 
   bool RegisterExtension(scoped_ptr<XWalkExtension> extension);
 
+  // Makes the extensions registered in |server| available to the client of
+  // this server as well, so a process can serve many clients while loading
+  // each extension only once. The extensions are still owned by |server|,
+  // which must outlive this server.
+  void RegisterExtensionsFrom(const XWalkExtensionServer& server);
+
+  std::vector<std::string> GetExtensionNames() const;
+  bool ExtensionNeedsDedicatedThread(const std::string& name) const;
+
+  // Messages for instances of different extensions may be handled in
+  // different threads, see XWalkExtensionScheduler. Each instance should be
+  // deleted in the thread it was created, so before deleting the server this
+  // must be called on each of those threads.
+  void DeleteInstancesOnCurrentThread();
+
   void Invalidate();
 
+  // Coalesces the messages posted to JS by each instance, so the ones posted
+  // within |window| are delivered in a single IPC message. A batch is sent
+  // earlier when it reaches |max_batch_size| messages. The |task_runner|
+  // should be the one where the server handles its messages.
+  void EnableMessageBatching(
+      scoped_refptr<base::SequencedTaskRunner> task_runner,
+      base::TimeDelta window, size_t max_batch_size);
+
+  // Calls EnableMessageBatching() if the window was set in the command line,
+  // see switches::kXWalkExtensionMessageBatchingWindow.
+  void EnableMessageBatchingFromCommandLine(
+      scoped_refptr<base::SequencedTaskRunner> task_runner);
+
+  // Number of messages posted to JS by the instances, and number of IPC
+  // messages used to deliver them. They only differ when batching is enabled.
+  uint64 messages_posted_to_js() const;
+  uint64 ipc_messages_posted_to_js() const;
+
  private:
+  class MessageBatcher;
+
   struct InstanceExecutionData {
     XWalkExtensionInstance* instance;
+    std::string extension_name;
     IPC::Message* pending_reply;
+    // Where the instance was created, NULL if there was no message loop.
+    scoped_refptr<base::SequencedTaskRunner> task_runner;
   };
 
+  typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
+
   // Message Handlers
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnDestroyInstance(int64_t instance_id);
   void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
+  void OnPostBinaryMessageToNative(int64_t instance_id,
+                                   const std::string& data);
+  void OnPostSharedBinaryMessageToNative(int64_t instance_id,
+                                         base::SharedMemoryHandle handle,
+                                         uint32_t size);
   void OnSendSyncMessageToNative(int64_t instance_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
+  void OnSendRequestToNative(int64_t instance_id, int request_id,
+                             const base::ListValue& msg);
   void OnGetExtensions(
       std::vector<XWalkExtensionServerMsg_ExtensionRegisterParams>* reply);
+  void OnGetExtensionAPI(const std::string& name, std::string* js_api);
 
   void PostMessageToJSCallback(int64_t instance_id,
                                scoped_ptr<base::Value> msg);
 
+  // Used by MessageBatcher to deliver a batch of messages.
+  void SendMessagesToJS(int64_t instance_id,
+                        scoped_ptr<base::ListValue> msgs);
+
   void SendSyncReplyToJSCallback(int64_t instance_id,
                                  scoped_ptr<base::Value> reply);
 
+  void PostBinaryMessageToJSCallback(int64_t instance_id,
+                                     const char* data, size_t size);
+
+  void SendReplyToJSCallback(int64_t instance_id, int request_id,
+                             scoped_ptr<base::Value> reply);
+
+  XWalkExtensionInstance* GetInstance(int64_t instance_id);
+  std::string GetExtensionNameForInstance(int64_t instance_id);
+
+  // Sends a message carrying |message_count| messages posted to JS.
+  bool SendToJS(int64_t instance_id, IPC::Message* msg, size_t message_count);
+
+  // Adds the message to the XWalkExtensionMessageStats of the extension.
+  void RecordMessageToJS(int64_t instance_id, size_t size);
+
   void DeleteInstanceMap();
+  static void DeleteInstances(InstanceMap* instances);
 
   bool ValidateExtensionEntryPoints(const base::ListValue& entry_points);
 
-  base::Lock sender_lock_;
+  // Also protects the message counters.
+  mutable base::Lock sender_lock_;
   IPC::Sender* sender_;
 
+  uint64 messages_posted_to_js_;
+  uint64 ipc_messages_posted_to_js_;
+
+  // Only set when message batching is enabled.
+  scoped_refptr<MessageBatcher> message_batcher_;
+
   typedef std::map<std::string, XWalkExtension*> ExtensionMap;
   ExtensionMap extensions_;
 
-  typedef std::map<int64_t, InstanceExecutionData> InstanceMap;
+  // Extensions in |extensions_| owned by another server.
+  std::set<std::string> borrowed_extensions_;
+
+  // Protects |instances_|, which is accessed from the threads of all the
+  // extensions. The instances themselves are only used in the thread where
+  // they were created.
+  base::Lock instances_lock_;
   InstanceMap instances_;
 
   // The exported symbols for extensions already registered.
@@ -5,7 +5,13 @@
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
 #include "base/basictypes.h"
+#include "base/memory/scoped_vector.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "ipc/ipc_sender.h"
 #include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 using xwalk::extensions::ValidateExtensionNameForTesting;
 
@@ -42,3 +48,144 @@ TEST(XWalkExtensionServerTest, ValidateExtensionName) {
         << "Extension name should be invalid: " << invalid_names[i];
   }
 }
+
+namespace {
+
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExtensionServer;
+
+// Each message received from JS is an integer, telling how many messages the
+// instance should post back.
+class FloodInstance : public XWalkExtensionInstance {
+ public:
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {
+    int count = 0;
+    msg->GetAsInteger(&count);
+    for (int i = 0; i < count; ++i) {
+      PostMessageToJS(
+          scoped_ptr<base::Value>(base::Value::CreateIntegerValue(i)));
+    }
+  }
+};
+
+class FloodExtension : public XWalkExtension {
+ public:
+  FloodExtension() {
+    set_name("flood");
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new FloodInstance;
+  }
+};
+
+class MessageCollector : public IPC::Sender {
+ public:
+  virtual bool Send(IPC::Message* msg) OVERRIDE {
+    messages_.push_back(msg);
+    return true;
+  }
+
+  const ScopedVector<IPC::Message>& messages() const { return messages_; }
+
+ private:
+  ScopedVector<IPC::Message> messages_;
+};
+
+void PostFloodRequest(XWalkExtensionServer* server, int64_t instance_id,
+                      int count) {
+  base::ListValue msg;
+  msg.AppendInteger(count);
+  server->OnMessageReceived(
+      XWalkExtensionServerMsg_PostMessageToNative(instance_id, msg));
+}
+
+void RunMessageLoopFor(base::TimeDelta delay) {
+  base::RunLoop run_loop;
+  base::MessageLoop::current()->PostDelayedTask(
+      FROM_HERE, run_loop.QuitClosure(), delay);
+  run_loop.Run();
+}
+
+}  // namespace
+
+TEST(XWalkExtensionServerTest, MessagesToJSWithoutBatching) {
+  base::MessageLoop message_loop;
+  MessageCollector collector;
+  XWalkExtensionServer server;
+  server.Initialize(&collector);
+  ASSERT_TRUE(server.RegisterExtension(
+      scoped_ptr<XWalkExtension>(new FloodExtension)));
+  server.OnMessageReceived(XWalkExtensionServerMsg_CreateInstance(1, "flood"));
+
+  PostFloodRequest(&server, 1, 10);
+  EXPECT_EQ(10u, server.messages_posted_to_js());
+  EXPECT_EQ(10u, server.ipc_messages_posted_to_js());
+  EXPECT_EQ(10u, collector.messages().size());
+}
+
+TEST(XWalkExtensionServerTest, MessagesToJSWithBatching) {
+  base::MessageLoop message_loop;
+  MessageCollector collector;
+  XWalkExtensionServer server;
+  server.Initialize(&collector);
+  server.EnableMessageBatching(message_loop.message_loop_proxy(),
+                               base::TimeDelta::FromMilliseconds(5), 4);
+  ASSERT_TRUE(server.RegisterExtension(
+      scoped_ptr<XWalkExtension>(new FloodExtension)));
+  server.OnMessageReceived(XWalkExtensionServerMsg_CreateInstance(1, "flood"));
+
+  // Two full batches are sent right away, the remaining two messages wait
+  // for the end of the window.
+  PostFloodRequest(&server, 1, 10);
+  EXPECT_EQ(2u, server.ipc_messages_posted_to_js());
+
+  RunMessageLoopFor(base::TimeDelta::FromMilliseconds(20));
+  EXPECT_EQ(10u, server.messages_posted_to_js());
+  EXPECT_EQ(3u, server.ipc_messages_posted_to_js());
+  ASSERT_EQ(3u, collector.messages().size());
+
+  int expected = 0;
+  for (size_t i = 0; i < collector.messages().size(); ++i) {
+    const IPC::Message* ipc_msg = collector.messages()[i];
+    ASSERT_EQ(
+        static_cast<uint32>(XWalkExtensionClientMsg_PostMessagesToJS::ID),
+        ipc_msg->type());
+    XWalkExtensionClientMsg_PostMessagesToJS::Param params;
+    ASSERT_TRUE(
+        XWalkExtensionClientMsg_PostMessagesToJS::Read(ipc_msg, &params));
+    EXPECT_EQ(1, params.a);
+    const base::ListValue& msgs = params.b;
+    for (size_t j = 0; j < msgs.GetSize(); ++j) {
+      int value;
+      ASSERT_TRUE(msgs.GetInteger(j, &value));
+      EXPECT_EQ(expected++, value);
+    }
+  }
+  EXPECT_EQ(10, expected);
+}
+
+TEST(XWalkExtensionServerTest, BatchIsFlushedWhenInstanceIsDestroyed) {
+  base::MessageLoop message_loop;
+  MessageCollector collector;
+  XWalkExtensionServer server;
+  server.Initialize(&collector);
+  server.EnableMessageBatching(message_loop.message_loop_proxy(),
+                               base::TimeDelta::FromSeconds(10), 64);
+  ASSERT_TRUE(server.RegisterExtension(
+      scoped_ptr<XWalkExtension>(new FloodExtension)));
+  server.OnMessageReceived(XWalkExtensionServerMsg_CreateInstance(1, "flood"));
+
+  PostFloodRequest(&server, 1, 3);
+  EXPECT_EQ(0u, collector.messages().size());
+
+  server.OnMessageReceived(XWalkExtensionServerMsg_DestroyInstance(1));
+  ASSERT_EQ(2u, collector.messages().size());
+  EXPECT_EQ(
+      static_cast<uint32>(XWalkExtensionClientMsg_PostMessagesToJS::ID),
+      collector.messages()[0]->type());
+  EXPECT_EQ(
+      static_cast<uint32>(XWalkExtensionClientMsg_InstanceDestroyed::ID),
+      collector.messages()[1]->type());
+}
@@ -23,4 +23,24 @@ const char kXWalkDisableExtensionProcess[] =
 // Used internally to launch an extension process.
 const char kXWalkExtensionProcess[] = "xwalk-extension-process";
 
+// Time window in milliseconds in which messages posted from an extension
+// instance to JavaScript are coalesced and delivered to the render process in
+// a single IPC message. Batching is disabled if not set or zero.
+const char kXWalkExtensionMessageBatchingWindow[] =
+    "extension-message-batching-window";
+
+// Maximum number of messages in a batch, when reached the batch is delivered
+// without waiting for the end of the window.
+const char kXWalkExtensionMessageBatchingSize[] =
+    "extension-message-batching-size";
+
+const char kXWalkExtensionThreadPerExtension[] =
+    "extension-thread-per-extension";
+
+const char kXWalkSharedExtensionProcess[] = "shared-extension-process";
+
+const char kXWalkDumpExtensionMessageStats[] = "dump-extension-message-stats";
+
+const char kXWalkExtensionWorkerThreads[] = "extension-worker-threads";
+
 }  // namespace switches
@@ -11,6 +11,12 @@ namespace switches {
 extern const char kXWalkDisableLoadingExtensionsOnDemand[];
 extern const char kXWalkDisableExtensionProcess[];
 extern const char kXWalkExtensionProcess[];
+extern const char kXWalkExtensionMessageBatchingWindow[];
+extern const char kXWalkExtensionMessageBatchingSize[];
+extern const char kXWalkExtensionThreadPerExtension[];
+extern const char kXWalkSharedExtensionProcess[];
+extern const char kXWalkDumpExtensionMessageStats[];
+extern const char kXWalkExtensionWorkerThreads[];
 
 }  // namespace switches
 
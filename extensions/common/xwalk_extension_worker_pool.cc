@@ -0,0 +1,139 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_worker_pool.h"
+
+#include <algorithm>
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/debug/trace_event.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+size_t GetMaxThreadsFromCommandLine() {
+  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
+  size_t max_threads = 0;
+  if (cmd_line->HasSwitch(switches::kXWalkExtensionWorkerThreads) &&
+      (!base::StringToSizeT(cmd_line->GetSwitchValueASCII(
+           switches::kXWalkExtensionWorkerThreads), &max_threads) ||
+       max_threads == 0)) {
+    LOG(WARNING) << "Invalid value for --"
+                 << switches::kXWalkExtensionWorkerThreads
+                 << ", using default.";
+  }
+  if (!max_threads)
+    max_threads = base::SysInfo::NumberOfProcessors();
+  return max_threads;
+}
+
+// Leaky because the tasks running in worker threads refer to it.
+base::LazyInstance<XWalkExtensionWorkerPool>::Leaky g_worker_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+XWalkExtensionWorkerPool::Stats::Stats()
+    : tasks_posted(0),
+      tasks_run(0),
+      max_queue_depth(0) {}
+
+XWalkExtensionWorkerPool::PendingTask::PendingTask(
+    const base::Closure& task, base::TimeTicks post_time)
+    : task(task),
+      post_time(post_time) {}
+
+XWalkExtensionWorkerPool::PendingTask::~PendingTask() {}
+
+// static
+XWalkExtensionWorkerPool* XWalkExtensionWorkerPool::GetInstance() {
+  return g_worker_pool.Pointer();
+}
+
+XWalkExtensionWorkerPool::XWalkExtensionWorkerPool()
+    : max_threads_(GetMaxThreadsFromCommandLine()),
+      running_threads_(0) {}
+
+XWalkExtensionWorkerPool::XWalkExtensionWorkerPool(size_t max_threads)
+    : max_threads_(max_threads),
+      running_threads_(0) {
+  DCHECK_GT(max_threads_, 0u);
+}
+
+XWalkExtensionWorkerPool::~XWalkExtensionWorkerPool() {}
+
+bool XWalkExtensionWorkerPool::PostTask(const base::Closure& task) {
+  PendingTask pending_task(task, base::TimeTicks::Now());
+  {
+    base::AutoLock l(lock_);
+    stats_.tasks_posted++;
+    if (running_threads_ == max_threads_) {
+      queue_.push_back(pending_task);
+      stats_.max_queue_depth = std::max(stats_.max_queue_depth,
+                                        queue_.size());
+      return true;
+    }
+    running_threads_++;
+  }
+
+  // The tasks are assumed to be slow, since they were moved out of the
+  // extension thread.
+  if (!base::WorkerPool::PostTask(
+          FROM_HERE,
+          base::Bind(&XWalkExtensionWorkerPool::RunTasks,
+                     base::Unretained(this), pending_task),
+          true)) {
+    base::AutoLock l(lock_);
+    running_threads_--;
+    stats_.tasks_posted--;
+    return false;
+  }
+  return true;
+}
+
+XWalkExtensionWorkerPool::Stats XWalkExtensionWorkerPool::GetStats() const {
+  base::AutoLock l(lock_);
+  return stats_;
+}
+
+void XWalkExtensionWorkerPool::RunTasks(const PendingTask& first_task) {
+  PendingTask pending_task = first_task;
+  while (true) {
+    const base::TimeTicks start_time = base::TimeTicks::Now();
+    {
+      TRACE_EVENT0("xwalk", "XWalkExtensionWorkerPool::RunTask");
+      pending_task.task.Run();
+    }
+    const base::TimeTicks end_time = base::TimeTicks::Now();
+
+    const base::TimeDelta queueing_time = start_time - pending_task.post_time;
+    UMA_HISTOGRAM_TIMES("XWalk.Extensions.WorkerTaskQueueingTime",
+                        queueing_time);
+    UMA_HISTOGRAM_TIMES("XWalk.Extensions.WorkerTaskRunTime",
+                        end_time - start_time);
+
+    base::AutoLock l(lock_);
+    stats_.tasks_run++;
+    stats_.total_queueing_time += queueing_time;
+    stats_.total_run_time += end_time - start_time;
+
+    if (queue_.empty()) {
+      running_threads_--;
+      return;
+    }
+    pending_task = queue_.front();
+    queue_.pop_front();
+  }
+}
+
+}  // namespace extensions
+}  // namespace xwalk
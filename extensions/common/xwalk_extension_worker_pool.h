@@ -0,0 +1,82 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_WORKER_POOL_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_WORKER_POOL_H_
+
+#include <deque>
+#include "base/basictypes.h"
+#include "base/callback.h"
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Runs the work posted by extensions out of the threads handling their
+// messages, see XW_Extension_TaskRunner.h. Tasks run in base::WorkerPool
+// threads, but at most max_threads() of them at the same time, so the
+// extensions of a process can't take over the machine. The rest wait in a
+// queue, in the order they were posted.
+//
+// The number of threads is the number of processors, unless set with the
+// switch kXWalkExtensionWorkerThreads.
+//
+// Can be used from any thread.
+class XWalkExtensionWorkerPool {
+ public:
+  struct Stats {
+    Stats();
+
+    uint64 tasks_posted;
+    uint64 tasks_run;
+    size_t max_queue_depth;
+    base::TimeDelta total_queueing_time;
+    base::TimeDelta total_run_time;
+  };
+
+  static XWalkExtensionWorkerPool* GetInstance();
+
+  // Used by tests, the other users should share the pool from GetInstance().
+  // Must outlive the tasks posted to it.
+  explicit XWalkExtensionWorkerPool(size_t max_threads);
+  ~XWalkExtensionWorkerPool();
+
+  bool PostTask(const base::Closure& task);
+
+  size_t max_threads() const { return max_threads_; }
+  Stats GetStats() const;
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<XWalkExtensionWorkerPool>;
+
+  XWalkExtensionWorkerPool();
+
+  struct PendingTask {
+    PendingTask(const base::Closure& task, base::TimeTicks post_time);
+    ~PendingTask();
+
+    base::Closure task;
+    base::TimeTicks post_time;
+  };
+
+  // Runs in a worker thread until the queue is empty.
+  void RunTasks(const PendingTask& first_task);
+
+  const size_t max_threads_;
+
+  // Protects the members below.
+  mutable base::Lock lock_;
+  size_t running_threads_;
+  std::deque<PendingTask> queue_;
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionWorkerPool);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_WORKER_POOL_H_
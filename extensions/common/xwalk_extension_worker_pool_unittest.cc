@@ -0,0 +1,86 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_worker_pool.h"
+
+#include <algorithm>
+#include "base/bind.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::XWalkExtensionWorkerPool;
+
+namespace {
+
+class ConcurrencyCounter {
+ public:
+  explicit ConcurrencyCounter(int expected_tasks)
+      : remaining_tasks_(expected_tasks),
+        running_(0),
+        max_running_(0),
+        done_(false, false) {}
+
+  void Run() {
+    {
+      base::AutoLock l(lock_);
+      running_++;
+      max_running_ = std::max(max_running_, running_);
+    }
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(1));
+    base::AutoLock l(lock_);
+    running_--;
+    if (--remaining_tasks_ == 0)
+      done_.Signal();
+  }
+
+  void Wait() { done_.Wait(); }
+
+  int max_running() {
+    base::AutoLock l(lock_);
+    return max_running_;
+  }
+
+ private:
+  base::Lock lock_;
+  int remaining_tasks_;
+  int running_;
+  int max_running_;
+  base::WaitableEvent done_;
+};
+
+// The last task signals before its worker is done with the pool, the pool
+// must outlive it.
+XWalkExtensionWorkerPool::Stats WaitForTasksRun(
+    const XWalkExtensionWorkerPool& pool, uint64 tasks_run) {
+  XWalkExtensionWorkerPool::Stats stats = pool.GetStats();
+  while (stats.tasks_run < tasks_run) {
+    base::PlatformThread::YieldCurrentThread();
+    stats = pool.GetStats();
+  }
+  return stats;
+}
+
+}  // namespace
+
+TEST(XWalkExtensionWorkerPoolTest, LimitsConcurrentTasks) {
+  const int kTaskCount = 50;
+  XWalkExtensionWorkerPool pool(2);
+  ConcurrencyCounter counter(kTaskCount);
+
+  for (int i = 0; i < kTaskCount; ++i) {
+    ASSERT_TRUE(pool.PostTask(base::Bind(&ConcurrencyCounter::Run,
+                                         base::Unretained(&counter))));
+  }
+  counter.Wait();
+
+  EXPECT_GE(counter.max_running(), 1);
+  EXPECT_LE(counter.max_running(), 2);
+
+  XWalkExtensionWorkerPool::Stats stats = WaitForTasksRun(pool, kTaskCount);
+  EXPECT_EQ(static_cast<uint64>(kTaskCount), stats.tasks_posted);
+  EXPECT_EQ(static_cast<uint64>(kTaskCount), stats.tasks_run);
+  EXPECT_GE(stats.max_queue_depth, 1u);
+}
@@ -5,14 +5,11 @@
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
 #include "base/logging.h"
-#include "base/stl_util.h"
 
 namespace xwalk {
 namespace extensions {
 
-XWalkExternalAdapter::XWalkExternalAdapter()
-    : next_xw_extension_(1),
-      next_xw_instance_(1) {}
+XWalkExternalAdapter::XWalkExternalAdapter() {}
 
 XWalkExternalAdapter::~XWalkExternalAdapter() {}
 
@@ -20,42 +17,35 @@ XWalkExternalAdapter* XWalkExternalAdapter::GetInstance() {
   return Singleton<XWalkExternalAdapter>::get();
 }
 
-XW_Extension XWalkExternalAdapter::GetNextXWExtension() {
-  return next_xw_extension_++;
-}
-
-XW_Instance XWalkExternalAdapter::GetNextXWInstance() {
-  return next_xw_instance_++;
-}
-
-void XWalkExternalAdapter::RegisterExtension(
+XW_Extension XWalkExternalAdapter::RegisterExtension(
     XWalkExternalExtension* extension) {
-  XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(!ContainsKey(extension_map_, xw_extension));
-  extension_map_[xw_extension] = extension;
+  XW_Extension xw_extension = extensions_.Add(extension);
+  CHECK(xw_extension);
+  return xw_extension;
 }
 
 void XWalkExternalAdapter::UnregisterExtension(
     XWalkExternalExtension* extension) {
   XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(ContainsKey(extension_map_, xw_extension));
-  extension_map_.erase(xw_extension);
+  CHECK(extensions_.Lookup(xw_extension) == extension);
+  extensions_.Remove(xw_extension);
 }
 
-void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
-  XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(!ContainsKey(instance_map_, xw_instance));
-  instance_map_[xw_instance] = context;
+XW_Instance XWalkExternalAdapter::RegisterInstance(
+    XWalkExternalInstance* context) {
+  XW_Instance xw_instance = instances_.Add(context);
+  CHECK(xw_instance);
+  return xw_instance;
 }
 
 void XWalkExternalAdapter::UnregisterInstance(XWalkExternalInstance* context) {
   XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(ContainsKey(instance_map_, xw_instance));
-  instance_map_.erase(xw_instance);
+  CHECK(instances_.Lookup(xw_instance) == context);
+  instances_.Remove(xw_instance);
+}
+
+bool XWalkExternalAdapter::HasExtension(XW_Extension xw_extension) const {
+  return extensions_.Lookup(xw_extension) != NULL;
 }
 
 const void* XWalkExternalAdapter::GetInterface(const char* name) {
@@ -79,6 +69,29 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &messagingInterface1;
   }
 
+  if (!strcmp(name, XW_BINARY_MESSAGING_INTERFACE_1)) {
+    static const XW_BinaryMessagingInterface_1 binaryMessagingInterface1 = {
+      BinaryMessagingRegister,
+      BinaryMessagingPostBinaryMessage
+    };
+    return &binaryMessagingInterface1;
+  }
+
+  if (!strcmp(name, XW_REQUEST_MESSAGING_INTERFACE_1)) {
+    static const XW_RequestMessagingInterface_1 requestMessagingInterface1 = {
+      RequestMessagingRegister,
+      RequestMessagingSendReply
+    };
+    return &requestMessagingInterface1;
+  }
+
+  if (!strcmp(name, XW_TASK_RUNNER_INTERFACE_1)) {
+    static const XW_TaskRunnerInterface_1 taskRunnerInterface1 = {
+      TaskRunnerPostTask
+    };
+    return &taskRunnerInterface1;
+  }
+
   if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1)) {
     static const XW_Internal_SyncMessagingInterface_1
         syncMessagingInterface1 = {
@@ -99,30 +112,18 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
   return NULL;
 }
 
-bool XWalkExternalAdapter::IsValidXWExtension(XW_Extension xw_extension) {
-  return xw_extension > 0 && xw_extension < next_xw_extension_;
-}
-
-bool XWalkExternalAdapter::IsValidXWInstance(XW_Instance xw_instance) {
-  return xw_instance > 0 && xw_instance < next_xw_instance_;
-}
-
 XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
     XW_Extension xw_extension) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  ExtensionMap::iterator it = adapter->extension_map_.find(xw_extension);
-  if (it == adapter->extension_map_.end())
-    return NULL;
-  return it->second;
+  return static_cast<XWalkExternalExtension*>(
+      adapter->extensions_.Lookup(xw_extension));
 }
 
 XWalkExternalInstance* XWalkExternalAdapter::GetInstance(
     XW_Instance xw_instance) {
   XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  InstanceMap::iterator it = adapter->instance_map_.find(xw_instance);
-  if (it == adapter->instance_map_.end())
-    return NULL;
-  return it->second;
+  return static_cast<XWalkExternalInstance*>(
+      adapter->instances_.Lookup(xw_instance));
 }
 
 // static
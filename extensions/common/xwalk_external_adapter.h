@@ -5,10 +5,13 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 
-#include <map>
 #include "base/memory/singleton.h"
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessaging.h"
+#include "xwalk/extensions/public/XW_Extension_RequestMessaging.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
+#include "xwalk/extensions/public/XW_Extension_TaskRunner.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
@@ -44,6 +47,17 @@
     return NULL;                                                \
   }
 
+#define DEFINE_RET_FUNCTION_3(TYPE, INTERFACE, NAME, RET_ARG, ERROR_VALUE,   \
+                              ARG1, ARG2, ARG3)                             \
+  static RET_ARG INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1, ARG2 arg2,    \
+                                   ARG3 arg3) {                             \
+    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);                          \
+    if (ptr)                                                                \
+      return ptr->INTERFACE ## NAME(arg1, arg2, arg3);                      \
+    LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);                           \
+    return ERROR_VALUE;                                                     \
+  }
+
 template <typename T> struct DefaultSingletonTraits;
 
 namespace xwalk {
@@ -56,23 +70,30 @@ class XWalkExternalInstance;
 // functions from external extension to their implementations in
 // XWalkExternalExtension and XWalkExternalInstance. We have only one
 // adapter per process.
+//
+// The C functions can be called from any thread, e.g. PostMessage, so the
+// XW_Extension and XW_Instance handles are resolved without taking locks,
+// see XWalkExternalHandleTable.
 class XWalkExternalAdapter {
  public:
   static XWalkExternalAdapter* GetInstance();
 
-  XW_Extension GetNextXWExtension();
-  XW_Instance GetNextXWInstance();
-
   // This adds the extension to the adapter's mapping, so C calls to
-  // its corresponding XW_Extension are correctly dispatched.
-  void RegisterExtension(XWalkExternalExtension* extension);
+  // its corresponding XW_Extension are correctly dispatched. Returns the
+  // XW_Extension that identifies the extension.
+  XW_Extension RegisterExtension(XWalkExternalExtension* extension);
   void UnregisterExtension(XWalkExternalExtension* extension);
 
   // This adds the context to the adapter's mapping, so C calls to
-  // its corresponding XW_Instance are correctly dispatched.
-  void RegisterInstance(XWalkExternalInstance* context);
+  // its corresponding XW_Instance are correctly dispatched. Returns the
+  // XW_Instance that identifies the context.
+  XW_Instance RegisterInstance(XWalkExternalInstance* context);
   void UnregisterInstance(XWalkExternalInstance* context);
 
+  // Whether the extension is still registered, extensions unregister before
+  // unloading their library.
+  bool HasExtension(XW_Extension xw_extension) const;
+
   // Returns the correct struct according to interface asked. This is
   // passed to external extensions in XW_Initialize() call.
   static const void* GetInterface(const char* name);
@@ -83,9 +104,6 @@ class XWalkExternalAdapter {
   XWalkExternalAdapter();
   ~XWalkExternalAdapter();
 
-  bool IsValidXWExtension(XW_Extension xw_extension);
-  bool IsValidXWInstance(XW_Instance xw_instance);
-
   // Used by the DEFINE_* macros to bridge the calls using C API identifiers
   // XW_Extension and XW_Instance to the right C++ object.
   static XWalkExternalExtension* GetExtension(XW_Extension xw_extension);
@@ -114,14 +132,24 @@ class XWalkExternalAdapter {
                     XW_HandleSyncMessageCallback);
   DEFINE_FUNCTION_1(Instance, SyncMessaging, SetSyncReply, const char*);
 
-  typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
-  ExtensionMap extension_map_;
+  // XW_BinaryMessagingInterface_1 from XW_Extension_BinaryMessaging.h.
+  DEFINE_FUNCTION_1(Extension, BinaryMessaging, Register,
+                    XW_HandleBinaryMessageCallback);
+  DEFINE_FUNCTION_2(Instance, BinaryMessaging, PostBinaryMessage,
+                    const char*, size_t);
+
+  // XW_RequestMessagingInterface_1 from XW_Extension_RequestMessaging.h.
+  DEFINE_FUNCTION_1(Extension, RequestMessaging, Register,
+                    XW_HandleRequestCallback);
+  DEFINE_FUNCTION_2(Instance, RequestMessaging, SendReply,
+                    int32_t, const char*);
 
-  typedef std::map<XW_Instance, XWalkExternalInstance*> InstanceMap;
-  InstanceMap instance_map_;
+  // XW_TaskRunnerInterface_1 from XW_Extension_TaskRunner.h.
+  DEFINE_RET_FUNCTION_3(Instance, TaskRunner, PostTask, int32_t, XW_ERROR,
+                        XW_TaskCallback, XW_TaskCallback, void*);
 
-  XW_Extension next_xw_extension_;
-  XW_Instance next_xw_instance_;
+  XWalkExternalHandleTable extensions_;
+  XWalkExternalHandleTable instances_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalAdapter);
 };
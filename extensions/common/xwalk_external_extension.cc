@@ -21,7 +21,10 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       shutdown_callback_(NULL),
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
-      initialized_(false) {
+      handle_binary_msg_callback_(NULL),
+      handle_request_callback_(NULL),
+      initialized_(false),
+      task_tracker_(new TaskTracker) {
   std::string error;
   base::ScopedNativeLibrary library(base::LoadNativeLibrary(path, &error));
   if (!library.is_valid()) {
@@ -38,9 +41,7 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
     return;
   }
 
-  XWalkExternalAdapter* external_adapter = XWalkExternalAdapter::GetInstance();
-  xw_extension_ = external_adapter->GetNextXWExtension();
-  external_adapter->RegisterExtension(this);
+  xw_extension_ = XWalkExternalAdapter::GetInstance()->RegisterExtension(this);
   int ret = initialize(xw_extension_, XWalkExternalAdapter::GetInterface);
   if (ret != XW_OK) {
     LOG(WARNING) << "Error loading extension '" << path.AsUTF8Unsafe() << "': "
@@ -56,19 +57,50 @@ XWalkExternalExtension::~XWalkExternalExtension() {
   if (!initialized_)
     return;
 
+  // The work still queued is dropped and the running one finishes before the
+  // extension shuts down, so none of it calls into an unloaded library.
+  task_tracker_->Shutdown();
+
   if (shutdown_callback_)
     shutdown_callback_(xw_extension_);
   XWalkExternalAdapter::GetInstance()->UnregisterExtension(this);
 }
 
+XWalkExternalExtension::TaskTracker::TaskTracker()
+    : work_done_(&lock_),
+      running_work_(0),
+      is_shut_down_(false) {}
+
+XWalkExternalExtension::TaskTracker::~TaskTracker() {}
+
+bool XWalkExternalExtension::TaskTracker::BeginWork() {
+  base::AutoLock l(lock_);
+  if (is_shut_down_)
+    return false;
+  running_work_++;
+  return true;
+}
+
+void XWalkExternalExtension::TaskTracker::EndWork() {
+  base::AutoLock l(lock_);
+  DCHECK_GT(running_work_, 0);
+  if (--running_work_ == 0)
+    work_done_.Broadcast();
+}
+
+void XWalkExternalExtension::TaskTracker::Shutdown() {
+  base::AutoLock l(lock_);
+  is_shut_down_ = true;
+  while (running_work_ > 0)
+    work_done_.Wait();
+}
+
 bool XWalkExternalExtension::is_valid() {
   return initialized_;
 }
 
 XWalkExtensionInstance* XWalkExternalExtension::CreateInstance() {
-  XW_Instance xw_instance =
-      XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
-  return new XWalkExternalInstance(this, xw_instance);
+  return new XWalkExternalInstance(this);
 }
 
 #define RETURN_IF_INITIALIZED(FUNCTION)                          \
@@ -115,6 +147,18 @@ void XWalkExternalExtension::SyncMessagingRegister(
   handle_sync_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::BinaryMessagingRegister(
+    XW_HandleBinaryMessageCallback callback) {
+  RETURN_IF_INITIALIZED("Register from BinaryMessagingInterface");
+  handle_binary_msg_callback_ = callback;
+}
+
+void XWalkExternalExtension::RequestMessagingRegister(
+    XW_HandleRequestCallback callback) {
+  RETURN_IF_INITIALIZED("Register from RequestMessagingInterface");
+  handle_request_callback_ = callback;
+}
+
 void XWalkExternalExtension::EntryPointsSetExtraJSEntryPoints(
     const char** entry_points) {
   RETURN_IF_INITIALIZED("SetExtraJSEntryPoints from EntryPoints");
@@ -6,9 +6,14 @@
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_EXTENSION_H_
 
 #include <string>
+#include "base/memory/ref_counted.h"
 #include "base/scoped_native_library.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessaging.h"
+#include "xwalk/extensions/public/XW_Extension_RequestMessaging.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace base {
@@ -36,6 +41,32 @@ class XWalkExternalExtension : public XWalkExtension {
 
   bool is_valid();
 
+  // Keeps track of the work posted with XW_TaskRunnerInterface_1 running in
+  // worker threads. Shutdown() is called before the library is unloaded, it
+  // cancels the work still queued and waits for the one already running.
+  class TaskTracker : public base::RefCountedThreadSafe<TaskTracker> {
+   public:
+    TaskTracker();
+
+    // Returns false if the extension was shut down, and the work must not
+    // run. Otherwise EndWork() must be called once it is done.
+    bool BeginWork();
+    void EndWork();
+
+    void Shutdown();
+
+   private:
+    friend class base::RefCountedThreadSafe<TaskTracker>;
+    ~TaskTracker();
+
+    base::Lock lock_;
+    base::ConditionVariable work_done_;
+    int running_work_;
+    bool is_shut_down_;
+
+    DISALLOW_COPY_AND_ASSIGN(TaskTracker);
+  };
+
  private:
   friend class XWalkExternalAdapter;
   friend class XWalkExternalInstance;
@@ -58,6 +89,14 @@ class XWalkExternalExtension : public XWalkExtension {
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
+  // XW_BinaryMessagingInterface_1 (from XW_Extension_BinaryMessaging.h)
+  // implementation.
+  void BinaryMessagingRegister(XW_HandleBinaryMessageCallback callback);
+
+  // XW_RequestMessagingInterface_1 (from XW_Extension_RequestMessaging.h)
+  // implementation.
+  void RequestMessagingRegister(XW_HandleRequestCallback callback);
+
   base::ScopedNativeLibrary library_;
   XW_Extension xw_extension_;
 
@@ -66,9 +105,13 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_ShutdownCallback shutdown_callback_;
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
+  XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
+  XW_HandleRequestCallback handle_request_callback_;
 
   bool initialized_;
 
+  scoped_refptr<TaskTracker> task_tracker_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalExtension);
 };
 
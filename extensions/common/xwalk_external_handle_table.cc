@@ -0,0 +1,129 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// The lower bits of a handle have the slot index plus one, so a valid handle
+// is never zero. The remaining bits, except the sign, have the generation.
+const int kSlotIndexBits = 16;
+const int32_t kSlotIndexMask = (1 << kSlotIndexBits) - 1;
+const int32_t kMaxGeneration = (1 << (31 - kSlotIndexBits)) - 1;
+
+int32_t MakeHandle(size_t index, int32_t generation) {
+  return (generation << kSlotIndexBits) | static_cast<int32_t>(index + 1);
+}
+
+}  // namespace
+
+const size_t XWalkExternalHandleTable::kMaxSlots =
+    XWalkExternalHandleTable::kSlotsPerChunk *
+    XWalkExternalHandleTable::kMaxChunks - 1;
+
+XWalkExternalHandleTable::XWalkExternalHandleTable()
+    : used_slots_(0) {
+  COMPILE_ASSERT(kSlotsPerChunk * kMaxChunks <= (1 << kSlotIndexBits),
+                 slot_index_must_fit_in_handle);
+  for (size_t i = 0; i < kMaxChunks; ++i)
+    chunks_[i] = 0;
+}
+
+XWalkExternalHandleTable::~XWalkExternalHandleTable() {
+  for (size_t i = 0; i < kMaxChunks; ++i)
+    delete[] reinterpret_cast<Slot*>(chunks_[i]);
+}
+
+int32_t XWalkExternalHandleTable::Add(void* object) {
+  DCHECK(object);
+  base::AutoLock l(lock_);
+
+  size_t index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.back();
+    free_slots_.pop_back();
+  } else {
+    if (used_slots_ == kMaxSlots) {
+      LOG(WARNING) << "Too many external extensions or instances.";
+      return 0;
+    }
+    index = used_slots_++;
+
+    const size_t chunk = index / kSlotsPerChunk;
+    if (!chunks_[chunk]) {
+      Slot* slots = new Slot[kSlotsPerChunk];
+      for (size_t i = 0; i < kSlotsPerChunk; ++i) {
+        slots[i].handle = 0;
+        slots[i].object = 0;
+        slots[i].generation = 0;
+      }
+      base::subtle::Release_Store(&chunks_[chunk],
+                                  reinterpret_cast<base::subtle::AtomicWord>(
+                                      slots));
+    }
+  }
+
+  Slot* slot = GetSlot(index);
+  slot->generation = slot->generation == kMaxGeneration ?
+      1 : slot->generation + 1;
+  const int32_t handle = MakeHandle(index, slot->generation);
+
+  // The object goes first, so a reader that sees the handle sees the object.
+  base::subtle::NoBarrier_Store(
+      &slot->object, reinterpret_cast<base::subtle::AtomicWord>(object));
+  base::subtle::Release_Store(&slot->handle, handle);
+  return handle;
+}
+
+void XWalkExternalHandleTable::Remove(int32_t handle) {
+  base::AutoLock l(lock_);
+  CHECK(Lookup(handle));
+
+  const size_t index = (handle & kSlotIndexMask) - 1;
+  Slot* slot = GetSlot(index);
+  base::subtle::Release_Store(&slot->handle, 0);
+  base::subtle::Release_Store(&slot->object, 0);
+  free_slots_.push_back(index);
+}
+
+void* XWalkExternalHandleTable::Lookup(int32_t handle) const {
+  if (handle <= 0 || !(handle & kSlotIndexMask))
+    return NULL;
+
+  const size_t index = (handle & kSlotIndexMask) - 1;
+  Slot* slot = GetSlot(index);
+  if (!slot)
+    return NULL;
+
+  if (base::subtle::Acquire_Load(&slot->handle) != handle)
+    return NULL;
+  void* object =
+      reinterpret_cast<void*>(base::subtle::Acquire_Load(&slot->object));
+
+  // The handle is checked again in case it was removed while reading the
+  // object.
+  if (base::subtle::Acquire_Load(&slot->handle) != handle)
+    return NULL;
+  return object;
+}
+
+XWalkExternalHandleTable::Slot* XWalkExternalHandleTable::GetSlot(
+    size_t index) const {
+  const size_t chunk = index / kSlotsPerChunk;
+  if (chunk >= kMaxChunks)
+    return NULL;
+  Slot* slots = reinterpret_cast<Slot*>(
+      base::subtle::Acquire_Load(&chunks_[chunk]));
+  if (!slots)
+    return NULL;
+  return &slots[index % kSlotsPerChunk];
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,75 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
+
+#include <stdint.h>
+#include <vector>
+#include "base/atomicops.h"
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Maps the handles given to external extensions (XW_Extension and
+// XW_Instance) to the objects implementing them.
+//
+// A handle is made of the index of a slot in the table and the generation of
+// that slot, which changes every time the slot is reused. So a handle that
+// was removed is not valid anymore, even if its slot is in use by another
+// object.
+//
+// Adding and removing objects take a lock, but Lookup() doesn't take any and
+// is O(1), so it can be called from any thread, e.g. by the native threads of
+// an extension posting messages. The caller is responsible for not using an
+// object after it is removed, as for the handles in the C API.
+class XWalkExternalHandleTable {
+ public:
+  XWalkExternalHandleTable();
+  ~XWalkExternalHandleTable();
+
+  // Returns the handle for |object|, which is always positive, or zero if the
+  // table is full.
+  int32_t Add(void* object);
+  void Remove(int32_t handle);
+
+  // Returns NULL if |handle| is not in the table.
+  void* Lookup(int32_t handle) const;
+
+  // Maximum number of objects in the table at the same time.
+  static const size_t kMaxSlots;
+
+ private:
+  struct Slot {
+    // Handle of the object in the slot, zero if the slot is free.
+    base::subtle::Atomic32 handle;
+    base::subtle::AtomicWord object;
+    // Only used with the lock taken.
+    int32_t generation;
+  };
+
+  // The slots are allocated in chunks, that are never freed or moved while
+  // the table exists, so readers don't need to synchronize with writers
+  // growing the table.
+  static const size_t kSlotsPerChunk = 256;
+  static const size_t kMaxChunks = 256;
+
+  Slot* GetSlot(size_t index) const;
+
+  base::subtle::AtomicWord chunks_[kMaxChunks];
+
+  // Protects the members below and the writes to the slots.
+  base::Lock lock_;
+  size_t used_slots_;
+  std::vector<size_t> free_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExternalHandleTable);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
@@ -0,0 +1,127 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/memory/scoped_ptr.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_external_adapter.h"
+#include "xwalk/extensions/common/xwalk_external_extension.h"
+#include "xwalk/extensions/common/xwalk_external_instance.h"
+#include "xwalk/extensions/public/XW_Extension.h"
+
+using xwalk::extensions::XWalkExtension;
+using xwalk::extensions::XWalkExtensionInstance;
+using xwalk::extensions::XWalkExternalAdapter;
+using xwalk::extensions::XWalkExternalExtension;
+using xwalk::extensions::XWalkExternalHandleTable;
+using xwalk::extensions::XWalkExternalInstance;
+
+TEST(XWalkExternalHandleTableTest, AddLookupAndRemove) {
+  XWalkExternalHandleTable table;
+  int a, b;
+
+  int32_t handle_a = table.Add(&a);
+  int32_t handle_b = table.Add(&b);
+  EXPECT_GT(handle_a, 0);
+  EXPECT_GT(handle_b, 0);
+  EXPECT_NE(handle_a, handle_b);
+  EXPECT_EQ(&a, table.Lookup(handle_a));
+  EXPECT_EQ(&b, table.Lookup(handle_b));
+
+  EXPECT_EQ(NULL, table.Lookup(0));
+  EXPECT_EQ(NULL, table.Lookup(-1));
+  EXPECT_EQ(NULL, table.Lookup(handle_b + 1));
+
+  table.Remove(handle_a);
+  EXPECT_EQ(NULL, table.Lookup(handle_a));
+  EXPECT_EQ(&b, table.Lookup(handle_b));
+
+  // The slot is reused, but the old handle stays invalid.
+  int32_t handle_c = table.Add(&a);
+  EXPECT_NE(handle_a, handle_c);
+  EXPECT_EQ(NULL, table.Lookup(handle_a));
+  EXPECT_EQ(&a, table.Lookup(handle_c));
+}
+
+TEST(XWalkExternalHandleTableTest, TableFull) {
+  XWalkExternalHandleTable table;
+  int object;
+  for (size_t i = 0; i < XWalkExternalHandleTable::kMaxSlots; ++i)
+    ASSERT_GT(table.Add(&object), 0);
+  EXPECT_EQ(0, table.Add(&object));
+}
+
+namespace {
+
+void CountMessage(base::subtle::Atomic32* count, scoped_ptr<base::Value> msg) {
+  base::subtle::NoBarrier_AtomicIncrement(count, 1);
+}
+
+// Calls PostMessage from the C API in a loop, as an extension with native
+// threads would do.
+class PostMessageDelegate : public base::DelegateSimpleThread::Delegate {
+ public:
+  PostMessageDelegate(XW_Instance xw_instance, int message_count)
+      : xw_instance_(xw_instance),
+        message_count_(message_count) {}
+
+  virtual void Run() OVERRIDE {
+    const XW_MessagingInterface_1* messaging =
+        reinterpret_cast<const XW_MessagingInterface_1*>(
+            XWalkExternalAdapter::GetInterface(XW_MESSAGING_INTERFACE_1));
+    for (int i = 0; i < message_count_; ++i)
+      messaging->PostMessage(xw_instance_, "ping");
+  }
+
+ private:
+  XW_Instance xw_instance_;
+  int message_count_;
+};
+
+}  // namespace
+
+// Stress test and benchmark for the handle lookups: many threads post
+// messages to the same instance while other instances are created and
+// destroyed.
+TEST(XWalkExternalHandleTableTest, PostMessageFromManyThreads) {
+  const int kThreadCount = 8;
+  const int kMessagesPerThread = 50000;
+
+  // The library doesn't exist, but the extension can still create instances.
+  XWalkExternalExtension extension(
+      base::FilePath(FILE_PATH_LITERAL("nonexistent_extension")));
+  XWalkExtension* base_extension = &extension;
+
+  scoped_ptr<XWalkExternalInstance> instance(
+      static_cast<XWalkExternalInstance*>(base_extension->CreateInstance()));
+  base::subtle::Atomic32 count = 0;
+  instance->SetPostMessageCallback(base::Bind(&CountMessage, &count));
+
+  PostMessageDelegate delegate(instance->xw_instance(), kMessagesPerThread);
+  base::DelegateSimpleThreadPool pool("PostMessageThread", kThreadCount);
+
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  pool.AddWork(&delegate, kThreadCount);
+  pool.Start();
+
+  for (int i = 0; i < 1000; ++i) {
+    scoped_ptr<XWalkExtensionInstance> other(base_extension->CreateInstance());
+  }
+
+  pool.JoinAll();
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+  const int total_messages = kThreadCount * kMessagesPerThread;
+  EXPECT_EQ(total_messages, base::subtle::NoBarrier_Load(&count));
+  LOG(INFO) << total_messages << " messages posted from " << kThreadCount
+            << " threads in " << elapsed.InMilliseconds() << "ms.";
+}
@@ -5,20 +5,56 @@
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
 #include <string>
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/sequenced_task_runner.h"
+#include "xwalk/extensions/common/xwalk_extension_worker_pool.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
 namespace xwalk {
 namespace extensions {
 
+namespace {
+
+void RunTaskReply(XW_Extension xw_extension, XW_Instance xw_instance,
+                  XW_TaskCallback reply, void* user_data) {
+  // The reply would call into an unloaded library.
+  if (!XWalkExternalAdapter::GetInstance()->HasExtension(xw_extension))
+    return;
+  reply(xw_instance, user_data);
+}
+
+void RunTaskWork(
+    XW_Extension xw_extension, XW_Instance xw_instance,
+    XW_TaskCallback work, XW_TaskCallback reply, void* user_data,
+    scoped_refptr<XWalkExternalExtension::TaskTracker> task_tracker,
+    scoped_refptr<base::SequencedTaskRunner> task_runner) {
+  // Tasks still queued when the extension is shut down are dropped, the
+  // library may be unloaded by now.
+  if (!XWalkExternalAdapter::GetInstance()->HasExtension(xw_extension) ||
+      !task_tracker->BeginWork())
+    return;
+  work(xw_instance, user_data);
+  task_tracker->EndWork();
+
+  if (!reply)
+    return;
+  task_runner->PostTask(FROM_HERE, base::Bind(&RunTaskReply, xw_extension,
+                                              xw_instance, reply, user_data));
+}
+
+}  // namespace
+
 XWalkExternalInstance::XWalkExternalInstance(
-    XWalkExternalExtension* extension, XW_Instance xw_instance)
-    : xw_instance_(xw_instance),
+    XWalkExternalExtension* extension)
+    : xw_instance_(0),
       extension_(extension),
       instance_data_(NULL),
-      is_handling_sync_msg_(false) {
-  XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
+      is_handling_sync_msg_(false),
+      task_runner_(base::MessageLoopProxy::current()) {
+  xw_instance_ = XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
   if (callback)
     callback(xw_instance_);
@@ -59,6 +95,35 @@ void XWalkExternalInstance::HandleSyncMessage(scoped_ptr<base::Value> msg) {
   callback(xw_instance_, string_msg.c_str());
 }
 
+void XWalkExternalInstance::HandleBinaryMessage(const char* data,
+                                                size_t size) {
+  XW_HandleBinaryMessageCallback callback =
+      extension_->handle_binary_msg_callback_;
+  if (!callback) {
+    LOG(WARNING) << "Ignoring binary message sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    return;
+  }
+
+  callback(xw_instance_, data, size);
+}
+
+void XWalkExternalInstance::HandleRequest(int request_id,
+                                          scoped_ptr<base::Value> msg) {
+  XW_HandleRequestCallback callback = extension_->handle_request_callback_;
+  if (!callback) {
+    LOG(WARNING) << "Ignoring request sent for external extension '"
+                 << extension_->name() << "' which doesn't support it.";
+    SendReplyToJS(request_id,
+                  scoped_ptr<base::Value>(base::Value::CreateNullValue()));
+    return;
+  }
+
+  std::string string_msg;
+  msg->GetAsString(&string_msg);
+  callback(xw_instance_, request_id, string_msg.c_str());
+}
+
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
   instance_data_ = data;
 }
@@ -75,5 +140,32 @@ void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
   SendSyncReplyToJS(scoped_ptr<base::Value>(new base::StringValue(reply)));
 }
 
+void XWalkExternalInstance::BinaryMessagingPostBinaryMessage(
+    const char* data, size_t size) {
+  PostBinaryMessageToJS(data, size);
+}
+
+void XWalkExternalInstance::RequestMessagingSendReply(int32_t request_id,
+                                                      const char* reply) {
+  SendReplyToJS(request_id,
+                scoped_ptr<base::Value>(new base::StringValue(reply)));
+}
+
+int32_t XWalkExternalInstance::TaskRunnerPostTask(XW_TaskCallback work,
+                                                  XW_TaskCallback reply,
+                                                  void* user_data) {
+  if (!work || !task_runner_) {
+    LOG(WARNING) << "Can't post task for external extension '"
+                 << extension_->name() << "'.";
+    return XW_ERROR;
+  }
+
+  bool posted = XWalkExtensionWorkerPool::GetInstance()->PostTask(
+      base::Bind(&RunTaskWork, extension_->xw_extension_, xw_instance_,
+                 work, reply, user_data, extension_->task_tracker_,
+                 task_runner_));
+  return posted ? XW_OK : XW_ERROR;
+}
+
 }  // namespace extensions
 }  // namespace xwalk
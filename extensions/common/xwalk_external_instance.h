@@ -6,9 +6,15 @@
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_INSTANCE_H_
 
 #include <string>
+#include "base/memory/ref_counted.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
+#include "xwalk/extensions/public/XW_Extension_TaskRunner.h"
+
+namespace base {
+class SequencedTaskRunner;
+}
 
 namespace xwalk {
 namespace extensions {
@@ -25,16 +31,20 @@ class XWalkExternalExtension;
 // calling the shared library.
 class XWalkExternalInstance : public XWalkExtensionInstance {
  public:
-  XWalkExternalInstance(XWalkExternalExtension* extension,
-                        XW_Instance xw_instance);
+  explicit XWalkExternalInstance(XWalkExternalExtension* extension);
   virtual ~XWalkExternalInstance();
 
+  XW_Instance xw_instance() const { return xw_instance_; }
+
  private:
   friend class XWalkExternalAdapter;
 
   // XWalkExtensionInstance implementation.
   virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE;
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg) OVERRIDE;
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE;
+  virtual void HandleRequest(int request_id,
+                             scoped_ptr<base::Value> msg) OVERRIDE;
 
   // XW_CoreInterface_1 (from XW_Extension.h) implementation.
   void CoreSetInstanceData(void* data);
@@ -47,12 +57,28 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // XW_BinaryMessagingInterface_1 (from XW_Extension_BinaryMessaging.h)
+  // implementation.
+  void BinaryMessagingPostBinaryMessage(const char* data, size_t size);
+
+  // XW_RequestMessagingInterface_1 (from XW_Extension_RequestMessaging.h)
+  // implementation.
+  void RequestMessagingSendReply(int32_t request_id, const char* reply);
+
+  // XW_TaskRunnerInterface_1 (from XW_Extension_TaskRunner.h) implementation.
+  int32_t TaskRunnerPostTask(XW_TaskCallback work, XW_TaskCallback reply,
+                             void* user_data);
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
   void* instance_data_;
   bool is_handling_sync_msg_;
 
+  // Where the instance receives its messages, the replies of the tasks
+  // posted by the extension run there.
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalInstance);
 };
 
@@ -9,9 +9,12 @@
 #include "base/command_line.h"
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
+#include "base/message_loop/message_loop_proxy.h"
+#include "base/stl_util.h"
 #include "ipc/ipc_switches.h"
 #include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 namespace xwalk {
@@ -29,10 +32,24 @@ XWalkExtensionProcess::XWalkExtensionProcess()
 XWalkExtensionProcess::~XWalkExtensionProcess() {
   // FIXME(jeez): Move this to OnChannelClosing/Error/Disconnected when we have
   // our MessageFilter set.
-  extensions_server_.Invalidate();
+  RenderProcessChannelMap::iterator it = render_process_channels_.begin();
+  for (; it != render_process_channels_.end(); ++it)
+    it->second->server->Invalidate();
 
   shutdown_event_.Signal();
   io_thread_.Stop();
+
+  XWalkExtensionMessageStats::GetInstance()->DumpIfRequested();
+
+  STLDeleteValues(&render_process_channels_);
+}
+
+XWalkExtensionProcess::RenderProcessChannel::RenderProcessChannel() {}
+
+XWalkExtensionProcess::RenderProcessChannel::~RenderProcessChannel() {
+  // The channel goes first, so no message reaches a deleted server.
+  channel.reset();
+  server.reset();
 }
 
 bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
@@ -40,6 +57,10 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcess, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_RegisterExtensions,
                         OnRegisterExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CreateRenderProcessChannel,
+                        OnCreateRenderProcessChannel)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_CloseRenderProcessChannel,
+                        OnCloseRenderProcessChannel)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -49,7 +70,6 @@ void XWalkExtensionProcess::OnRegisterExtensions(
     const base::FilePath& path) {
   if (!path.empty())
     RegisterExternalExtensionsInDirectory(&extensions_server_, path);
-  CreateRenderProcessChannel();
 }
 
 void XWalkExtensionProcess::CreateBrowserProcessChannel() {
@@ -61,29 +81,55 @@ void XWalkExtensionProcess::CreateBrowserProcessChannel() {
       true, &shutdown_event_));
 }
 
-void XWalkExtensionProcess::CreateRenderProcessChannel() {
+void XWalkExtensionProcess::OnCreateRenderProcessChannel(
+    int render_process_id) {
+  if (ContainsKey(render_process_channels_, render_process_id)) {
+    LOG(WARNING) << "Channel for render process " << render_process_id
+                 << " already exists.";
+    return;
+  }
+
   IPC::ChannelHandle handle(IPC::Channel::GenerateVerifiedChannelID(
       std::string()));
-  rp_channel_handle_ = handle;
 
-  render_process_channel_.reset(new IPC::SyncChannel(rp_channel_handle_,
-      IPC::Channel::MODE_SERVER, &extensions_server_,
+  scoped_ptr<RenderProcessChannel> rp_channel(new RenderProcessChannel);
+  rp_channel->server.reset(new XWalkExtensionServer);
+  rp_channel->server->RegisterExtensionsFrom(extensions_server_);
+
+  rp_channel->channel.reset(new IPC::SyncChannel(handle,
+      IPC::Channel::MODE_SERVER, rp_channel->server.get(),
       io_thread_.message_loop_proxy(), true, &shutdown_event_));
 
 #if defined(OS_POSIX)
     // On POSIX, pass the server-side file descriptor. We use
     // TakeClientFileDescriptor() instead of GetClientFileDescriptor()
     // since the client-side channel will take ownership of the fd.
-    rp_channel_handle_.socket =
-       base::FileDescriptor(render_process_channel_->TakeClientFileDescriptor(),
+    handle.socket =
+       base::FileDescriptor(rp_channel->channel->TakeClientFileDescriptor(),
           true);
 #endif
 
-  extensions_server_.Initialize(render_process_channel_.get());
+  rp_channel->server->Initialize(rp_channel->channel.get());
+  rp_channel->server->EnableMessageBatchingFromCommandLine(
+      base::MessageLoopProxy::current());
+
+  render_process_channels_[render_process_id] = rp_channel.release();
 
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_RenderProcessChannelCreated(
-          rp_channel_handle_));
+          render_process_id, handle));
+}
+
+void XWalkExtensionProcess::OnCloseRenderProcessChannel(
+    int render_process_id) {
+  RenderProcessChannelMap::iterator it =
+      render_process_channels_.find(render_process_id);
+  if (it == render_process_channels_.end())
+    return;
+
+  scoped_ptr<RenderProcessChannel> rp_channel(it->second);
+  render_process_channels_.erase(it);
+  rp_channel->server->Invalidate();
 }
 
 }  // namespace extensions
@@ -5,6 +5,8 @@
 #ifndef XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_PROCESS_H_
 #define XWALK_EXTENSIONS_EXTENSION_PROCESS_XWALK_EXTENSION_PROCESS_H_
 
+#include <map>
+#include "base/memory/scoped_ptr.h"
 #include "base/values.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
@@ -33,6 +35,10 @@ class XWalkExtensionRunner;
 // of the extension <-> render process channel.
 // It will be responsible for handling the native side (instances) of
 // External extensions through its XWalkExtensionServer.
+//
+// When the process is shared (see switches::kXWalkSharedExtensionProcess) it
+// serves several render processes, each one with its own channel and server.
+// The extensions are loaded only once, the servers share them.
 class XWalkExtensionProcess : public IPC::Listener {
  public:
   XWalkExtensionProcess();
@@ -44,16 +50,27 @@ class XWalkExtensionProcess : public IPC::Listener {
 
   // Handlers for IPC messages from XWalkExtensionProcessHost.
   void OnRegisterExtensions(const base::FilePath& extension_path);
+  void OnCreateRenderProcessChannel(int render_process_id);
+  void OnCloseRenderProcessChannel(int render_process_id);
 
   void CreateBrowserProcessChannel();
-  void CreateRenderProcessChannel();
+
+  struct RenderProcessChannel {
+    RenderProcessChannel();
+    ~RenderProcessChannel();
+    scoped_ptr<XWalkExtensionServer> server;
+    scoped_ptr<IPC::SyncChannel> channel;
+  };
 
   base::WaitableEvent shutdown_event_;
   base::Thread io_thread_;
   scoped_ptr<IPC::SyncChannel> browser_process_channel_;
+
+  // Owns the extensions, but is not connected to any render process.
   XWalkExtensionServer extensions_server_;
-  scoped_ptr<IPC::SyncChannel> render_process_channel_;
-  IPC::ChannelHandle rp_channel_handle_;
+
+  typedef std::map<int, RenderProcessChannel*> RenderProcessChannelMap;
+  RenderProcessChannelMap render_process_channels_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionProcess);
 };
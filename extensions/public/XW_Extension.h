@@ -117,6 +117,9 @@ struct XW_CoreInterface_1 {
   // - extension.setMessageListener(): allow setting a callback that is called
   //                                   when the native code sends a message
   //                                   to JavaScript. Callback takes a string.
+  // - extension.postBinaryMessage(): post an ArrayBuffer to the extension
+  //                                  native code. See
+  //                                  XW_Extension_BinaryMessaging.h.
   //
   // This function should be called only during XW_Initialize().
   void (*SetJavaScriptAPI)(XW_Extension extension, const char* api);
@@ -0,0 +1,59 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGING_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGING_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_BINARY_MESSAGING_INTERFACE: Exchange asynchronous messages carrying raw
+// bytes with JavaScript code provided by extension. Unlike the messages from
+// XW_MESSAGING_INTERFACE, the contents are not converted to a string, so this
+// interface is suited for streaming data like camera frames or sensor batches.
+//
+// In JavaScript, binary messages are sent with extension.postBinaryMessage(),
+// which takes an ArrayBuffer. Binary messages posted by native code are
+// delivered to the listener set with extension.setMessageListener() as an
+// ArrayBuffer.
+//
+
+#define XW_BINARY_MESSAGING_INTERFACE_1 "XW_BinaryMessagingInterface_1"
+#define XW_BINARY_MESSAGING_INTERFACE XW_BINARY_MESSAGING_INTERFACE_1
+
+typedef void (*XW_HandleBinaryMessageCallback)(XW_Instance instance,
+                                               const char* data,
+                                               size_t size);
+
+struct XW_BinaryMessagingInterface_1 {
+  // Register a callback to be called when the JavaScript code associated
+  // with the extension posts a binary message. The data is only valid during
+  // the execution of the callback, so it must be copied if needed later.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleBinaryMessageCallback handle_binary_message);
+
+  // Post a binary message to the web content associated with the instance.
+  // The data is copied before this function returns.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostBinaryMessage)(XW_Instance instance, const char* data,
+                            size_t size);
+};
+
+typedef struct XW_BinaryMessagingInterface_1 XW_BinaryMessagingInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_BINARYMESSAGING_H_
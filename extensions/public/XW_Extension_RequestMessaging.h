@@ -0,0 +1,59 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUESTMESSAGING_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUESTMESSAGING_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_REQUEST_MESSAGING_INTERFACE: Answer requests sent by JavaScript code
+// without blocking the web content. This is meant to replace the synchronous
+// messages from XW_INTERNAL_SYNC_MESSAGING_INTERFACE.
+//
+// In JavaScript, a request is sent with extension.sendRequest(message), that
+// returns a Promise resolved with the reply. A callback can be passed as
+// second argument instead, extension.sendRequest(message, callback), and it
+// will be called with the reply.
+//
+// Each request is identified by a request id, and many requests from the same
+// instance can be pending at the same time. They can be answered in any order.
+//
+
+#define XW_REQUEST_MESSAGING_INTERFACE_1 "XW_RequestMessagingInterface_1"
+#define XW_REQUEST_MESSAGING_INTERFACE XW_REQUEST_MESSAGING_INTERFACE_1
+
+typedef void (*XW_HandleRequestCallback)(XW_Instance instance,
+                                         int32_t request_id,
+                                         const char* message);
+
+struct XW_RequestMessagingInterface_1 {
+  // Register a callback to be called when the JavaScript code associated
+  // with the extension sends a request.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleRequestCallback handle_request);
+
+  // Send the reply for the request identified by 'request_id'. Each request
+  // should be answered only once, but it doesn't need to happen during the
+  // execution of the XW_HandleRequestCallback.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*SendReply)(XW_Instance instance, int32_t request_id,
+                    const char* reply);
+};
+
+typedef struct XW_RequestMessagingInterface_1 XW_RequestMessagingInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_REQUESTMESSAGING_H_
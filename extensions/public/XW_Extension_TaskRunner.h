@@ -0,0 +1,57 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_TASKRUNNER_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_TASKRUNNER_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// XW_TASK_RUNNER_INTERFACE: Run blocking or expensive work (e.g. decoding,
+// cryptography, scanning files) out of the thread handling the messages of
+// the instance, without the extension having to manage its own threads.
+//
+// The work runs in a pool of worker threads shared by all the extensions of
+// the process. Once it finishes, the reply runs in the thread where the
+// instance receives its messages, so it can safely use the instance state
+// and answer to JavaScript.
+//
+
+#define XW_TASK_RUNNER_INTERFACE_1 "XW_TaskRunnerInterface_1"
+#define XW_TASK_RUNNER_INTERFACE XW_TASK_RUNNER_INTERFACE_1
+
+typedef void (*XW_TaskCallback)(XW_Instance instance, void* user_data);
+
+struct XW_TaskRunnerInterface_1 {
+  // Runs 'work' in a worker thread and then 'reply', if not NULL, in the
+  // thread of the instance. Both receive 'user_data', and the extension is
+  // responsible for releasing it, usually at the end of 'reply'. Tasks may
+  // run in any order and at the same time, so 'work' should not touch state
+  // shared with other tasks or with the instance without synchronization.
+  //
+  // The reply is called even if the instance was destroyed meanwhile, so the
+  // data can be released, but then the instance can't be used anymore. If
+  // the extension is shut down before, the reply is not called, and the work
+  // is not called either if it didn't start yet. Shutting down waits for the
+  // work already running to finish.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed. Returns XW_ERROR if the task couldn't be posted.
+  int32_t (*PostTask)(XW_Instance instance, XW_TaskCallback work,
+                      XW_TaskCallback reply, void* user_data);
+};
+
+typedef struct XW_TaskRunnerInterface_1 XW_TaskRunnerInterface;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_TASKRUNNER_H_
@@ -4,9 +4,12 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 
+#include "base/debug/trace_event.h"
 #include "base/values.h"
 #include "base/stl_util.h"
 #include "ipc/ipc_sender.h"
+#include "xwalk/extensions/common/xwalk_extension_binary_message.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 
 namespace xwalk {
@@ -14,10 +17,16 @@ namespace extensions {
 
 XWalkExtensionClient::XWalkExtensionClient()
     : sender_(0),
-      next_instance_id_(1) {  // Zero is never used for a valid instance.
+      next_instance_id_(1),  // Zero is never used for a valid instance.
+      messages_received_(0),
+      ipc_messages_received_(0) {
 }
 
 XWalkExtensionClient::~XWalkExtensionClient() {
+  VLOG(1) << "Extension client received " << messages_received_
+          << " messages in " << ipc_messages_received_ << " IPC messages, "
+          << "dispatching them took " << dispatch_time_.InMilliseconds()
+          << "ms.";
   STLDeleteValues(&extension_apis_);
 }
 
@@ -36,6 +45,7 @@ int64_t XWalkExtensionClient::CreateInstance(
     return 0;
   }
   handlers_[next_instance_id_] = handler;
+  instance_extensions_[next_instance_id_] = extension_name;
   return next_instance_id_++;
 }
 
@@ -44,6 +54,14 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionClient, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessageToJS,
         OnPostMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostMessagesToJS,
+        OnPostMessagesToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostReplyToJS,
+        OnPostReplyToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostBinaryMessageToJS,
+        OnPostBinaryMessageToJS)
+    IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_PostSharedBinaryMessageToJS,
+        OnPostSharedBinaryMessageToJS)
     IPC_MESSAGE_HANDLER(XWalkExtensionClientMsg_InstanceDestroyed,
         OnInstanceDestroyed)
     IPC_MESSAGE_UNHANDLED(handled = false)
@@ -52,7 +70,9 @@ bool XWalkExtensionClient::OnMessageReceived(const IPC::Message& message) {
   return handled;
 }
 
-XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints() {
+XWalkExtensionClient::ExtensionCodePoints::ExtensionCodePoints()
+    : api_hash(0),
+      api_size(0) {
 }
 
 XWalkExtensionClient::ExtensionCodePoints::~ExtensionCodePoints() {
@@ -71,9 +91,91 @@ void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
   if (!it->second)
     return;
 
+  const base::TimeTicks start_time = base::TimeTicks::Now();
   const base::Value* value;
   msg.Get(0, &value);
   it->second->HandleMessageFromNative(*value);
+
+  messages_received_++;
+  ipc_messages_received_++;
+  dispatch_time_ += base::TimeTicks::Now() - start_time;
+}
+
+void XWalkExtensionClient::OnPostMessagesToJS(int64_t instance_id,
+                                              const base::ListValue& msgs) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostMessages to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  it->second->HandleMessagesFromNative(msgs);
+
+  messages_received_ += msgs.GetSize();
+  ipc_messages_received_++;
+  dispatch_time_ += base::TimeTicks::Now() - start_time;
+}
+
+void XWalkExtensionClient::OnPostReplyToJS(int64_t instance_id,
+                                           int request_id,
+                                           const base::ListValue& reply) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostReply to invalid Extension instance id: "
+                 << instance_id;
+    return;
+  }
+
+  // See comment in DestroyInstance() about two step destruction.
+  if (!it->second)
+    return;
+
+  const base::Value* value;
+  reply.Get(0, &value);
+  it->second->HandleReplyFromNative(request_id, *value);
+}
+
+XWalkExtensionClient::InstanceHandler* XWalkExtensionClient::GetHandler(
+    int64_t instance_id) {
+  HandlerMap::const_iterator it = handlers_.find(instance_id);
+  if (it == handlers_.end()) {
+    LOG(WARNING) << "Can't PostBinaryMessage to invalid Extension instance id: "
+                 << instance_id;
+    return NULL;
+  }
+
+  // See comment in DestroyInstance() about two step destruction. A NULL
+  // handler here means the message can be silently ignored.
+  return it->second;
+}
+
+void XWalkExtensionClient::OnPostBinaryMessageToJS(int64_t instance_id,
+                                                   const std::string& data) {
+  InstanceHandler* handler = GetHandler(instance_id);
+  if (!handler)
+    return;
+  handler->HandleBinaryMessageFromNative(data.data(), data.size());
+}
+
+void XWalkExtensionClient::OnPostSharedBinaryMessageToJS(
+    int64_t instance_id, base::SharedMemoryHandle handle, uint32_t size) {
+  // Map the segment even if the handler is gone, so the handle is closed.
+  scoped_ptr<base::SharedMemory> shared_memory =
+      MapSharedBinaryMessage(handle, size);
+  if (!shared_memory)
+    return;
+
+  InstanceHandler* handler = GetHandler(instance_id);
+  if (!handler)
+    return;
+  handler->HandleBinaryMessageFromNative(
+      static_cast<const char*>(shared_memory->memory()), size);
 }
 
 void XWalkExtensionClient::DestroyInstance(int64_t instance_id) {
@@ -104,6 +206,7 @@ void XWalkExtensionClient::OnInstanceDestroyed(int64_t instance_id) {
   // instances.
   DCHECK(!it->second);
   handlers_.erase(it);
+  instance_extensions_.erase(instance_id);
 }
 
 namespace {
@@ -130,18 +233,51 @@ void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
   Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
 }
 
+void XWalkExtensionClient::PostBinaryMessageToNative(int64_t instance_id,
+    const char* data, size_t size) {
+  Send(CreateBinaryMessage<
+           XWalkExtensionServerMsg_PostBinaryMessageToNative,
+           XWalkExtensionServerMsg_PostSharedBinaryMessageToNative>(
+               instance_id, data, size));
+}
+
+void XWalkExtensionClient::SendRequestToNative(int64_t instance_id,
+    int request_id, scoped_ptr<base::Value> msg) {
+  scoped_ptr<base::ListValue> list_msg = WrapValueInList(msg.Pass());
+  Send(new XWalkExtensionServerMsg_SendRequestToNative(instance_id, request_id,
+                                                       *list_msg));
+}
+
 scoped_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, scoped_ptr<base::Value> msg) {
   scoped_ptr<base::ListValue> wrapped_msg = WrapValueInList(msg.Pass());
   base::ListValue* wrapped_reply = new base::ListValue;
+
+  std::string extension_name;
+  InstanceExtensionMap::const_iterator it =
+      instance_extensions_.find(instance_id);
+  if (it != instance_extensions_.end())
+    extension_name = it->second;
+  TRACE_EVENT1("xwalk", "XWalkExtensionClient::SendSyncMessageToNative",
+               "extension", TRACE_STR_COPY(extension_name.c_str()));
+  const base::TimeTicks start_time = base::TimeTicks::Now();
   Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
       *wrapped_msg, wrapped_reply));
+  XWalkExtensionMessageStats::GetInstance()->RecordSyncRoundTripTime(
+      extension_name, base::TimeTicks::Now() - start_time);
 
   scoped_ptr<base::Value> reply;
   wrapped_reply->Remove(0, &reply);
   return reply.Pass();
 }
 
+std::string XWalkExtensionClient::GetExtensionAPI(
+    const std::string& extension_name) {
+  std::string js_api;
+  Send(new XWalkExtensionServerMsg_GetExtensionAPI(extension_name, &js_api));
+  return js_api;
+}
+
 void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
   sender_ = sender;
 
@@ -155,7 +291,8 @@ void XWalkExtensionClient::Initialize(IPC::Sender* sender) {
       extensions.begin();
   for (; it != extensions.end(); ++it) {
     ExtensionCodePoints* codepoint = new ExtensionCodePoints;
-    codepoint->api = (*it).js_api;
+    codepoint->api_hash = (*it).js_api_hash;
+    codepoint->api_size = (*it).js_api_size;
 
     codepoint->entry_points = (*it).entry_points;
 
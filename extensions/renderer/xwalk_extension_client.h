@@ -11,6 +11,8 @@
 #include <vector>
 
 #include "base/memory/scoped_ptr.h"
+#include "base/memory/shared_memory.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "ipc/ipc_listener.h"
 
@@ -36,6 +38,14 @@ class XWalkExtensionClient : public IPC::Listener {
  public:
   struct InstanceHandler {
     virtual void HandleMessageFromNative(const base::Value& msg) = 0;
+    // Handles a batch of messages coalesced by the server, in order.
+    virtual void HandleMessagesFromNative(const base::ListValue& msgs) = 0;
+    // Handles the reply to a request sent with SendRequestToNative().
+    virtual void HandleReplyFromNative(int request_id,
+                                       const base::Value& reply) = 0;
+    // The |data| is only valid during the execution of this function.
+    virtual void HandleBinaryMessageFromNative(const char* data,
+                                               size_t size) = 0;
    protected:
     ~InstanceHandler() {}
   };
@@ -48,18 +58,30 @@ class XWalkExtensionClient : public IPC::Listener {
   void DestroyInstance(int64_t instance_id);
 
   void PostMessageToNative(int64_t instance_id, scoped_ptr<base::Value> msg);
+  void PostBinaryMessageToNative(int64_t instance_id, const char* data,
+                                 size_t size);
   scoped_ptr<base::Value> SendSyncMessageToNative(int64_t instance_id,
       scoped_ptr<base::Value> msg);
+  // Sends a request without blocking, the reply will be delivered to the
+  // instance handler with the same |request_id|, chosen by the caller.
+  void SendRequestToNative(int64_t instance_id, int request_id,
+                           scoped_ptr<base::Value> msg);
 
   void Initialize(IPC::Sender* sender);
 
+  // Fetches the JavaScript API source of an extension. Initialize() only
+  // gets its hash, so the source is only transferred for the extensions that
+  // are actually used.
+  std::string GetExtensionAPI(const std::string& extension_name);
+
   // IPC::Listener Implementation.
   virtual bool OnMessageReceived(const IPC::Message& message) OVERRIDE;
 
   struct ExtensionCodePoints {
     ExtensionCodePoints();
     ~ExtensionCodePoints();
-    std::string api;
+    uint32_t api_hash;
+    uint32_t api_size;
     std::vector<std::string> entry_points;
   };
 
@@ -67,12 +89,28 @@ class XWalkExtensionClient : public IPC::Listener {
 
   const ExtensionAPIMap& extension_apis() const { return extension_apis_; }
 
+  // Number of messages received from the server, number of IPC messages
+  // used to deliver them and time spent dispatching them to the instance
+  // handlers. Used to evaluate message batching.
+  uint64 messages_received() const { return messages_received_; }
+  uint64 ipc_messages_received() const { return ipc_messages_received_; }
+  base::TimeDelta dispatch_time() const { return dispatch_time_; }
+
  private:
   bool Send(IPC::Message* msg);
 
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
   void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessagesToJS(int64_t instance_id, const base::ListValue& msgs);
+  void OnPostReplyToJS(int64_t instance_id, int request_id,
+                       const base::ListValue& reply);
+  void OnPostBinaryMessageToJS(int64_t instance_id, const std::string& data);
+  void OnPostSharedBinaryMessageToJS(int64_t instance_id,
+                                     base::SharedMemoryHandle handle,
+                                     uint32_t size);
+
+  InstanceHandler* GetHandler(int64_t instance_id);
 
   IPC::Sender* sender_;
   ExtensionAPIMap extension_apis_;
@@ -80,7 +118,15 @@ class XWalkExtensionClient : public IPC::Listener {
   typedef std::map<int64_t, InstanceHandler*> HandlerMap;
   HandlerMap handlers_;
 
+  // Used to attribute the sync message round trips to each extension.
+  typedef std::map<int64_t, std::string> InstanceExtensionMap;
+  InstanceExtensionMap instance_extensions_;
+
   int64_t next_instance_id_;
+
+  uint64 messages_received_;
+  uint64 ipc_messages_received_;
+  base::TimeDelta dispatch_time_;
 };
 
 }  // namespace extensions
@@ -5,13 +5,16 @@
 
 #include "xwalk/extensions/renderer/xwalk_extension_module.h"
 
+#include <string.h>
 #include "base/logging.h"
 #include "base/strings/stringprintf.h"
 #include "base/values.h"
 #include "content/public/renderer/v8_value_converter.h"
+#include "third_party/WebKit/public/web/WebArrayBuffer.h"
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
+#include "xwalk/extensions/renderer/xwalk_script_cache.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
 
 namespace xwalk {
@@ -28,9 +31,10 @@ const char* kXWalkExtensionModule = "kXWalkExtensionModule";
 XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
                                            XWalkModuleSystem* module_system,
                                            const std::string& extension_name,
-                                           const std::string& extension_code)
-    : extension_name_(extension_name),
-      extension_code_(extension_code),
+                                           uint32_t extension_code_hash)
+    : next_request_id_(1),
+      extension_name_(extension_name),
+      extension_code_hash_(extension_code_hash),
       converter_(content::V8ValueConverter::create()),
       client_(client),
       module_system_(module_system),
@@ -45,6 +49,12 @@ XWalkExtensionModule::XWalkExtensionModule(XWalkExtensionClient* client,
   object_template->Set(
       "postMessage",
       v8::FunctionTemplate::New(PostMessageCallback, function_data));
+  object_template->Set(
+      "postBinaryMessage",
+      v8::FunctionTemplate::New(PostBinaryMessageCallback, function_data));
+  object_template->Set(
+      "sendRequest",
+      v8::FunctionTemplate::New(SendRequestCallback, function_data));
   object_template->Set(
       "sendSyncMessage",
       v8::FunctionTemplate::New(SendSyncMessageCallback, function_data));
@@ -77,6 +87,13 @@ XWalkExtensionModule::~XWalkExtensionModule() {
   message_listener_.Dispose();
   message_listener_.Clear();
 
+  PendingRequestMap::iterator it = pending_requests_.begin();
+  for (; it != pending_requests_.end(); ++it) {
+    it->second->Dispose();
+    delete it->second;
+  }
+  pending_requests_.clear();
+
   if (instance_id_)
     client_->DestroyInstance(instance_id_);
 }
@@ -109,27 +126,25 @@ std::string WrapAPICode(const std::string& extension_code,
       "extension.internal = {};"
       "extension.internal.sendSyncMessage = extension.sendSyncMessage;"
       "delete extension.sendSyncMessage;"
+      "extension.sendRequest = (function(sendRequest) {"
+      "  return function(msg, callback) {"
+      "    if (callback || typeof Promise !== 'function')"
+      "      return sendRequest(msg, callback);"
+      "    return new Promise(function(resolve) {"
+      "      sendRequest(msg, resolve); }); }; })(extension.sendRequest);"
       "return (function(exports) {'use strict'; %s\n})(%s); });",
       CodeToEnsureNamespace(extension_name).c_str(),
       extension_code.c_str(),
       extension_name.c_str());
 }
 
-v8::Handle<v8::Value> RunString(const std::string& code,
+v8::Handle<v8::Value> RunScript(v8::Handle<v8::Script> script,
                                 std::string* exception) {
   v8::HandleScope handle_scope(v8::Isolate::GetCurrent());
-  v8::Handle<v8::String> v8_code(v8::String::New(code.c_str()));
-
   WebKit::WebScopedMicrotaskSuppression suppression;
   v8::TryCatch try_catch;
   try_catch.SetVerbose(true);
 
-  v8::Handle<v8::Script> script(v8::Script::New(v8_code, v8::String::Empty()));
-  if (try_catch.HasCaught()) {
-    *exception = ExceptionToString(try_catch);
-    return v8::Undefined();
-  }
-
   v8::Handle<v8::Value> result = script->Run();
   if (try_catch.HasCaught()) {
     *exception = ExceptionToString(try_catch);
@@ -147,10 +162,11 @@ void XWalkExtensionModule::LoadExtensionCode(
   instance_id_ = client_->CreateInstance(extension_name_, this);
 
   std::string exception;
-  std::string wrapped_api_code = WrapAPICode(extension_code_, extension_name_);
-  v8::Handle<v8::Value> result =
-      RunString(wrapped_api_code, &exception);
-  if (!result->IsFunction()) {
+  v8::Handle<v8::Value> result;
+  v8::Handle<v8::Script> script = GetExtensionScript(&exception);
+  if (!script.IsEmpty())
+    result = RunScript(script, &exception);
+  if (result.IsEmpty() || !result->IsFunction()) {
     LOG(WARNING) << "Couldn't load JS API code for " << extension_name_
       << ": " << exception;
     return;
@@ -177,6 +193,22 @@ void XWalkExtensionModule::LoadExtensionCode(
   }
 }
 
+v8::Handle<v8::Script> XWalkExtensionModule::GetExtensionScript(
+    std::string* exception) {
+  // The code is compiled only the first time, see XWalkScriptCache. Until
+  // then, the source of the API is not even in the Render Process.
+  XWalkScriptCache* cache = XWalkScriptCache::GetInstance();
+  v8::Handle<v8::Script> script =
+      cache->Lookup(extension_name_, extension_code_hash_);
+  if (!script.IsEmpty())
+    return script;
+
+  std::string extension_code = client_->GetExtensionAPI(extension_name_);
+  return cache->Compile(extension_name_, extension_code_hash_,
+                        WrapAPICode(extension_code, extension_name_),
+                        exception);
+}
+
 void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
   if (message_listener_.IsEmpty())
     return;
@@ -186,13 +218,89 @@ void XWalkExtensionModule::HandleMessageFromNative(const base::Value& msg) {
   v8::Handle<v8::Context> context = module_system_->GetV8Context();
   v8::Context::Scope context_scope(context);
 
-  v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&msg, context));
+  DispatchToMessageListener(converter_->ToV8Value(&msg, context));
+}
+
+void XWalkExtensionModule::HandleMessagesFromNative(
+    const base::ListValue& msgs) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  // Enter the context only once for the whole batch.
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  for (size_t i = 0; i < msgs.GetSize(); ++i) {
+    // The listener might be unset by a previous message of the batch.
+    if (message_listener_.IsEmpty())
+      return;
+
+    v8::HandleScope message_scope(isolate);
+    const base::Value* msg;
+    msgs.Get(i, &msg);
+    DispatchToMessageListener(converter_->ToV8Value(msg, context));
+  }
+}
+
+void XWalkExtensionModule::HandleReplyFromNative(int request_id,
+                                                 const base::Value& reply) {
+  PendingRequestMap::iterator it = pending_requests_.find(request_id);
+  if (it == pending_requests_.end())
+    return;
+
+  scoped_ptr<v8::Persistent<v8::Function> > persistent_callback(it->second);
+  pending_requests_.erase(it);
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  v8::Handle<v8::Function> callback =
+      v8::Handle<v8::Function>::New(isolate, *persistent_callback);
+  persistent_callback->Dispose();
+
+  v8::Handle<v8::Value> v8_value(converter_->ToV8Value(&reply, context));
+
+  WebKit::WebScopedMicrotaskSuppression suppression;
+  v8::TryCatch try_catch;
+  callback->Call(context->Global(), 1, &v8_value);
+  if (try_catch.HasCaught())
+    LOG(WARNING) << "Exception when running request callback: "
+        << ExceptionToString(try_catch);
+}
+
+void XWalkExtensionModule::HandleBinaryMessageFromNative(const char* data,
+                                                         size_t size) {
+  if (message_listener_.IsEmpty())
+    return;
+
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::HandleScope handle_scope(isolate);
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
+  v8::Context::Scope context_scope(context);
+
+  // The bytes are copied straight into the ArrayBuffer backing store, no
+  // intermediate base::Value is created.
+  WebKit::WebArrayBuffer buffer = WebKit::WebArrayBuffer::create(size, 1);
+  if (size)
+    memcpy(buffer.data(), data, size);
+
+  DispatchToMessageListener(buffer.toV8Value());
+}
+
+void XWalkExtensionModule::DispatchToMessageListener(
+    v8::Handle<v8::Value> value) {
+  v8::Isolate* isolate = v8::Isolate::GetCurrent();
+  v8::Handle<v8::Context> context = module_system_->GetV8Context();
   v8::Handle<v8::Function> message_listener =
-      v8::Handle<v8::Function>::New(isolate, message_listener_);;
+      v8::Handle<v8::Function>::New(isolate, message_listener_);
 
   WebKit::WebScopedMicrotaskSuppression suppression;
   v8::TryCatch try_catch;
-  message_listener->Call(context->Global(), 1, &v8_value);
+  message_listener->Call(context->Global(), 1, &value);
   if (try_catch.HasCaught())
     LOG(WARNING) << "Exception when running message listener: "
         << ExceptionToString(try_catch);
@@ -217,6 +325,65 @@ void XWalkExtensionModule::PostMessageCallback(
   result.Set(true);
 }
 
+// static
+void XWalkExtensionModule::PostBinaryMessageCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() != 1) {
+    result.Set(false);
+    return;
+  }
+
+  scoped_ptr<WebKit::WebArrayBuffer> buffer(
+      WebKit::WebArrayBuffer::createFromV8Value(info[0]));
+  if (!buffer) {
+    LOG(WARNING) << "Trying to post binary message with invalid value.";
+    result.Set(false);
+    return;
+  }
+
+  CHECK(module->instance_id_);
+  module->client_->PostBinaryMessageToNative(
+      module->instance_id_, static_cast<const char*>(buffer->data()),
+      buffer->byteLength());
+  result.Set(true);
+}
+
+// static
+void XWalkExtensionModule::SendRequestCallback(
+    const v8::FunctionCallbackInfo<v8::Value>& info) {
+  v8::ReturnValue<v8::Value> result(info.GetReturnValue());
+  XWalkExtensionModule* module = GetExtensionModule(info);
+  if (!module || info.Length() < 1 || info.Length() > 2) {
+    result.Set(false);
+    return;
+  }
+
+  if (info.Length() == 2 && !info[1]->IsFunction() &&
+      !info[1]->IsUndefined()) {
+    LOG(WARNING) << "Trying to send request with invalid callback.";
+    result.Set(false);
+    return;
+  }
+
+  v8::Handle<v8::Context> context = info.GetIsolate()->GetCurrentContext();
+  scoped_ptr<base::Value> value(
+      module->converter_->FromV8Value(info[0], context));
+
+  // Without a callback the reply is simply dropped.
+  const int request_id = module->next_request_id_++;
+  if (info.Length() == 2 && info[1]->IsFunction()) {
+    module->pending_requests_[request_id] = new v8::Persistent<v8::Function>(
+        info.GetIsolate(), info[1].As<v8::Function>());
+  }
+
+  CHECK(module->instance_id_);
+  module->client_->SendRequestToNative(module->instance_id_, request_id,
+                                       value.Pass());
+  result.Set(true);
+}
+
 // static
 void XWalkExtensionModule::SendSyncMessageCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
@@ -5,6 +5,7 @@
 #ifndef XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 #define XWALK_EXTENSIONS_RENDERER_XWALK_EXTENSION_MODULE_H_
 
+#include <map>
 #include <string>
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
 #include "xwalk/extensions/renderer/xwalk_module_system.h"
@@ -34,7 +35,7 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   XWalkExtensionModule(XWalkExtensionClient* client,
                        XWalkModuleSystem* module_system,
                        const std::string& extension_name,
-                       const std::string& extension_code);
+                       uint32_t extension_code_hash);
   virtual ~XWalkExtensionModule();
 
   // TODO(cmarcelo): Make this return a v8::Handle<v8::Object>, and
@@ -47,10 +48,25 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
  private:
   // XWalkExtensionClient::InstanceHandler implementation.
   virtual void HandleMessageFromNative(const base::Value& msg) OVERRIDE;
+  virtual void HandleMessagesFromNative(const base::ListValue& msgs) OVERRIDE;
+  virtual void HandleReplyFromNative(int request_id,
+                                     const base::Value& reply) OVERRIDE;
+  virtual void HandleBinaryMessageFromNative(const char* data,
+                                             size_t size) OVERRIDE;
+
+  void DispatchToMessageListener(v8::Handle<v8::Value> value);
+
+  // Returns the compiled JS API code, fetching its source from the server
+  // if no other module of this extension was loaded before.
+  v8::Handle<v8::Script> GetExtensionScript(std::string* exception);
 
   // Callbacks for JS functions available in 'extension' object.
   static void PostMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void PostBinaryMessageCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
+  static void SendRequestCallback(
+      const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SendSyncMessageCallback(
       const v8::FunctionCallbackInfo<v8::Value>& info);
   static void SetMessageListenerCallback(
@@ -70,8 +86,15 @@ class XWalkExtensionModule : public XWalkExtensionClient::InstanceHandler {
   // This value is registered by using 'extension.setMessageListener()'.
   v8::Persistent<v8::Function> message_listener_;
 
+  // Callbacks waiting for the reply of requests sent with
+  // 'extension.sendRequest()', indexed by request id.
+  typedef std::map<int, v8::Persistent<v8::Function>*> PendingRequestMap;
+  PendingRequestMap pending_requests_;
+  int next_request_id_;
+
   std::string extension_name_;
-  std::string extension_code_;
+  // Hash of the JS API source, identifies its compiled code.
+  uint32_t extension_code_hash_;
 
   // TODO(cmarcelo): Move to a single converter, since we always use same
   // parameters.
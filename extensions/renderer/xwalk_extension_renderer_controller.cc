@@ -5,6 +5,10 @@
 #include "xwalk/extensions/renderer/xwalk_extension_renderer_controller.h"
 
 #include "base/command_line.h"
+#include "base/debug/trace_event.h"
+#include "base/logging.h"
+#include "base/metrics/histogram.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "content/public/renderer/render_thread.h"
 #include "content/public/renderer/v8_value_converter.h"
@@ -16,6 +20,7 @@
 #include "third_party/WebKit/public/web/WebFrame.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
 #include "v8/include/v8.h"
+#include "xwalk/extensions/common/xwalk_extension_message_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 #include "xwalk/extensions/renderer/xwalk_extension_client.h"
@@ -65,11 +70,11 @@ void CreateExtensionModules(XWalkExtensionClient* client,
   XWalkExtensionClient::ExtensionAPIMap::const_iterator it = extensions.begin();
   for (; it != extensions.end(); ++it) {
     XWalkExtensionClient::ExtensionCodePoints* codepoint = it->second;
-    if (codepoint->api.empty())
+    if (!codepoint->api_size)
       continue;
     scoped_ptr<XWalkExtensionModule> module(
         new XWalkExtensionModule(client, module_system,
-                                 it->first, codepoint->api));
+                                 it->first, codepoint->api_hash));
     module_system->RegisterExtensionModule(module.Pass(),
                                            codepoint->entry_points);
   }
@@ -113,6 +118,7 @@ bool XWalkExtensionRendererController::OnControlMessageReceived(
 }
 
 void XWalkExtensionRendererController::OnRenderProcessShutdown() {
+  XWalkExtensionMessageStats::GetInstance()->DumpIfRequested();
   shutdown_event_.Signal();
 }
 
@@ -125,9 +131,22 @@ void XWalkExtensionRendererController::SetupBrowserProcessClient(
 void XWalkExtensionRendererController::SetupExtensionProcessClient(
     IPC::SyncChannel* browser_channel) {
   IPC::ChannelHandle handle;
-  browser_channel->Send(
-      new XWalkExtensionProcessHostMsg_GetExtensionProcessChannel(&handle));
-  // FIXME(cmarcelo): Need to account for failure in creating the channel.
+  {
+    // The render process is blocked until the extension process is launched
+    // and has loaded the extensions, unless a prestarted one was available.
+    TRACE_EVENT0("xwalk", "GetExtensionProcessChannel");
+    const base::TimeTicks start_time = base::TimeTicks::Now();
+    browser_channel->Send(
+        new XWalkExtensionProcessHostMsg_GetExtensionProcessChannel(&handle));
+    UMA_HISTOGRAM_TIMES("XWalk.Extensions.ExtensionProcessChannelWaitTime",
+                        base::TimeTicks::Now() - start_time);
+  }
+  // The browser replies with an empty handle when there's no extension
+  // process for us, the external extensions are not available then.
+  if (handle.name.empty()) {
+    LOG(WARNING) << "Couldn't get the extension process channel.";
+    return;
+  }
 
   external_extensions_client_.reset(new XWalkExtensionClient);
   extension_process_channel_.reset(new IPC::SyncChannel(handle,
@@ -22,6 +22,25 @@ function wrapCallback(args, callback) {
   return id;
 }
 
+// Binary messages start with a tag: one byte with the tag length followed by
+// the tag itself, the remaining bytes are the payload. Messages coming from
+// the native side are tagged with the callback id and the callback gets the
+// payload as an ArrayBuffer.
+function handleBinaryMessage(buffer) {
+  var bytes = new Uint8Array(buffer);
+  if (!bytes.length || bytes.length < 1 + bytes[0])
+    return;
+
+  var tag_length = bytes[0];
+  var id = String.fromCharCode.apply(null, bytes.subarray(1, 1 + tag_length));
+  var listener = callback_listeners[id];
+
+  if (listener !== undefined) {
+    if (!listener(buffer.slice(1 + tag_length)))
+      delete callback_listeners[id];
+  }
+}
+
 exports.setupInternalExtension = function(extension_obj) {
   if (extension_object != null)
     return;
@@ -29,6 +48,11 @@ exports.setupInternalExtension = function(extension_obj) {
   extension_object = extension_obj;
 
   extension_object.setMessageListener(function(msg) {
+    if (msg instanceof ArrayBuffer) {
+      handleBinaryMessage(msg);
+      return;
+    }
+
     var args = arguments[0];
     var id = args.shift();
     var listener = callback_listeners[id];
@@ -48,6 +72,25 @@ exports.postMessage = function(function_name, args, callback) {
   return id;
 };
 
+// Sends the bytes of |data|, an ArrayBuffer or a view of one, tagged with the
+// string |tag| so the native side knows where to deliver them. The tag must
+// be ASCII and shorter than 256 characters.
+exports.postBinaryMessage = function(tag, data) {
+  var bytes;
+  if (data instanceof ArrayBuffer)
+    bytes = new Uint8Array(data);
+  else
+    bytes = new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+
+  var message = new Uint8Array(1 + tag.length + bytes.length);
+  message[0] = tag.length;
+  for (var i = 0; i < tag.length; ++i)
+    message[1 + i] = tag.charCodeAt(i);
+  message.set(bytes, 1 + tag.length);
+
+  return extension_object.postBinaryMessage(message.buffer);
+};
+
 exports.removeCallback = function(id) {
   if (!id in callback_listeners)
     return;
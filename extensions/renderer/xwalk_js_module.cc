@@ -7,6 +7,7 @@
 #include "base/logging.h"
 #include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
 #include "ui/base/resource/resource_bundle.h"
+#include "xwalk/extensions/renderer/xwalk_script_cache.h"
 #include "xwalk/extensions/renderer/xwalk_v8_utils.h"
 
 namespace xwalk {
@@ -60,13 +61,13 @@ bool XWalkJSModule::Compile(std::string* error) {
       "'use strict'; (function() { var exports = {}; (function(exports) {"
       + js_code_ + "})(exports); return exports; })()";
 
-  v8::Handle<v8::String> v8_code(v8::String::New(wrapped_js_code.c_str()));
-
-  WebKit::WebScopedMicrotaskSuppression suppression;
-  v8::TryCatch try_catch;
-  v8::Handle<v8::Script> script(v8::Script::New(v8_code, v8::String::Empty()));
-  if (try_catch.HasCaught()) {
-    *error = "Error compiling JS module: " + ExceptionToString(try_catch);
+  // The same modules are used by every script context, so their compiled
+  // code is shared.
+  std::string exception;
+  v8::Handle<v8::Script> script = XWalkScriptCache::GetInstance()->GetScript(
+      std::string(), wrapped_js_code, &exception);
+  if (script.IsEmpty()) {
+    *error = "Error compiling JS module: " + exception;
     return false;
   }
 
@@ -7,6 +7,7 @@
 #include <algorithm>
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/metrics/histogram.h"
 #include "base/stl_util.h"
 #include "base/strings/string_split.h"
 #include "v8/include/v8.h"
@@ -62,6 +63,13 @@ void RequireNativeCallback(const v8::FunctionCallbackInfo<v8::Value>& info) {
   result.Set(object);
 }
 
+// The switch is checked only once, instead of for every new context.
+bool IsLoadingExtensionsOnDemandEnabled() {
+  static const bool enabled = !CommandLine::ForCurrentProcess()->HasSwitch(
+      switches::kXWalkDisableLoadingExtensionsOnDemand);
+  return enabled;
+}
+
 }  // namespace
 
 XWalkModuleSystem::XWalkModuleSystem(v8::Handle<v8::Context> context) {
@@ -80,6 +88,7 @@ XWalkModuleSystem::XWalkModuleSystem(v8::Handle<v8::Context> context) {
 }
 
 XWalkModuleSystem::~XWalkModuleSystem() {
+  RecordLoadedExtensionModules();
   DeleteExtensionModules();
   STLDeleteValues(&native_modules_);
 
@@ -209,6 +218,13 @@ v8::Handle<v8::Value> GetObjectForPath(v8::Handle<v8::Context> context,
   return object;
 }
 
+// Returns whether |name| is |ns| or is inside of it, considering "." as a
+// separator. So "a" and "a.b" are in "a", but "ab" is not.
+bool IsInNamespace(const std::string& name, const std::string& ns) {
+  return name.compare(0, ns.size(), ns) == 0 &&
+      (name.size() == ns.size() || name[ns.size()] == '.');
+}
+
 }  // namespace
 
 bool XWalkModuleSystem::SetTrampolineAccessorForEntryPoint(
@@ -258,6 +274,10 @@ bool XWalkModuleSystem::DeleteAccessorForEntryPoint(
 
 bool XWalkModuleSystem::InstallTrampoline(v8::Handle<v8::Context> context,
                                           ExtensionModuleEntry* entry) {
+  // The trampolines installed before for the entry points outside the
+  // namespace, see InstallExternalTrampolines(), are installed again.
+  RemoveTrampolines(context, entry);
+
   v8::Local<v8::External> entry_ptr = v8::External::New(entry);
   bool ret;
 
@@ -267,21 +287,48 @@ bool XWalkModuleSystem::InstallTrampoline(v8::Handle<v8::Context> context,
                  << entry->name << "'.";
     return false;
   }
+  entry->trampolines.push_back(entry->name);
 
   std::vector<std::string>::const_iterator it = entry->entry_points.begin();
   for (; it != entry->entry_points.end(); ++it) {
     ret = SetTrampolineAccessorForEntryPoint(context, *it, entry_ptr);
     if (!ret) {
-      // TODO(vcgomes): Remove already added trampolines when it fails.
+      // The trampolines already added are removed when the module is loaded.
       LOG(WARNING) << "Error installing trampoline for '"
                    << entry->name << "'.";
       return false;
     }
+    entry->trampolines.push_back(*it);
   }
 
   return true;
 }
 
+void XWalkModuleSystem::InstallExternalTrampolines(
+    v8::Handle<v8::Context> context, ExtensionModuleEntry* entry) {
+  const ExtensionModuleEntry* root = entry;
+  while (root->parent)
+    root = root->parent;
+
+  v8::Local<v8::External> entry_ptr = v8::External::New(entry);
+  std::vector<std::string>::const_iterator it = entry->entry_points.begin();
+  for (; it != entry->entry_points.end(); ++it) {
+    if (IsInNamespace(*it, root->name))
+      continue;
+    if (SetTrampolineAccessorForEntryPoint(context, *it, entry_ptr))
+      entry->trampolines.push_back(*it);
+  }
+}
+
+// static
+void XWalkModuleSystem::RemoveTrampolines(v8::Handle<v8::Context> context,
+                                          ExtensionModuleEntry* entry) {
+  std::vector<std::string>::const_iterator it = entry->trampolines.begin();
+  for (; it != entry->trampolines.end(); ++it)
+    DeleteAccessorForEntryPoint(context, *it);
+  entry->trampolines.clear();
+}
+
 v8::Handle<v8::Object> XWalkModuleSystem::RequireNative(
     const std::string& name) {
   NativeModuleMap::iterator it = native_modules_.find(name);
@@ -291,28 +338,62 @@ v8::Handle<v8::Object> XWalkModuleSystem::RequireNative(
 }
 
 void XWalkModuleSystem::Initialize() {
-  CommandLine* cmd_line = CommandLine::ForCurrentProcess();
-  const bool on_demand_enabled =
-      !cmd_line->HasSwitch(switches::kXWalkDisableLoadingExtensionsOnDemand);
-
   v8::Isolate* isolate = v8::Isolate::GetCurrent();
   v8::HandleScope handle_scope(isolate);
-
   v8::Handle<v8::Context> context = GetV8Context();
+
+  SetParentsOfExtensionModules();
+
+  // The modules nested in another one are set up only after their parent is
+  // loaded, since the parent code replaces its namespace object. Until then
+  // only their entry points outside of that namespace get a trampoline.
+  ExtensionModules::iterator it = extension_modules_.begin();
+  for (; it != extension_modules_.end(); ++it) {
+    if (!it->parent)
+      SetupExtensionModule(context, &*it);
+    else if (!it->parent->loaded && IsLoadingExtensionsOnDemandEnabled())
+      InstallExternalTrampolines(context, &*it);
+  }
+}
+
+void XWalkModuleSystem::SetupExtensionModule(v8::Handle<v8::Context> context,
+                                             ExtensionModuleEntry* entry) {
+  if (IsLoadingExtensionsOnDemandEnabled()) {
+    if (InstallTrampoline(context, entry))
+      return;
+  }
+  LoadExtensionModule(context, entry);
+}
+
+void XWalkModuleSystem::LoadExtensionModule(v8::Handle<v8::Context> context,
+                                            ExtensionModuleEntry* entry) {
+  // Loading a module might end up loading others, e.g. when its code uses
+  // another extension, so make sure it is loaded only once.
+  if (entry->loaded)
+    return;
+
+  // A nested module is reached before its parent through the entry points
+  // outside the namespace. Loading the parent sets this module up again, or
+  // loads it if loading on demand is disabled.
+  if (entry->parent) {
+    LoadExtensionModule(context, entry->parent);
+    if (entry->loaded)
+      return;
+  }
+
+  RemoveTrampolines(context, entry);
+  entry->loaded = true;
+
+  v8::Isolate* isolate = context->GetIsolate();
   v8::Handle<v8::FunctionTemplate> require_native_template =
       v8::Handle<v8::FunctionTemplate>::New(isolate, require_native_template_);
-  v8::Handle<v8::Function> require_native =
-      require_native_template->GetFunction();
-
-  MarkModulesWithTrampoline();
+  entry->module->LoadExtensionCode(context,
+                                   require_native_template->GetFunction());
 
   ExtensionModules::iterator it = extension_modules_.begin();
   for (; it != extension_modules_.end(); ++it) {
-    if (on_demand_enabled && it->use_trampoline) {
-      if (InstallTrampoline(context, &*it))
-        continue;
-    }
-    it->module->LoadExtensionCode(context, require_native);
+    if (it->parent == entry && !it->loaded)
+      SetupExtensionModule(context, &*it);
   }
 }
 
@@ -357,22 +438,9 @@ void XWalkModuleSystem::TrampolineCallback(
   v8::Isolate* isolate = info.GetIsolate();
   v8::Handle<v8::Context> context = isolate->GetCurrentContext();
 
-  DeleteAccessorForEntryPoint(context, entry->name);
-
-  std::vector<std::string>::const_iterator it = entry->entry_points.begin();
-  for (; it != entry->entry_points.end(); ++it) {
-    DeleteAccessorForEntryPoint(context, *it);
-  }
-
+  // Loading the module removes its trampolines.
   XWalkModuleSystem* module_system = GetModuleSystemFromContext(context);
-  v8::Handle<v8::FunctionTemplate> require_native_template =
-        v8::Handle<v8::FunctionTemplate>::New(
-            isolate,
-            module_system->require_native_template_);
-
-  XWalkExtensionModule* module = entry->module;
-  module->LoadExtensionCode(module_system->GetV8Context(),
-                            require_native_template->GetFunction());
+  module_system->LoadExtensionModule(module_system->GetV8Context(), entry);
 
   v8::Handle<v8::Object> holder = info.Holder();
   info.GetReturnValue().Set(holder->Get(property));
@@ -382,7 +450,7 @@ XWalkModuleSystem::ExtensionModuleEntry::ExtensionModuleEntry(
   const std::string& name,
   XWalkExtensionModule* module,
   const std::vector<std::string>& entry_points) :
-    name(name), module(module), use_trampoline(true),
+    name(name), module(module), parent(NULL), loaded(false),
     entry_points(entry_points) {
 }
 
@@ -400,27 +468,47 @@ bool XWalkModuleSystem::ExtensionModuleEntry::IsPrefix(
       && std::mismatch(p.begin(), p.end(), s.begin()).first == p.end();
 }
 
-// Mark the extension modules that we want to setup "trampolines"
-// instead of loading the code directly. The current algorithm is very
-// simple: we only create trampolines for extensions that are leaves
-// in the namespace tree.
+// Sets the parent of each extension module to the closest extension that
+// contains it in the namespace tree. For example, if there are extensions
+// "tizen", "tizen.time" and "tizen.time.zone", the parent of "tizen.time.zone"
+// will be "tizen.time", and the parent of "tizen.time" will be "tizen".
 //
-// For example, if there are two extensions "tizen" and "tizen.time",
-// the first one won't be marked with trampoline, but the second one
-// will. So we'll only load code for "tizen" extension.
-void XWalkModuleSystem::MarkModulesWithTrampoline() {
+// The modules are kept sorted by name, so the ancestors of a module that are
+// extensions are in the |stack| when we reach it.
+void XWalkModuleSystem::SetParentsOfExtensionModules() {
   std::sort(extension_modules_.begin(), extension_modules_.end());
 
+  std::vector<ExtensionModuleEntry*> stack;
   ExtensionModules::iterator it = extension_modules_.begin();
-  while (it != extension_modules_.end()) {
-    it = std::adjacent_find(it, extension_modules_.end(),
-                            &ExtensionModuleEntry::IsPrefix);
-    if (it == extension_modules_.end())
-      break;
-    it->use_trampoline = false;
-    ++it;
+  for (; it != extension_modules_.end(); ++it) {
+    while (!stack.empty() &&
+           !ExtensionModuleEntry::IsPrefix(*stack.back(), *it))
+      stack.pop_back();
+    it->parent = stack.empty() ? NULL : stack.back();
+    stack.push_back(&*it);
   }
 }
 
+void XWalkModuleSystem::RecordLoadedExtensionModules() {
+  if (extension_modules_.empty())
+    return;
+
+  int loaded_count = 0;
+  ExtensionModules::const_iterator it = extension_modules_.begin();
+  for (; it != extension_modules_.end(); ++it) {
+    if (it->loaded)
+      loaded_count++;
+  }
+
+  const int registered_count = extension_modules_.size();
+  UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.RegisteredModules",
+                           registered_count);
+  UMA_HISTOGRAM_COUNTS_100("XWalk.Extensions.LoadedModules", loaded_count);
+  UMA_HISTOGRAM_PERCENTAGE("XWalk.Extensions.LoadedModulesPercentage",
+                           loaded_count * 100 / registered_count);
+  VLOG(1) << "Module system loaded " << loaded_count << " of "
+          << registered_count << " extension modules.";
+}
+
 }  // namespace extensions
 }  // namespace xwalk
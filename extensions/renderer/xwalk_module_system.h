@@ -64,8 +64,12 @@ class XWalkModuleSystem {
     ~ExtensionModuleEntry();
     std::string name;
     XWalkExtensionModule* module;
-    bool use_trampoline;
+    // Closest extension containing this one in the namespace tree, if any.
+    ExtensionModuleEntry* parent;
+    bool loaded;
     std::vector<std::string> entry_points;
+    // Names with a trampoline for this module installed in the context.
+    std::vector<std::string> trampolines;
     bool operator<(const ExtensionModuleEntry& other) const {
       return name < other.name;
     }
@@ -85,12 +89,32 @@ class XWalkModuleSystem {
   bool InstallTrampoline(v8::Handle<v8::Context> context,
                          ExtensionModuleEntry* entry);
 
+  // Installs the trampolines for the entry points of the nested |entry| that
+  // are outside of the namespace of its outermost ancestor, so they work
+  // before the ancestors are loaded.
+  void InstallExternalTrampolines(v8::Handle<v8::Context> context,
+                                  ExtensionModuleEntry* entry);
+
+  static void RemoveTrampolines(v8::Handle<v8::Context> context,
+                                ExtensionModuleEntry* entry);
+
+  // Installs the trampolines for |entry|, or loads it right away if loading
+  // extensions on demand is disabled.
+  void SetupExtensionModule(v8::Handle<v8::Context> context,
+                            ExtensionModuleEntry* entry);
+
+  // Loads the code of |entry|, after the one of its parent, and then sets up
+  // the modules nested in it.
+  void LoadExtensionModule(v8::Handle<v8::Context> context,
+                           ExtensionModuleEntry* entry);
+
   static void TrampolineCallback(
       v8::Local<v8::String> property,
       const v8::PropertyCallbackInfo<v8::Value>& info);
 
   bool ContainsEntryPoint(const std::string& entry_point);
-  void MarkModulesWithTrampoline();
+  void SetParentsOfExtensionModules();
+  void RecordLoadedExtensionModules();
   void DeleteExtensionModules();
 
   typedef std::vector<ExtensionModuleEntry> ExtensionModules;
@@ -0,0 +1,88 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/renderer/xwalk_script_cache.h"
+
+#include "base/hash.h"
+#include "third_party/WebKit/public/web/WebScopedMicrotaskSuppression.h"
+#include "xwalk/extensions/renderer/xwalk_v8_utils.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+// Leaky because the scripts belong to the V8 isolate, which is not destroyed
+// before the process exits.
+base::LazyInstance<XWalkScriptCache>::Leaky g_script_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+XWalkScriptCache* XWalkScriptCache::GetInstance() {
+  return g_script_cache.Pointer();
+}
+
+XWalkScriptCache::XWalkScriptCache()
+    : hits_(0),
+      misses_(0) {}
+
+XWalkScriptCache::~XWalkScriptCache() {
+  ScriptMap::iterator it = scripts_.begin();
+  for (; it != scripts_.end(); ++it) {
+    it->second->Dispose();
+    delete it->second;
+  }
+}
+
+v8::Handle<v8::Script> XWalkScriptCache::GetScript(const std::string& name,
+                                                   const std::string& source,
+                                                   std::string* error) {
+  const uint32 source_hash = base::Hash(source);
+  v8::Handle<v8::Script> script = Lookup(name, source_hash);
+  if (!script.IsEmpty())
+    return script;
+  return Compile(name, source_hash, source, error);
+}
+
+v8::Handle<v8::Script> XWalkScriptCache::Lookup(const std::string& name,
+                                                uint32 source_hash) {
+  ScriptMap::const_iterator it = scripts_.find(Key(name, source_hash));
+  if (it == scripts_.end())
+    return v8::Handle<v8::Script>();
+
+  hits_++;
+  return v8::Handle<v8::Script>::New(v8::Isolate::GetCurrent(), *it->second);
+}
+
+v8::Handle<v8::Script> XWalkScriptCache::Compile(const std::string& name,
+                                                 uint32 source_hash,
+                                                 const std::string& source,
+                                                 std::string* error) {
+  misses_++;
+  v8::Handle<v8::String> v8_code(v8::String::New(source.c_str(),
+                                                 source.size()));
+
+  WebKit::WebScopedMicrotaskSuppression suppression;
+  v8::TryCatch try_catch;
+  try_catch.SetVerbose(true);
+
+  v8::Handle<v8::Script> script(v8::Script::New(v8_code, v8::String::Empty()));
+  if (try_catch.HasCaught()) {
+    *error = ExceptionToString(try_catch);
+    return v8::Handle<v8::Script>();
+  }
+
+  v8::Persistent<v8::Script>*& cached = scripts_[Key(name, source_hash)];
+  if (cached) {
+    cached->Dispose();
+    delete cached;
+  }
+  cached = new v8::Persistent<v8::Script>(v8::Isolate::GetCurrent(), script);
+  return script;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
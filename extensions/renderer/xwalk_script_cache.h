@@ -0,0 +1,66 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_RENDERER_XWALK_SCRIPT_CACHE_H_
+#define XWALK_EXTENSIONS_RENDERER_XWALK_SCRIPT_CACHE_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include "base/basictypes.h"
+#include "base/lazy_instance.h"
+#include "v8/include/v8.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps the compiled JavaScript code of extensions, so each API is parsed and
+// compiled only once per render process, instead of once per script context.
+// Scripts are compiled with v8::Script::New(), so they are not bound to any
+// context: running one binds it to the current context.
+//
+// Should only be used in the render thread.
+class XWalkScriptCache {
+ public:
+  static XWalkScriptCache* GetInstance();
+
+  // Returns the script compiled from |source|, compiling it only the first
+  // time. The |name| is part of the key, so different extensions never share
+  // an entry. In case of a compilation error, returns an empty handle and
+  // sets |error|. Must be called inside a HandleScope.
+  v8::Handle<v8::Script> GetScript(const std::string& name,
+                                   const std::string& source,
+                                   std::string* error);
+
+  // Same as above, split in two steps for callers that know the hash of the
+  // source in advance, so the source is only needed if it wasn't compiled
+  // yet. Lookup() returns an empty handle if there's no such script.
+  v8::Handle<v8::Script> Lookup(const std::string& name, uint32 source_hash);
+  v8::Handle<v8::Script> Compile(const std::string& name, uint32 source_hash,
+                                 const std::string& source,
+                                 std::string* error);
+
+  size_t hits() const { return hits_; }
+  size_t misses() const { return misses_; }
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<XWalkScriptCache>;
+
+  XWalkScriptCache();
+  ~XWalkScriptCache();
+
+  typedef std::pair<std::string, uint32> Key;
+  typedef std::map<Key, v8::Persistent<v8::Script>*> ScriptMap;
+  ScriptMap scripts_;
+
+  size_t hits_;
+  size_t misses_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkScriptCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_RENDERER_XWALK_SCRIPT_CACHE_H_
@@ -9,12 +9,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_BinaryMessaging.h"
+#include "xwalk/extensions/public/XW_Extension_RequestMessaging.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 XW_Extension g_extension = 0;
 const XW_CoreInterface* g_core = NULL;
 const XW_MessagingInterface* g_messaging = NULL;
 const XW_Internal_SyncMessagingInterface* g_sync_messaging = NULL;
+const XW_BinaryMessagingInterface* g_binary_messaging = NULL;
+const XW_RequestMessagingInterface* g_request_messaging = NULL;
 
 void instance_created(XW_Instance instance) {
   printf("Instance %d created!\n", instance);
@@ -32,6 +36,16 @@ void handle_sync_message(XW_Instance instance, const char* message) {
   g_sync_messaging->SetSyncReply(instance, message);
 }
 
+void handle_binary_message(XW_Instance instance, const char* data,
+                           size_t size) {
+  g_binary_messaging->PostBinaryMessage(instance, data, size);
+}
+
+void handle_request(XW_Instance instance, int32_t request_id,
+                    const char* message) {
+  g_request_messaging->SendReply(instance, request_id, message);
+}
+
 void shutdown(XW_Extension extension) {
   printf("Shutdown\n");
 }
@@ -50,6 +64,13 @@ int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
       "};"
       "exports.syncEcho = function(msg) {"
       "  return extension.internal.sendSyncMessage(msg);"
+      "};"
+      "exports.binaryEcho = function(buffer, callback) {"
+      "  echoListener = callback;"
+      "  extension.postBinaryMessage(buffer);"
+      "};"
+      "exports.requestEcho = function(msg, callback) {"
+      "  return extension.sendRequest(msg, callback);"
       "};";
 
   g_extension = extension;
@@ -66,5 +87,11 @@ int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
   g_sync_messaging = get_interface(XW_INTERNAL_SYNC_MESSAGING_INTERFACE);
   g_sync_messaging->Register(extension, handle_sync_message);
 
+  g_binary_messaging = get_interface(XW_BINARY_MESSAGING_INTERFACE);
+  g_binary_messaging->Register(extension, handle_binary_message);
+
+  g_request_messaging = get_interface(XW_REQUEST_MESSAGING_INTERFACE);
+  g_request_messaging->Register(extension, handle_request);
+
   return XW_OK;
 }
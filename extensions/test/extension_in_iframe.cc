@@ -4,8 +4,10 @@
 
 #include "xwalk/extensions/test/xwalk_extensions_test_base.h"
 
+#include "base/strings/stringprintf.h"
 #include "base/synchronization/lock.h"
 #include "base/synchronization/spin_wait.h"
+#include "base/time/time.h"
 #include "content/public/browser/web_contents.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
@@ -53,6 +55,33 @@ class CounterExtension : public XWalkExtension {
   }
 };
 
+// Same as CounterExtension, but with a big JavaScript API, so the time spent
+// compiling it is noticeable.
+class BigCounterExtension : public XWalkExtension {
+ public:
+  BigCounterExtension()
+      : XWalkExtension() {
+    set_name("counter");
+
+    std::string api =
+        "exports.count = function() {"
+        "  extension.postMessage('PING');"
+        "};";
+    for (int i = 0; i < 5000; i++) {
+      api += base::StringPrintf(
+          "exports.unused%d = function(a, b) {"
+          "  var result = { index: %d, values: [a, b] };"
+          "  return JSON.stringify(result);"
+          "};\n", i, i);
+    }
+    set_javascript_api(api);
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() {
+    return new CounterExtensionContext();
+  }
+};
+
 class XWalkExtensionsIFrameTest : public XWalkExtensionsTestBase {
  public:
   void RegisterExtensions(XWalkExtensionServer* server) OVERRIDE {
@@ -60,6 +89,13 @@ class XWalkExtensionsIFrameTest : public XWalkExtensionsTestBase {
   }
 };
 
+class XWalkExtensionsManyIFramesTest : public XWalkExtensionsTestBase {
+ public:
+  void RegisterExtensions(XWalkExtensionServer* server) OVERRIDE {
+    ASSERT_TRUE(RegisterExtensionForTest(server, new BigCounterExtension));
+  }
+};
+
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsIFrameTest,
                        ContextsAreCreatedForIFrames) {
   content::RunAllPendingInMessageLoop();
@@ -109,3 +145,29 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsIFrameTest,
   }
 }
 
+
+// Measures the creation of many script contexts using the same extension.
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsManyIFramesTest,
+                       ContextCreationWithManyIFrames) {
+  const int kIFrameCount = 50;
+  {
+    base::AutoLock lock(g_count_lock);
+    g_count = 0;
+  }
+
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("counter_with_many_iframes.html"));
+
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  const base::TimeTicks start_time = base::TimeTicks::Now();
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  const base::TimeDelta elapsed = base::TimeTicks::Now() - start_time;
+
+  LOG(INFO) << "Loading a page with " << kIFrameCount << " iframes using a "
+            << "big extension API took " << elapsed.InMilliseconds() << "ms.";
+
+  SPIN_FOR_1_SECOND_OR_UNTIL_TRUE(g_count == kIFrameCount + 1);
+  ASSERT_EQ(g_count, kIFrameCount + 1);
+}
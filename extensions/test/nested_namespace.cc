@@ -20,6 +20,7 @@ namespace {
 bool g_outer_extension_loaded = false;
 bool g_inner_extension_loaded = false;
 bool g_another_extension_loaded = false;
+bool g_nested_extension_loaded = false;
 
 }
 
@@ -89,6 +90,30 @@ class AnotherExtension : public XWalkExtension {
   }
 };
 
+class NestedInstance : public XWalkExtensionInstance {
+ public:
+  NestedInstance() {
+    g_nested_extension_loaded = true;
+  }
+  virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE {}
+};
+
+class NestedExtension : public XWalkExtension {
+ public:
+  NestedExtension() : XWalkExtension() {
+    set_name("outer.nested");
+    // The entry point is outside of the 'outer' namespace, so it should be
+    // available before 'outer' is loaded.
+    set_entry_points(std::vector<std::string>(1, "nestedEntryPoint"));
+    set_javascript_api("window.nestedEntryPoint = true;"
+                       "exports.value = true;");
+  }
+
+  virtual XWalkExtensionInstance* CreateInstance() OVERRIDE {
+    return new NestedInstance;
+  }
+};
+
 class XWalkExtensionsNestedNamespaceTest : public XWalkExtensionsTestBase {
  public:
   void RegisterExtensions(XWalkExtensionServer* server) OVERRIDE {
@@ -106,6 +131,14 @@ class XWalkExtensionsTrampolinesForNested : public XWalkExtensionsTestBase {
   }
 };
 
+class XWalkExtensionsNestedEntryPoint : public XWalkExtensionsTestBase {
+ public:
+  void RegisterExtensions(XWalkExtensionServer* server) OVERRIDE {
+    ASSERT_TRUE(RegisterExtensionForTest(server, new OuterExtension));
+    ASSERT_TRUE(RegisterExtensionForTest(server, new NestedExtension));
+  }
+};
+
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedNamespaceTest,
                        InstanceCreatedForInnerExtension) {
   content::RunAllPendingInMessageLoop();
@@ -121,9 +154,8 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedNamespaceTest,
   EXPECT_TRUE(g_inner_extension_loaded);
 }
 
-// TODO(cmarcelo): This will be enabled when we fully land load on demand.
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedNamespaceTest,
-                       DISABLED_InstanceNotCreatedForUnusedInnerExtension) {
+                       InstanceNotCreatedForUnusedInnerExtension) {
   content::RunAllPendingInMessageLoop();
   GURL url = GetExtensionsTestURL(base::FilePath(),
       base::FilePath().AppendASCII("outer.html"));
@@ -137,6 +169,22 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedNamespaceTest,
   EXPECT_FALSE(g_inner_extension_loaded);
 }
 
+// Extensions that contain others in their namespace are loaded on demand too.
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedNamespaceTest,
+                       InstanceNotCreatedForUnusedOuterExtension) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("no_outer.html"));
+
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+  EXPECT_FALSE(g_outer_extension_loaded);
+  EXPECT_FALSE(g_inner_extension_loaded);
+}
+
 IN_PROC_BROWSER_TEST_F(XWalkExtensionsTrampolinesForNested,
                        InstanceCreatedForExtensionUsedByAnother) {
   content::RunAllPendingInMessageLoop();
@@ -152,3 +200,18 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsTrampolinesForNested,
   EXPECT_TRUE(g_inner_extension_loaded);
   EXPECT_TRUE(g_outer_extension_loaded);
 }
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsNestedEntryPoint,
+                       EntryPointOutsideOfNamespaceLoadsParentFirst) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+      base::FilePath().AppendASCII("nested_entry_point.html"));
+
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+
+  EXPECT_TRUE(g_outer_extension_loaded);
+  EXPECT_TRUE(g_nested_extension_loaded);
+}
@@ -11,6 +11,7 @@
 #include "xwalk/test/base/xwalk_test_utils.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
+#include <algorithm>
 #include "base/task_runner.h"
 #include "base/time/time.h"
 
@@ -33,6 +34,13 @@ const char* kEchoAPI =
     "};"
     "exports.syncEcho = function(msg) {"
     "  return extension.internal.sendSyncMessage(msg);"
+    "};"
+    "exports.binaryEcho = function(buffer, callback) {"
+    "  echoListener = callback;"
+    "  extension.postBinaryMessage(buffer);"
+    "};"
+    "exports.requestEcho = function(msg, callback) {"
+    "  return extension.sendRequest(msg, callback);"
     "};";
 
 class EchoContext : public XWalkExtensionInstance {
@@ -45,6 +53,13 @@ class EchoContext : public XWalkExtensionInstance {
   virtual void HandleSyncMessage(scoped_ptr<base::Value> msg) OVERRIDE {
     SendSyncReplyToJS(msg.Pass());
   }
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE {
+    PostBinaryMessageToJS(data, size);
+  }
+  virtual void HandleRequest(int request_id,
+                             scoped_ptr<base::Value> msg) OVERRIDE {
+    SendReplyToJS(request_id, msg.Pass());
+  }
 };
 
 class DelayedEchoContext : public XWalkExtensionInstance {
@@ -60,10 +75,24 @@ class DelayedEchoContext : public XWalkExtensionInstance {
                               base::Unretained(this), base::Passed(&msg)),
         base::TimeDelta::FromSeconds(1));
   }
+  virtual void HandleRequest(int request_id,
+                             scoped_ptr<base::Value> msg) OVERRIDE {
+    // Later requests are answered first, to check the replies are matched
+    // by their request id and not by their order.
+    base::MessageLoop::current()->PostDelayedTask(
+        FROM_HERE, base::Bind(&DelayedEchoContext::DelayedRequestReply,
+                              base::Unretained(this), request_id,
+                              base::Passed(&msg)),
+        base::TimeDelta::FromMilliseconds(std::max(0, 500 - 100 * request_id)));
+  }
 
   void DelayedReply(scoped_ptr<base::Value> reply) {
     SendSyncReplyToJS(reply.Pass());
   }
+
+  void DelayedRequestReply(int request_id, scoped_ptr<base::Value> reply) {
+    SendReplyToJS(request_id, reply.Pass());
+  }
 };
 
 class EchoExtension : public XWalkExtension {
@@ -148,3 +177,36 @@ IN_PROC_BROWSER_TEST_F(XWalkExtensionsDelayedTest, EchoExtensionSync) {
   xwalk_test_utils::NavigateToURL(runtime(), url);
   EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
 }
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, EchoExtensionBinary) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "binary_echo.html"));
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsTest, EchoExtensionRequest) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "request_echo.html"));
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
+
+IN_PROC_BROWSER_TEST_F(XWalkExtensionsDelayedTest, EchoExtensionRequest) {
+  content::RunAllPendingInMessageLoop();
+  GURL url = GetExtensionsTestURL(base::FilePath(),
+                                  base::FilePath().AppendASCII(
+                                      "request_echo.html"));
+  content::TitleWatcher title_watcher(runtime()->web_contents(), kPassString);
+  title_watcher.AlsoWaitForTitle(kFailString);
+  xwalk_test_utils::NavigateToURL(runtime(), url);
+  EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+}
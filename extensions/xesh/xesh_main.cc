@@ -214,11 +214,11 @@ class ExtensionManager {
         extensions.begin();
     for (; it != extensions.end(); ++it) {
       XWalkExtensionClient::ExtensionCodePoints* codepoint = it->second;
-      if (codepoint->api.empty())
+      if (!codepoint->api_size)
         continue;
       scoped_ptr<XWalkExtensionModule> module(
           new XWalkExtensionModule(&client_, module_system, it->first,
-                                   codepoint->api));
+                                   codepoint->api_hash));
       module_system->RegisterExtensionModule(module.Pass(),
                                              codepoint->entry_points);
     }
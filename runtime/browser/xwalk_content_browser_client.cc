@@ -106,10 +106,11 @@ XWalkContentBrowserClient::CreateRequestContextForStoragePartition(
 void XWalkContentBrowserClient::AppendExtraCommandLineSwitches(
     CommandLine* command_line, int child_process_id) {
   CommandLine* browser_process_cmd_line = CommandLine::ForCurrentProcess();
-  const int extra_switches_count = 2;
+  const int extra_switches_count = 3;
   const char* extra_switches[extra_switches_count] = {
     switches::kXWalkDisableLoadingExtensionsOnDemand,
-    switches::kXWalkDisableExtensionProcess
+    switches::kXWalkDisableExtensionProcess,
+    switches::kXWalkDumpExtensionMessageStats
   };
 
   for (int i = 0; i < extra_switches_count; i++) {
@@ -22,6 +22,10 @@ const char kListApplications[] = "list-apps";
 // Specifies install an application.
 const char kInstall[] = "install";
 
+// Keeps the package of the application being installed as it is, instead
+// of extracting it. The files are read from the package when used.
+const char kInstallWithoutExtracting[] = "install-without-extracting";
+
 // Spedifies uninstall an application from runtime.
 const char kUninstall[] = "uninstall";
 
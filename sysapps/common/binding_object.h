@@ -29,6 +29,11 @@ class BindingObject {
     return handler_.HandleFunction(info.Pass());
   }
 
+  // Invoked with the payload of the binary messages sent by the JavaScript
+  // counterpart using _postBinaryMessage(). The |data| is only valid during
+  // the call.
+  virtual void HandleBinaryMessage(const char* data, size_t size) {}
+
  protected:
   XWalkExtensionFunctionHandler handler_;
 };
@@ -38,6 +38,24 @@ bool BindingObjectStore::HasObjectForTesting(const std::string& id) const {
   return ContainsKey(objects_, id);
 }
 
+bool BindingObjectStore::HandleBinaryMessage(const char* data, size_t size) {
+  std::string object_id;
+  const char* payload;
+  size_t payload_size;
+  if (!XWalkExtensionFunctionHandler::ParseBinaryMessage(
+          data, size, &object_id, &payload, &payload_size)) {
+    LOG(WARNING) << "Malformed binary message.";
+    return false;
+  }
+
+  BindingObjectMap::iterator it = objects_.find(object_id);
+  if (it == objects_.end())
+    return false;
+
+  it->second->HandleBinaryMessage(payload, payload_size);
+  return true;
+}
+
 void BindingObjectStore::OnJSObjectCollected(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   scoped_ptr<DestroyObject::Params>
@@ -86,7 +104,8 @@ void BindingObjectStore::OnPostMessageToObject(
       new XWalkExtensionFunctionInfo(
           params->name,
           new_args.Pass(),
-          info->post_result_cb()));
+          info->post_result_cb(),
+          info->post_binary_result_cb()));
 
   if (!it->second->HandleFunction(new_info.Pass())) {
     LOG(WARNING) << "The object with the ID " << params->object_id << " has no "
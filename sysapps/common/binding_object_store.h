@@ -32,6 +32,11 @@ class BindingObjectStore {
   void AddBindingObject(const std::string& id, scoped_ptr<BindingObject> obj);
   bool HasObjectForTesting(const std::string& id) const;
 
+  // Delivers a binary message sent from JavaScript by _postBinaryMessage()
+  // to the object it is addressed to. Returns false if there's no such
+  // object.
+  bool HandleBinaryMessage(const char* data, size_t size);
+
  private:
   // This method is invoked every time a JavaScript Binding object is collected
   // by the garbage collector, so we can also destroy the native counterpart.
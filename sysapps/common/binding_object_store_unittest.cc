@@ -35,7 +35,9 @@ class BindingObjectTest : public BindingObject {
     return make_scoped_ptr(new BindingObjectTest()).PassAs<BindingObject>();
   }
 
-  BindingObjectTest() : call_count_(0) {
+  BindingObjectTest()
+      : call_count_(0),
+        binary_call_count_(0) {
     instance_count_++;
 
     handler_.Register("test",
@@ -54,6 +56,15 @@ class BindingObjectTest : public BindingObject {
     return call_count_;
   }
 
+  int binary_call_count() const {
+    return binary_call_count_;
+  }
+
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE {
+    EXPECT_EQ(std::string(kTestString), std::string(data, size));
+    binary_call_count_++;
+  }
+
  private:
   void OnTest(scoped_ptr<XWalkExtensionFunctionInfo> info) {
     EXPECT_EQ(info->name(), "test");
@@ -66,6 +77,7 @@ class BindingObjectTest : public BindingObject {
   }
 
   int call_count_;
+  int binary_call_count_;
   static int instance_count_;
 };
 
@@ -182,3 +194,37 @@ TEST(XWalkSysAppsBindingObjectStoreTest, OnPostMessageToObject) {
   store.reset();
   EXPECT_EQ(BindingObjectTest::instance_count(), 0);
 }
+
+TEST(XWalkSysAppsBindingObjectStoreTest, HandleBinaryMessage) {
+  XWalkExtensionFunctionHandler handler(NULL);
+  scoped_ptr<BindingObjectStore> store(new BindingObjectStore(&handler));
+
+  BindingObjectTest* binding_object1(new BindingObjectTest());
+  BindingObjectTest* binding_object2(new BindingObjectTest());
+  store->AddBindingObject("foobar1",
+                          scoped_ptr<BindingObject>(binding_object1));
+  store->AddBindingObject("foobar2",
+                          scoped_ptr<BindingObject>(binding_object2));
+
+  // The object ID, prefixed by its length, followed by the payload.
+  const std::string message =
+      std::string("\x07" "foobar1") + std::string(kTestString);
+
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(store->HandleBinaryMessage(message.data(), message.size()));
+    EXPECT_EQ(binding_object1->binary_call_count(), i + 1);
+  }
+
+  EXPECT_EQ(binding_object2->binary_call_count(), 0);
+  EXPECT_EQ(binding_object1->call_count(), 0);
+
+  // Unknown object and malformed messages.
+  const std::string unknown =
+      std::string("\x07" "foobar3") + std::string(kTestString);
+  EXPECT_FALSE(store->HandleBinaryMessage(unknown.data(), unknown.size()));
+  EXPECT_FALSE(store->HandleBinaryMessage(message.data(), 3));
+  EXPECT_FALSE(store->HandleBinaryMessage(message.data(), 0));
+
+  store.reset();
+  EXPECT_EQ(BindingObjectTest::instance_count(), 0);
+}
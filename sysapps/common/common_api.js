@@ -33,6 +33,11 @@ function getUniqueId() {
 //     |postMessage| but wraps the unique identifier as the first argument
 //     automatically.
 //
+// _postBinaryMessage(data):
+//     Sends the bytes of |data|, an ArrayBuffer or an ArrayBufferView, to
+//     the native counterpart of this object, which gets them at
+//     BindingObject::HandleBinaryMessage() without any conversion.
+//
 // _addMethod(name, has_callback):
 //     Convenience function for adding methods to an object that have a
 //     correspondent on the native side. Methods names that start with "_" are
@@ -45,6 +50,10 @@ var BindingObjectPrototype = function() {
         [this._id, name, args], callback);
   };
 
+  function postBinaryMessage(data) {
+    return internal.postBinaryMessage(this._id, data);
+  };
+
   function addMethod(name, has_callback) {
     var enumerable = name.indexOf("_") != 0;
 
@@ -77,6 +86,9 @@ var BindingObjectPrototype = function() {
     "_postMessage" : {
       value: postMessage,
     },
+    "_postBinaryMessage" : {
+      value: postBinaryMessage,
+    },
     "_addMethod" : {
       value: addMethod,
     },
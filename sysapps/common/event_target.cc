@@ -33,6 +33,15 @@ void EventTarget::DispatchEvent(const std::string& type,
   it->second.Run(data.Pass());
 }
 
+void EventTarget::DispatchBinaryEvent(const std::string& type,
+                                      const char* data, size_t size) {
+  BinaryEventMap::iterator it = binary_events_.find(type);
+  if (it == binary_events_.end() || it->second.is_null())
+    return;
+
+  it->second.Run(data, size);
+}
+
 void EventTarget::OnAddEventListener(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   scoped_ptr<AddEventListener::Params>
@@ -51,6 +60,7 @@ void EventTarget::OnAddEventListener(
   }
 
   events_[params->type] = info->post_result_cb();
+  binary_events_[params->type] = info->post_binary_result_cb();
   StartEvent(params->type);
 }
 
@@ -72,6 +82,7 @@ void EventTarget::OnRemoveEventListener(
   }
 
   events_.erase(it);
+  binary_events_.erase(params->type);
   StopEvent(params->type);
 }
 
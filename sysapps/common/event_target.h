@@ -37,14 +37,23 @@ class EventTarget : public BindingObject {
   void DispatchEvent(const std::string& type);
   void DispatchEvent(const std::string& type, scoped_ptr<base::ListValue> data);
 
+  // Same as above, but the event data is received by the JavaScript
+  // counterpart as an ArrayBuffer, without an intermediate base::Value.
+  // The |data| is copied, so the caller keeps its ownership.
+  void DispatchBinaryEvent(const std::string& type,
+                           const char* data, size_t size);
+
  private:
   void OnAddEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnRemoveEventListener(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   typedef std::map<std::string,
       XWalkExtensionFunctionInfo::PostResultCallback> EventMap;
+  typedef std::map<std::string,
+      XWalkExtensionFunctionInfo::PostBinaryResultCallback> BinaryEventMap;
 
   EventMap events_;
+  BinaryEventMap binary_events_;
 };
 
 }  // namespace sysapps
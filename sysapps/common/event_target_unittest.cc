@@ -36,6 +36,12 @@ void DispatchResult(int* message_count, scoped_ptr<base::ListValue> result) {
   (*message_count)++;
 }
 
+void DispatchBinaryResult(int* message_count, const char* data, size_t size) {
+  EXPECT_EQ(std::string(kTestString), std::string(data, size));
+
+  (*message_count)++;
+}
+
 class EventTargetTest : public EventTarget {
  public:
   EventTargetTest()
@@ -49,6 +55,10 @@ class EventTargetTest : public EventTarget {
     DispatchEvent(type, data.Pass());
   }
 
+  void InjectBinaryEvent(const std::string& type) {
+    DispatchBinaryEvent(type, kTestString, sizeof(kTestString) - 1);
+  }
+
   bool is_event1_active() const {
     return event1_count_ == 1;
   }
@@ -162,3 +172,35 @@ TEST(XWalkSysAppsEventTargetTest, DispatchEvent) {
     EXPECT_EQ(message_count, i + 1);
   }
 }
+
+TEST(XWalkSysAppsEventTargetTest, DispatchBinaryEvent) {
+  scoped_ptr<EventTargetTest> target(new EventTargetTest());
+
+  target->InjectBinaryEvent("event1");
+
+  int message_count = 0;
+  int binary_message_count = 0;
+
+  scoped_ptr<base::ListValue> argumentsList(new base::ListValue);
+  argumentsList->AppendString("event1");
+
+  scoped_ptr<XWalkExtensionFunctionInfo> eventInfo(
+      new XWalkExtensionFunctionInfo(
+          "addEventListener",
+          argumentsList.Pass(),
+          base::Bind(&DispatchResult, &message_count),
+          base::Bind(&DispatchBinaryResult, &binary_message_count)));
+
+  EXPECT_TRUE(target->HandleFunction(eventInfo.Pass()));
+
+  for (int i = 0; i < 1000; ++i) {
+    target->InjectBinaryEvent("event1");
+    EXPECT_EQ(binary_message_count, i + 1);
+  }
+  EXPECT_EQ(message_count, 0);
+
+  EXPECT_TRUE(target->HandleFunction(
+          CreateFunctionInfo("removeEventListener", "event1")));
+  target->InjectBinaryEvent("event1");
+  EXPECT_EQ(binary_message_count, 1000);
+}
@@ -37,6 +37,52 @@ var ReadyStateObserver = function(object_id, initial_state) {
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+// Like the ReadyStateObserver, keeps track of how many bytes the native side
+// has written to the socket, so the socket can compute its bufferedAmount.
+//
+var BufferedAmountObserver = function(object_id) {
+  common.BindingObject.call(this, object_id);
+  common.EventTarget.call(this);
+
+  this._addEvent("bufferedamount");
+  this.bytesWritten = 0;
+
+  var that = this;
+  this.onbufferedamount = function(event) {
+    that.bytesWritten = event.data[0];
+  };
+
+  this.destructor = function() {
+    this.onbufferedamount = null;
+  };
+};
+
+BufferedAmountObserver.prototype = new common.EventTargetPrototype();
+
+// send() returns false when at least this amount of bytes is waiting to be
+// written, and a "drain" event is fired once the buffered data is written.
+var kHighWaterMark = 64 * 1024;
+
+// Number of bytes of |data| once encoded as UTF-8, the way it's sent.
+function utf8Length(data) {
+  var length = 0;
+  for (var i = 0; i < data.length; ++i) {
+    var code = data.charCodeAt(i);
+    if (code < 0x80) {
+      length += 1;
+    } else if (code < 0x800) {
+      length += 2;
+    } else if (code >= 0xd800 && code < 0xdc00 && i + 1 < data.length) {
+      // Surrogate pair.
+      length += 4;
+      ++i;
+    } else {
+      length += 3;
+    }
+  }
+  return length;
+};
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
@@ -69,6 +115,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addMethod("suspend");
   this._addMethod("resume");
   this._addMethod("_sendString");
+  this._addMethod("_requestDrain");
 
   this._addEvent("drain");
   this._addEvent("open");
@@ -78,14 +125,28 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addEvent("data");
 
   function sendWrapper(data) {
-    this._sendString(data);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    if (this.readyState != "open")
+      return false;
+
+    if (data instanceof ArrayBuffer ||
+        (data && data.buffer instanceof ArrayBuffer)) {
+      // ArrayBuffers and their views are sent as they are, without being
+      // converted to a string.
+      this._postBinaryMessage(data);
+      this._bytesSent += data.byteLength;
+    } else {
+      data = String(data);
+      this._sendString(data);
+      this._bytesSent += utf8Length(data);
+    }
+
+    // The bytes written are only updated asynchronously, so this can return
+    // false for data that was already written, but never the opposite.
+    if (this.bufferedAmount < kHighWaterMark)
+      return true;
+
+    this._requestDrain();
+    return false;
   };
 
   function closeWrapper(data) {
@@ -104,6 +165,13 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
+    "_bufferedAmountObserver": {
+      value: new BufferedAmountObserver(this._id),
+    },
+    "_bytesSent": {
+      value: 0,
+      writable: true,
+    },
     "send": {
       value: sendWrapper,
       enumerable: true,
@@ -128,8 +196,10 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       value: 0,
       enumerable: true,
     },
-    "bufferAmount": {
-      value: 0,
+    "bufferedAmount": {
+      get: function() {
+        return this._bytesSent - this._bufferedAmountObserver.bytesWritten;
+      },
       enumerable: true,
     },
     "readyState": {
@@ -139,8 +209,10 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   });
 
   var watcher = this._readyStateObserver;
+  var bufferedAmountWatcher = this._bufferedAmountObserver;
   this._readyStateObserverDeleter.destructor = function() {
     watcher.destructor();
+    bufferedAmountWatcher.destructor();
   };
 
   // This is needed, otherwise events like "error" can get fired before
@@ -177,6 +249,8 @@ var TCPServerSocket = function(options) {
     options.addressReuse = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.backlog)
+    options.backlog = 128;
 
   this._addMethod("_close");
   this._addMethod("suspend");
@@ -198,8 +272,21 @@ var TCPServerSocket = function(options) {
   this._addEvent("error");
   this._addEvent("connecterror");
 
+  // The connections accepted together come in a single message, which is
+  // split in one event per connection.
+  var dispatchEventFromExtension = this._dispatchEventFromExtension;
+  function dispatchConnections(type, data) {
+    if (type != "connect") {
+      dispatchEventFromExtension.call(this, type, data);
+      return;
+    }
+
+    for (var i = 0; i < data.length; ++i)
+      dispatchEventFromExtension.call(this, type, data[i]);
+  };
+
   function closeWrapper(data) {
-    if (this._readyStateObserver.readyState = "closed")
+    if (this._readyStateObserver.readyState == "closed")
       return;
 
     this._readyStateObserver.readyState = "closing";
@@ -210,6 +297,9 @@ var TCPServerSocket = function(options) {
     "_readyStateObserver": {
       value: new ReadyStateObserver(this._id, "opening"),
     },
+    "_dispatchEventFromExtension": {
+      value: dispatchConnections,
+    },
     "_readyStateObserverDeleter": {
       value: v8tools.lifecycleTracker(),
     },
@@ -229,6 +319,10 @@ var TCPServerSocket = function(options) {
       value: options.addressReuse,
       enumerable: true,
     },
+    "backlog": {
+      value: options.backlog,
+      enumerable: true,
+    },
     "readyState": {
       get: function() { return this._readyStateObserver.readyState; },
       enumerable: true,
@@ -251,6 +345,303 @@ var TCPServerSocket = function(options) {
 TCPServerSocket.prototype = new common.EventTargetPrototype();
 TCPServerSocket.prototype.constructor = TCPServerSocket;
 
+// Datagrams waiting to be sent are posted together once this amount of
+// bytes is queued, or at the end of the current task.
+var kMaxDatagramBatchSize = 64 * 1024;
+
+// Returns the UTF-8 encoding of |data| as an Uint8Array.
+function utf8Encode(data) {
+  var encoded = unescape(encodeURIComponent(data));
+  var bytes = new Uint8Array(encoded.length);
+  for (var i = 0; i < encoded.length; ++i)
+    bytes[i] = encoded.charCodeAt(i);
+  return bytes;
+};
+
+function toUint8Array(data) {
+  if (data instanceof ArrayBuffer)
+    return new Uint8Array(data);
+  if (data && data.buffer instanceof ArrayBuffer)
+    return new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+  return utf8Encode(String(data));
+};
+
+// Addresses are encoded with one byte per character and their length in a
+// single byte, which is enough for any IPv4 or IPv6 literal.
+var kMaxAddressLength = 255;
+var kIPLiteralPattern = /^[0-9A-Fa-f.:]*$/;
+
+function isValidRemoteAddress(address) {
+  return address.length <= kMaxAddressLength &&
+      kIPLiteralPattern.test(address);
+};
+
+function isValidPort(port) {
+  return port % 1 == 0 && port >= 0 && port <= 65535;
+};
+
+// Datagrams are exchanged with the native side in batches, each datagram
+// encoded as described at udp_socket_object.h.
+function encodeDatagrams(datagrams, size) {
+  var bytes = new Uint8Array(size);
+  var view = new DataView(bytes.buffer);
+  var offset = 0;
+
+  for (var i = 0; i < datagrams.length; ++i) {
+    var datagram = datagrams[i];
+    var address = datagram.address;
+
+    bytes[offset++] = address.length;
+    for (var j = 0; j < address.length; ++j)
+      bytes[offset++] = address.charCodeAt(j);
+    view.setUint16(offset, datagram.port);
+    offset += 2;
+    view.setUint32(offset, datagram.data.length);
+    offset += 4;
+    bytes.set(datagram.data, offset);
+    offset += datagram.data.length;
+  }
+
+  return bytes;
+};
+
+function decodeDatagrams(buffer, callback) {
+  var bytes = new Uint8Array(buffer);
+  var view = new DataView(buffer);
+  var offset = 0;
+
+  while (offset < bytes.length) {
+    var addressLength = bytes[offset++];
+    var address = String.fromCharCode.apply(
+        null, bytes.subarray(offset, offset + addressLength));
+    offset += addressLength;
+    var port = view.getUint16(offset);
+    offset += 2;
+    var size = view.getUint32(offset);
+    offset += 4;
+
+    callback(buffer.slice(offset, offset + size), address, port);
+    offset += size;
+  }
+};
+
+// UDPSocket interface.
+//
+// The datagrams received by the native side are delivered in batches, which
+// are split here in one "message" event per datagram. The datagrams sent are
+// also batched, see kMaxDatagramBatchSize.
+//
+// The loopback option is not supported yet.
+//
+var UDPSocket = function(options) {
+  common.BindingObject.call(this, common.getUniqueId());
+  common.EventTarget.call(this);
+
+  internal.postMessage("UDPSocketConstructor", [this._id]);
+
+  options = options || {};
+
+  if (!options.localAddress)
+    options.localAddress = "0.0.0.0";
+  if (!options.localPort)
+    options.localPort = 0;
+  if (!options.remoteAddress)
+    options.remoteAddress = "";
+  if (!options.remotePort)
+    options.remotePort = 0;
+  if (options.addressReuse === undefined)
+    options.addressReuse = true;
+  if (options.loopback === undefined)
+    options.loopback = false;
+
+  this._addMethod("_close");
+  this._addMethod("suspend");
+  this._addMethod("resume");
+  this._addMethod("_requestDrain");
+
+  function MessageEvent(type, data) {
+    this.type = type;
+    this.data = data.data;
+    this.remoteAddress = data.remoteAddress;
+    this.remotePort = data.remotePort;
+  }
+
+  this._addEvent("open");
+  this._addEvent("drain");
+  this._addEvent("error");
+  this._addEvent("message", MessageEvent);
+
+  var dispatchEventFromExtension = this._dispatchEventFromExtension;
+  function dispatchDatagrams(type, data) {
+    if (type != "message") {
+      dispatchEventFromExtension.call(this, type, data);
+      return;
+    }
+
+    var that = this;
+    decodeDatagrams(data, function(buffer, address, port) {
+      dispatchEventFromExtension.call(that, type, {
+        data: buffer,
+        remoteAddress: address,
+        remotePort: port,
+      });
+    });
+  };
+
+  function flushWrapper() {
+    this._flushScheduled = false;
+    if (!this._datagrams.length)
+      return;
+
+    this._postBinaryMessage(
+        encodeDatagrams(this._datagrams, this._datagramsSize));
+    this._datagrams = [];
+    this._datagramsSize = 0;
+  };
+
+  function sendWrapper(data, remoteAddress, remotePort) {
+    if (this.readyState != "open")
+      return false;
+
+    // An empty address means the default remote address.
+    var address = remoteAddress ? String(remoteAddress) : "";
+    var port = remotePort == null ? 0 : Number(remotePort);
+    if (!isValidRemoteAddress(address) || !isValidPort(port))
+      return false;
+
+    var bytes = toUint8Array(data);
+    this._datagrams.push({
+      address: address,
+      port: port,
+      data: bytes,
+    });
+    this._datagramsSize += 1 + address.length + 2 + 4 + bytes.length;
+    this._bytesSent += bytes.length;
+
+    if (this._datagramsSize >= kMaxDatagramBatchSize) {
+      this._flush();
+    } else if (!this._flushScheduled) {
+      this._flushScheduled = true;
+      setTimeout(function(obj) { obj._flush(); }, 0, this);
+    }
+
+    if (this.bufferedAmount < kHighWaterMark)
+      return true;
+
+    // The native side must have all the data before it can tell when it
+    // is written.
+    this._flush();
+    this._requestDrain();
+    return false;
+  };
+
+  function closeWrapper() {
+    if (this._readyStateObserver.readyState == "closed")
+      return;
+
+    this._flush();
+    this._readyStateObserver.readyState = "closing";
+    this._close();
+  };
+
+  Object.defineProperties(this, {
+    "_readyStateObserver": {
+      value: new ReadyStateObserver(this._id, "opening"),
+    },
+    "_readyStateObserverDeleter": {
+      value: v8tools.lifecycleTracker(),
+    },
+    "_bufferedAmountObserver": {
+      value: new BufferedAmountObserver(this._id),
+    },
+    "_dispatchEventFromExtension": {
+      value: dispatchDatagrams,
+    },
+    "_datagrams": {
+      value: [],
+      writable: true,
+    },
+    "_datagramsSize": {
+      value: 0,
+      writable: true,
+    },
+    "_flushScheduled": {
+      value: false,
+      writable: true,
+    },
+    "_flush": {
+      value: flushWrapper,
+    },
+    "_bytesSent": {
+      value: 0,
+      writable: true,
+    },
+    "send": {
+      value: sendWrapper,
+      enumerable: true,
+    },
+    "close": {
+      value: closeWrapper,
+      enumerable: true,
+    },
+    "localAddress": {
+      value: options.localAddress,
+      enumerable: true,
+    },
+    "localPort": {
+      value: options.localPort,
+      enumerable: true,
+    },
+    "remoteAddress": {
+      value: options.remoteAddress || null,
+      enumerable: true,
+    },
+    "remotePort": {
+      value: options.remotePort || null,
+      enumerable: true,
+    },
+    "addressReuse": {
+      value: options.addressReuse,
+      enumerable: true,
+    },
+    "loopback": {
+      value: options.loopback,
+      enumerable: true,
+    },
+    "bufferedAmount": {
+      get: function() {
+        // The native side counts the whole of a malformed batch as written,
+        // headers included.
+        return Math.max(
+            0, this._bytesSent - this._bufferedAmountObserver.bytesWritten);
+      },
+      enumerable: true,
+    },
+    "readyState": {
+      get: function() { return this._readyStateObserver.readyState; },
+      enumerable: true,
+    },
+  });
+
+  var watcher = this._readyStateObserver;
+  var bufferedAmountWatcher = this._bufferedAmountObserver;
+  this._readyStateObserverDeleter.destructor = function() {
+    watcher.destructor();
+    bufferedAmountWatcher.destructor();
+  };
+
+  function delayedInitialization(obj) {
+    obj._postMessage("init", [options]);
+  };
+
+  this._registerLifecycleTracker();
+  setTimeout(delayedInitialization, 0, this);
+};
+
+UDPSocket.prototype = new common.EventTargetPrototype();
+UDPSocket.prototype.constructor = UDPSocket;
+
 // Exported API.
 exports.TCPSocket = TCPSocket;
 exports.TCPServerSocket = TCPServerSocket;
+exports.UDPSocket = UDPSocket;
@@ -55,26 +55,36 @@ class SysAppsRawSocketTest : public InProcessBrowserTest {
         scoped_ptr<XWalkExtension>(new SysAppsRawSocketTestExtension()));
     ASSERT_TRUE(registered);
   }
+
+  void RunTestPage(const base::FilePath::StringType& page) {
+    const string16 passString = ASCIIToUTF16("Pass");
+    const string16 failString = ASCIIToUTF16("Fail");
+
+    content::RunAllPendingInMessageLoop();
+    content::TitleWatcher title_watcher(runtime()->web_contents(), passString);
+    title_watcher.AlsoWaitForTitle(failString);
+
+    base::FilePath test_file;
+    PathService::Get(base::DIR_SOURCE_ROOT, &test_file);
+    test_file = test_file
+        .Append(FILE_PATH_LITERAL("xwalk"))
+        .Append(FILE_PATH_LITERAL("sysapps"))
+        .Append(FILE_PATH_LITERAL("raw_socket"))
+        .Append(page);
+
+    xwalk_test_utils::NavigateToURL(runtime(),
+                                    net::FilePathToFileURL(test_file));
+    EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
+  }
 };
 
 }  // namespace
 
 IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocket) {
-  const string16 passString = ASCIIToUTF16("Pass");
-  const string16 failString = ASCIIToUTF16("Fail");
-
-  content::RunAllPendingInMessageLoop();
-  content::TitleWatcher title_watcher(runtime()->web_contents(), passString);
-  title_watcher.AlsoWaitForTitle(failString);
-
-  base::FilePath test_file;
-  PathService::Get(base::DIR_SOURCE_ROOT, &test_file);
-  test_file = test_file
-      .Append(FILE_PATH_LITERAL("xwalk"))
-      .Append(FILE_PATH_LITERAL("sysapps"))
-      .Append(FILE_PATH_LITERAL("raw_socket"))
-      .Append(FILE_PATH_LITERAL("raw_socket_api_browsertest.html"));
-
-  xwalk_test_utils::NavigateToURL(runtime(), net::FilePathToFileURL(test_file));
-  EXPECT_EQ(passString, title_watcher.WaitAndGetTitle());
+  RunTestPage(FILE_PATH_LITERAL("raw_socket_api_browsertest.html"));
+}
+
+// Reports the results in the console, see raw_socket_benchmark.html.
+IN_PROC_BROWSER_TEST_F(SysAppsRawSocketTest, SysAppsRawSocketBenchmark) {
+  RunTestPage(FILE_PATH_LITERAL("raw_socket_benchmark.html"));
 }
@@ -4,11 +4,13 @@
 
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
 
+#include "base/strings/string_number_conversions.h"
 #include "grit/xwalk_sysapps_resources.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
+#include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
@@ -29,24 +31,36 @@ XWalkExtensionInstance* RawSocketExtension::CreateInstance() {
 
 RawSocketInstance::RawSocketInstance()
   : handler_(this),
-    store_(&handler_) {
+    store_(&handler_),
+    next_object_id_(0) {
   handler_.Register("TCPServerSocketConstructor",
       base::Bind(&RawSocketInstance::OnTCPServerSocketConstructor,
                  base::Unretained(this)));
   handler_.Register("TCPSocketConstructor",
       base::Bind(&RawSocketInstance::OnTCPSocketConstructor,
                  base::Unretained(this)));
+  handler_.Register("UDPSocketConstructor",
+      base::Bind(&RawSocketInstance::OnUDPSocketConstructor,
+                 base::Unretained(this)));
 }
 
 void RawSocketInstance::HandleMessage(scoped_ptr<base::Value> msg) {
   handler_.HandleMessage(msg.Pass());
 }
 
+void RawSocketInstance::HandleBinaryMessage(const char* data, size_t size) {
+  store_.HandleBinaryMessage(data, size);
+}
+
 void RawSocketInstance::AddBindingObject(const std::string& object_id,
                                          scoped_ptr<BindingObject> obj) {
   store_.AddBindingObject(object_id, obj.Pass());
 }
 
+std::string RawSocketInstance::GenerateObjectId() {
+  return "native-" + base::Uint64ToString(next_object_id_++);
+}
+
 void RawSocketInstance::OnTCPServerSocketConstructor(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
   scoped_ptr<TCPServerSocketConstructor::Params>
@@ -75,5 +89,19 @@ void RawSocketInstance::OnTCPSocketConstructor(
   store_.AddBindingObject(params->object_id, obj.Pass());
 }
 
+void RawSocketInstance::OnUDPSocketConstructor(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<UDPSocketConstructor::Params>
+      params(UDPSocketConstructor::Params::Create(*info->arguments()));
+
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    return;
+  }
+
+  scoped_ptr<BindingObject> obj(new UDPSocketObject);
+  store_.AddBindingObject(params->object_id, obj.Pass());
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
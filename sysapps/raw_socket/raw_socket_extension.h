@@ -32,17 +32,26 @@ class RawSocketInstance : public XWalkExtensionInstance {
 
   // XWalkExtensionInstance implementation.
   virtual void HandleMessage(scoped_ptr<base::Value> msg) OVERRIDE;
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE;
 
   void AddBindingObject(const std::string& object_id,
                         scoped_ptr<BindingObject> obj);
 
+  // Returns a new ID for the objects created by the native side, like the
+  // accepted sockets. They never clash with the IDs generated by the
+  // JavaScript side, which are plain numbers.
+  std::string GenerateObjectId();
+
  private:
   void OnTCPServerSocketConstructor(
       scoped_ptr<XWalkExtensionFunctionInfo> info);
   void OnTCPSocketConstructor(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnUDPSocketConstructor(scoped_ptr<XWalkExtensionFunctionInfo> info);
 
   XWalkExtensionFunctionHandler handler_;
   BindingObjectStore store_;
+
+  uint64 next_object_id_;
 };
 
 }  // namespace sysapps
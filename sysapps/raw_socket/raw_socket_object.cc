@@ -4,13 +4,22 @@
 
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
 
+#include "base/bind.h"
 #include "base/memory/scoped_ptr.h"
+#include "base/message_loop/message_loop.h"
 #include "base/values.h"
 
 namespace xwalk {
 namespace sysapps {
 
-RawSocketObject::RawSocketObject() {}
+RawSocketObject::RawSocketObject()
+    : bytes_written_(0),
+      needs_drain_(false),
+      has_buffered_amount_update_pending_(false),
+      weak_factory_(this) {
+  handler_.Register("_requestDrain",
+      base::Bind(&RawSocketObject::OnRequestDrain, base::Unretained(this)));
+}
 
 RawSocketObject::~RawSocketObject() {}
 
@@ -21,5 +30,52 @@ void RawSocketObject::setReadyState(ReadyState state) {
   DispatchEvent("readystate", eventData.Pass());
 }
 
+void RawSocketObject::DidWriteBytes(int bytes) {
+  bytes_written_ += bytes;
+  ScheduleBufferedAmountUpdate();
+
+  if (needs_drain_ && !HasPendingWrites())
+    DispatchDrain();
+}
+
+void RawSocketObject::CancelDrain() {
+  needs_drain_ = false;
+}
+
+void RawSocketObject::OnRequestDrain(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  needs_drain_ = true;
+  if (!HasPendingWrites())
+    DispatchDrain();
+}
+
+void RawSocketObject::DispatchDrain() {
+  needs_drain_ = false;
+
+  // So bufferedAmount is up to date in the event listeners.
+  SendBufferedAmountUpdate();
+  DispatchEvent("drain");
+}
+
+void RawSocketObject::ScheduleBufferedAmountUpdate() {
+  if (has_buffered_amount_update_pending_)
+    return;
+
+  // Writes usually complete in bursts, they are reported together.
+  has_buffered_amount_update_pending_ = true;
+  base::MessageLoop::current()->PostTask(
+      FROM_HERE,
+      base::Bind(&RawSocketObject::SendBufferedAmountUpdate,
+                 weak_factory_.GetWeakPtr()));
+}
+
+void RawSocketObject::SendBufferedAmountUpdate() {
+  has_buffered_amount_update_pending_ = false;
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(static_cast<double>(bytes_written_));
+  DispatchEvent("bufferedamount", eventData.Pass());
+}
+
 }  // namespace sysapps
 }  // namespace xwalk
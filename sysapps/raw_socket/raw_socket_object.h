@@ -5,6 +5,7 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_RAW_SOCKET_OBJECT_H_
 
+#include "base/memory/weak_ptr.h"
 #include "xwalk/sysapps/raw_socket/raw_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 
@@ -14,6 +15,13 @@ namespace xwalk {
 namespace sysapps {
 
 // Base class for the objects of the RawSocket API.
+//
+// It also keeps the accounting of the data sent by the sockets. The
+// JavaScript side computes its bufferedAmount from the number of bytes
+// written, which is sent with the "bufferedamount" event at most once per
+// message loop iteration. When send() returns false because too much data is
+// buffered, the JavaScript side asks for a "drain" event, which is fired once
+// HasPendingWrites() returns false.
 class RawSocketObject : public EventTarget {
  public:
   virtual ~RawSocketObject();
@@ -22,6 +30,30 @@ class RawSocketObject : public EventTarget {
   RawSocketObject();
 
   void setReadyState(ReadyState state);
+
+  // Must be called every time data is written to the socket.
+  void DidWriteBytes(int bytes);
+
+  // Forgets a pending request for a "drain" event, for when the data waiting
+  // to be written is discarded.
+  void CancelDrain();
+
+  // Sockets that queue the data sent must return true while it is not
+  // entirely written.
+  virtual bool HasPendingWrites() const { return false; }
+
+ private:
+  void OnRequestDrain(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  void DispatchDrain();
+  void ScheduleBufferedAmountUpdate();
+  void SendBufferedAmountUpdate();
+
+  uint64 bytes_written_;
+  bool needs_drain_;
+  bool has_buffered_amount_update_pending_;
+
+  base::WeakPtrFactory<RawSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -0,0 +1,72 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/read_buffer_pool.h"
+
+#include "base/logging.h"
+
+namespace xwalk {
+namespace sysapps {
+
+namespace {
+
+base::LazyInstance<ReadBufferPool>::Leaky g_read_buffer_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+const size_t ReadBufferPool::kMaxPooledBytes;
+
+// static
+ReadBufferPool* ReadBufferPool::GetInstance() {
+  return g_read_buffer_pool.Pointer();
+}
+
+ReadBufferPool::ReadBufferPool()
+    : pooled_bytes_(0) {}
+
+ReadBufferPool::~ReadBufferPool() {}
+
+scoped_refptr<net::IOBufferWithSize> ReadBufferPool::Acquire(int size) {
+  DCHECK_GT(size, 0);
+
+  {
+    base::AutoLock lock(lock_);
+    BufferMap::iterator it = buffers_.find(size);
+    if (it != buffers_.end() && !it->second.empty()) {
+      scoped_refptr<net::IOBufferWithSize> buffer = it->second.back();
+      it->second.pop_back();
+      pooled_bytes_ -= size;
+      return buffer;
+    }
+  }
+
+  return new net::IOBufferWithSize(size);
+}
+
+void ReadBufferPool::Release(scoped_refptr<net::IOBufferWithSize>* buffer) {
+  scoped_refptr<net::IOBufferWithSize> released;
+  released.swap(*buffer);
+
+  // A socket may still be reading into it.
+  if (!released || !released->HasOneRef())
+    return;
+
+  const size_t size = released->size();
+
+  base::AutoLock lock(lock_);
+  if (pooled_bytes_ + size > kMaxPooledBytes)
+    return;
+
+  buffers_[released->size()].push_back(released);
+  pooled_bytes_ += size;
+}
+
+size_t ReadBufferPool::pooled_bytes() const {
+  base::AutoLock lock(lock_);
+  return pooled_bytes_;
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
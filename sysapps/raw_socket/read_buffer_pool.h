@@ -0,0 +1,57 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_POOL_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_POOL_H_
+
+#include <map>
+#include <vector>
+#include "base/basictypes.h"
+#include "base/lazy_instance.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "net/base/io_buffer.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Keeps the buffers used for reading from the sockets once they are not
+// needed anymore, so sockets created later, like the ones accepted by a busy
+// server, don't have to allocate new ones. Buffers are only reused for
+// requests of the same size, and at most kMaxPooledBytes are kept.
+class ReadBufferPool {
+ public:
+  static const size_t kMaxPooledBytes = 1024 * 1024;
+
+  static ReadBufferPool* GetInstance();
+
+  // Returns a buffer of |size| bytes, reusing a pooled one if available.
+  scoped_refptr<net::IOBufferWithSize> Acquire(int size);
+
+  // Gives the buffer back to the pool and clears |buffer|. The buffer is only
+  // pooled if nobody else holds a reference to it.
+  void Release(scoped_refptr<net::IOBufferWithSize>* buffer);
+
+  size_t pooled_bytes() const;
+
+ private:
+  friend struct base::DefaultLazyInstanceTraits<ReadBufferPool>;
+
+  ReadBufferPool();
+  ~ReadBufferPool();
+
+  typedef std::vector<scoped_refptr<net::IOBufferWithSize> > BufferList;
+  typedef std::map<int, BufferList> BufferMap;
+
+  mutable base::Lock lock_;
+  BufferMap buffers_;
+  size_t pooled_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadBufferPool);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_POOL_H_
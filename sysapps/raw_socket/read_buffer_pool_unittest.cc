@@ -0,0 +1,63 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/read_buffer_pool.h"
+
+#include <vector>
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::ReadBufferPool;
+
+TEST(XWalkSysAppsReadBufferPoolTest, ReusesReleasedBuffers) {
+  ReadBufferPool* pool = ReadBufferPool::GetInstance();
+  const size_t initial_bytes = pool->pooled_bytes();
+
+  scoped_refptr<net::IOBufferWithSize> buffer1 = pool->Acquire(4096);
+  net::IOBufferWithSize* raw_buffer1 = buffer1.get();
+  EXPECT_EQ(4096, buffer1->size());
+
+  pool->Release(&buffer1);
+  EXPECT_FALSE(buffer1);
+  EXPECT_EQ(initial_bytes + 4096, pool->pooled_bytes());
+
+  // Same size, gets the same buffer back.
+  scoped_refptr<net::IOBufferWithSize> buffer2 = pool->Acquire(4096);
+  EXPECT_EQ(raw_buffer1, buffer2.get());
+  EXPECT_EQ(initial_bytes, pool->pooled_bytes());
+
+  // Different size, a new buffer.
+  scoped_refptr<net::IOBufferWithSize> buffer3 = pool->Acquire(8192);
+  EXPECT_EQ(8192, buffer3->size());
+
+  pool->Release(&buffer2);
+  pool->Release(&buffer3);
+  EXPECT_EQ(initial_bytes + 4096 + 8192, pool->pooled_bytes());
+}
+
+TEST(XWalkSysAppsReadBufferPoolTest, BuffersInUseAreNotPooled) {
+  ReadBufferPool* pool = ReadBufferPool::GetInstance();
+
+  scoped_refptr<net::IOBufferWithSize> buffer = pool->Acquire(1024);
+  scoped_refptr<net::IOBufferWithSize> reader = buffer;
+  const size_t pooled_bytes = pool->pooled_bytes();
+
+  pool->Release(&buffer);
+  EXPECT_FALSE(buffer);
+  EXPECT_EQ(pooled_bytes, pool->pooled_bytes());
+  EXPECT_NE(reader.get(), pool->Acquire(1024).get());
+}
+
+TEST(XWalkSysAppsReadBufferPoolTest, PoolIsBounded) {
+  ReadBufferPool* pool = ReadBufferPool::GetInstance();
+  const int kSize = 64 * 1024;
+  const size_t kCount = ReadBufferPool::kMaxPooledBytes / kSize + 4;
+
+  std::vector<scoped_refptr<net::IOBufferWithSize> > buffers;
+  for (size_t i = 0; i < kCount; ++i)
+    buffers.push_back(pool->Acquire(kSize));
+  for (size_t i = 0; i < kCount; ++i)
+    pool->Release(&buffers[i]);
+
+  EXPECT_LE(pool->pooled_bytes(), ReadBufferPool::kMaxPooledBytes);
+}
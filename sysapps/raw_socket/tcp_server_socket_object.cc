@@ -5,8 +5,9 @@
 #include "xwalk/sysapps/raw_socket/tcp_server_socket_object.h"
 
 #include <string.h>
-#include "base/guid.h"
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
@@ -19,13 +20,32 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+// Used when the backlog given is not valid.
+const int kDefaultBacklog = 128;
+
+// Connections accepted at once are reported in a single message, up to this
+// number. Accepting continues in a new task after that, so a connection storm
+// can't starve the message loop.
+const size_t kMaxConnectionsPerEvent = 64;
+
+// When accepting fails, for instance because the process is out of file
+// descriptors, it is tried again after this delay.
+const int kAcceptRetryDelayMs = 100;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
-    instance_(instance) {
+    has_accept_pending_(false),
+    connections_(new base::ListValue),
+    instance_(instance),
+    weak_factory_(this) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
   handler_.Register("_close",
@@ -39,9 +59,89 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  if (has_accept_pending_)
+    return;
+
+  while (socket_) {
+    if (connections_->GetSize() >= kMaxConnectionsPerEvent) {
+      DispatchConnections();
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&TCPServerSocketObject::DoAccept,
+                     weak_factory_.GetWeakPtr()));
+      return;
+    }
+
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_accept_pending_ = true;
+      break;
+    }
+
+    if (!DidAccept(ret)) {
+      DispatchConnections();
+      base::MessageLoop::current()->PostDelayedTask(
+          FROM_HERE,
+          base::Bind(&TCPServerSocketObject::DoAccept,
+                     weak_factory_.GetWeakPtr()),
+          base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
+      return;
+    }
+  }
+
+  DispatchConnections();
+}
+
+bool TCPServerSocketObject::DidAccept(int result) {
+  if (result != net::OK) {
+    LOG(WARNING) << "Failed to accept a connection: "
+        << net::ErrorToString(result);
+    DispatchEvent("connecterror");
+    return false;
+  }
+
+  if (!is_accepting_ || is_suspended_) {
+    // The spec is not really clear about what to do when we get a incoming
+    // connection but nobody is listening. We are just closing the socket in
+    // this case.
+    accepted_socket_.reset();
+    return true;
+  }
+
+  net::IPEndPoint local_address;
+  accepted_socket_->GetLocalAddress(&local_address);
+
+  jsapi::tcp_socket::TCPOptions options;
+  options.local_address = local_address.ToStringWithoutPort();
+  options.local_port = local_address.port();
+  options.address_reuse = false;
+  options.no_delay = true;
+  options.use_secure_transport = false;
+
+  std::string object_id = instance_->GenerateObjectId();
+  scoped_ptr<BindingObject> obj(new TCPSocketObject(accepted_socket_.Pass()));
+  instance_->AddBindingObject(object_id, obj.Pass());
+
+  scoped_ptr<base::ListValue> connection(new base::ListValue);
+  connection->AppendString(object_id);
+  connection->Append(options.ToValue().release());
+  connections_->Append(connection.release());
+
+  return true;
+}
+
+void TCPServerSocketObject::DispatchConnections() {
+  if (connections_->empty())
+    return;
+
+  scoped_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->Append(connections_.release());
+  connections_.reset(new base::ListValue);
+
+  DispatchEvent("connect", eventData.Pass());
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -75,7 +175,10 @@ void TCPServerSocketObject::OnInit(
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLog::Source()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  const int backlog =
+      params->options.backlog > 0 ? params->options.backlog : kDefaultBacklog;
+
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -90,8 +193,10 @@ void TCPServerSocketObject::OnInit(
 
 void TCPServerSocketObject::OnClose(
     scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (socket_)
-    socket_.reset();
+  // The pending accept, if any, is cancelled with the socket.
+  socket_.reset();
+  has_accept_pending_ = false;
+  connections_->Clear();
 
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
@@ -108,37 +213,20 @@ void TCPServerSocketObject::OnResume(
 }
 
 void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
-
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    scoped_ptr<BindingObject> obj(new TCPSocketObject(accepted_socket_.Pass()));
-    instance_->AddBindingObject(object_id, obj.Pass());
-
-    scoped_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    scoped_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", eventData.Pass());
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
+  has_accept_pending_ = false;
+
+  // The connection accepted here is reported with the ones that can be
+  // accepted right after it.
+  if (DidAccept(status)) {
+    DoAccept();
+    return;
   }
 
-  DoAccept();
+  base::MessageLoop::current()->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&TCPServerSocketObject::DoAccept,
+                 weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs));
 }
 
 }  // namespace sysapps
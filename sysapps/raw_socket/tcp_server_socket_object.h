@@ -6,6 +6,8 @@
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
 #include <string>
+#include "base/memory/weak_ptr.h"
+#include "base/values.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
@@ -16,6 +18,9 @@ namespace sysapps {
 
 class BindingObjectStore;
 
+// Connections are accepted until the socket would block, and all the ones
+// accepted at once are reported with a single "connect" message, which the
+// JavaScript side splits in one event per connection.
 class TCPServerSocketObject : public RawSocketObject {
  public:
   explicit TCPServerSocketObject(RawSocketInstance* instance);
@@ -23,6 +28,8 @@ class TCPServerSocketObject : public RawSocketObject {
 
  private:
   void DoAccept();
+  bool DidAccept(int result);
+  void DispatchConnections();
 
   // EventTarget implementation.
   virtual void StartEvent(const std::string& type) OVERRIDE;
@@ -39,11 +46,18 @@ class TCPServerSocketObject : public RawSocketObject {
 
   bool is_suspended_;
   bool is_accepting_;
+  bool has_accept_pending_;
 
   scoped_ptr<net::TCPServerSocket> socket_;
   scoped_ptr<net::StreamSocket> accepted_socket_;
 
+  // Connections accepted and not reported yet, each one as a list with the
+  // ID of the new socket and its options.
+  scoped_ptr<base::ListValue> connections_;
+
   RawSocketInstance* instance_;
+
+  base::WeakPtrFactory<TCPServerSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
@@ -5,9 +5,12 @@
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
 #include <string.h>
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/message_loop/message_loop.h"
 #include "net/base/net_errors.h"
 #include "net/base/net_util.h"
+#include "xwalk/sysapps/raw_socket/read_buffer_pool.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
 
 using namespace xwalk::jsapi::tcp_socket; // NOLINT
@@ -15,7 +18,10 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const unsigned kBufferSize = 4096;
+// The read buffer starts small, so idle connections are cheap, and grows while
+// the reads fill it, so bulk transfers need fewer events.
+const int kMinReadBufferSize = 4 * 1024;
+const int kMaxReadBufferSize = 256 * 1024;
 
 }  // namespace
 
@@ -24,26 +30,43 @@ namespace sysapps {
 
 TCPSocketObject::TCPSocketObject()
     : has_write_pending_(false),
+      has_read_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      read_size_(0),
+      read_dispatched_(0),
+      last_read_burst_size_(-1),
+      has_read_end_pending_(false),
+      read_end_result_(0),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
-      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
+      single_resolver_(new net::SingleRequestHostResolver(resolver_.get())),
+      weak_factory_(this) {
+  SetReadBufferSize(kMinReadBufferSize);
   RegisterHandlers();
 }
 
 TCPSocketObject::TCPSocketObject(scoped_ptr<net::StreamSocket> socket)
     : has_write_pending_(false),
+      has_read_pending_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      socket_(socket.release()) {
+      read_size_(0),
+      read_dispatched_(0),
+      last_read_burst_size_(-1),
+      has_read_end_pending_(false),
+      read_end_result_(0),
+      socket_(socket.release()),
+      weak_factory_(this) {
+  SetReadBufferSize(kMinReadBufferSize);
   RegisterHandlers();
 }
 
-TCPSocketObject::~TCPSocketObject() {}
+TCPSocketObject::~TCPSocketObject() {
+  // Cancels the pending read, which holds a reference to the buffer.
+  socket_.reset();
+  read_window_ = NULL;
+  ReadBufferPool::GetInstance()->Release(&read_buffer_);
+}
 
 void TCPSocketObject::RegisterHandlers() {
   handler_.Register("init",
@@ -61,16 +84,140 @@ void TCPSocketObject::RegisterHandlers() {
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  if (has_read_pending_)
     return;
 
-  int ret = socket_->Read(read_buffer_,
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  ResetReadBuffer();
+
+  // Consecutive reads that complete synchronously are appended to the
+  // buffer and delivered together, with a single "data" event.
+  while (!is_suspended_ && socket_ && socket_->IsConnected()) {
+    if (read_size_ == read_buffer_->size()) {
+      // Continues in a new task, so a fast peer can't starve the message
+      // loop, which also handles the messages of the other sockets.
+      last_read_burst_size_ = read_size_;
+      DispatchReadData();
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&TCPSocketObject::DoRead, weak_factory_.GetWeakPtr()));
+      return;
+    }
+
+    read_window_->SetOffset(read_size_);
+    int ret = socket_->Read(read_window_,
+                            read_window_->BytesRemaining(),
+                            base::Bind(&TCPSocketObject::OnRead,
+                                       base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      last_read_burst_size_ = read_size_;
+      break;
+    }
+
+    if (!DidRead(ret))
+      return;
+  }
+
+  // Nothing else to read for now (or reading is suspended), delivers what
+  // was read so far.
+  DispatchReadData();
+}
+
+bool TCPSocketObject::DidRead(int result) {
+  if (result > 0) {
+    read_size_ += result;
+    return true;
+  }
+
+  // The data already read is delivered before the socket is closed, which
+  // waits for resume() if suspended.
+  if (is_suspended_ && read_size_ > read_dispatched_) {
+    has_read_end_pending_ = true;
+    read_end_result_ = result;
+    return false;
+  }
+
+  DispatchReadData();
+  EndRead(result);
+  return false;
+}
+
+void TCPSocketObject::EndRead(int result) {
+  // No data means the other side has
+  // disconnected the socket.
+  if (result == 0) {
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("close");
+  } else {
+    Fail();
+  }
+}
+
+void TCPSocketObject::DispatchReadData() {
+  // While suspended, the data stays in the buffer and no more is read, so
+  // the peer is eventually stopped by the TCP flow control.
+  if (is_suspended_)
+    return;
+
+  // Received by the "data" listeners as an ArrayBuffer.
+  if (read_size_ > read_dispatched_) {
+    DispatchBinaryEvent("data", read_buffer_->data() + read_dispatched_,
+                        read_size_ - read_dispatched_);
+    read_dispatched_ = read_size_;
+  }
+}
+
+void TCPSocketObject::ResetReadBuffer() {
+  DCHECK(!has_read_pending_);
+
+  // The data delivered is dropped, so the next reads have the whole buffer.
+  // What's left is at most the data of a read that completed asynchronously
+  // after the others were delivered.
+  if (read_dispatched_) {
+    memmove(read_buffer_->data(), read_buffer_->data() + read_dispatched_,
+            read_size_ - read_dispatched_);
+    read_size_ -= read_dispatched_;
+    read_dispatched_ = 0;
+  }
+
+  if (last_read_burst_size_ >= 0) {
+    AdaptReadBufferSize(last_read_burst_size_);
+    last_read_burst_size_ = -1;
+  }
+}
 
-  if (ret > 0)
-    OnRead(ret);
+void TCPSocketObject::AdaptReadBufferSize(int burst_size) {
+  const int size = read_buffer_->size();
+  if (burst_size == size && size < kMaxReadBufferSize)
+    SetReadBufferSize(size * 2);
+  else if (burst_size < size / 4 && size > kMinReadBufferSize &&
+           read_size_ <= size / 2)
+    SetReadBufferSize(size / 2);
+}
+
+void TCPSocketObject::SetReadBufferSize(int size) {
+  DCHECK(!has_read_pending_);
+  DCHECK(!read_dispatched_);
+  DCHECK_LE(read_size_, size);
+
+  ReadBufferPool* pool = ReadBufferPool::GetInstance();
+  scoped_refptr<net::IOBufferWithSize> buffer = pool->Acquire(size);
+  if (read_size_)
+    memcpy(buffer->data(), read_buffer_->data(), read_size_);
+
+  read_window_ = NULL;
+  pool->Release(&read_buffer_);
+  read_buffer_ = buffer;
+  read_window_ = new net::DrainableIOBuffer(read_buffer_, size);
+}
+
+void TCPSocketObject::CancelRead() {
+  has_read_pending_ = false;
+  has_read_end_pending_ = false;
+  read_size_ = 0;
+  read_dispatched_ = 0;
+  last_read_burst_size_ = -1;
 }
 
 void TCPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
@@ -104,6 +251,10 @@ void TCPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
   if (socket_)
     socket_->Disconnect();
 
+  // The pending read and write, if any, are cancelled by Disconnect().
+  CancelRead();
+  ClearWriteQueue();
+
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
 }
@@ -117,21 +268,28 @@ void TCPSocketObject::OnHalfClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void TCPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // A read already pending completes, but its data is kept until resumed.
   is_suspended_ = true;
 }
 
 void TCPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
   is_suspended_ = false;
-}
 
-void TCPSocketObject::OnSendString(
-    scoped_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
+  if (has_read_end_pending_) {
+    has_read_end_pending_ = false;
+    DispatchReadData();
+    EndRead(read_end_result_);
     return;
+  }
 
-  if (!socket_ || !socket_->IsConnected())
-    return;
+  DoRead();
+}
 
+void TCPSocketObject::OnSendString(
+    scoped_ptr<XWalkExtensionFunctionInfo> info) {
   scoped_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
 
@@ -140,24 +298,82 @@ void TCPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  Send(params->data.data(), params->data.size());
+}
+
+void TCPSocketObject::HandleBinaryMessage(const char* data, size_t size) {
+  Send(data, size);
+}
+
+void TCPSocketObject::Send(const char* data, size_t size) {
+  if (!size)
+    return;
+
+  // The JavaScript side may send data before knowing the socket can't write
+  // anymore. Discarded data still counts as written for it, otherwise
+  // bufferedAmount would never go back to zero.
+  if (is_half_closed_ || !socket_ || !socket_->IsConnected()) {
+    DidWriteBytes(size);
     return;
   }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(size));
+  memcpy(buffer->data(), data, size);
+  write_queue_.push_back(new net::DrainableIOBuffer(buffer, size));
 
-  int ret = socket_->Write(write_buffer_,
-                           params->data.size(),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
+  if (!has_write_pending_)
+    DoWrite();
+}
 
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
-    return;
-  else
-    socket_->Disconnect();
+bool TCPSocketObject::HasPendingWrites() const {
+  return !write_queue_.empty();
+}
+
+void TCPSocketObject::DoWrite() {
+  // Writes until the socket would block, OnWrite() continues from there.
+  while (!write_queue_.empty() && socket_->IsConnected()) {
+    net::DrainableIOBuffer* buffer = write_queue_.front();
+    int ret = socket_->Write(buffer,
+                             buffer->BytesRemaining(),
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (ret < 0) {
+      Fail();
+      return;
+    }
+
+    DidWrite(ret);
+  }
+}
+
+void TCPSocketObject::DidWrite(int bytes_written) {
+  DCHECK(!write_queue_.empty());
+  net::DrainableIOBuffer* buffer = write_queue_.front();
+  buffer->DidConsume(bytes_written);
+  if (!buffer->BytesRemaining())
+    write_queue_.pop_front();
+
+  DidWriteBytes(bytes_written);
+}
+
+void TCPSocketObject::ClearWriteQueue() {
+  has_write_pending_ = false;
+  write_queue_.clear();
+  CancelDrain();
+}
+
+void TCPSocketObject::Fail() {
+  socket_->Disconnect();
+  CancelRead();
+  ClearWriteQueue();
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("error");
 }
 
 void TCPSocketObject::OnConnect(int status) {
@@ -176,30 +392,21 @@ void TCPSocketObject::OnConnect(int status) {
 }
 
 void TCPSocketObject::OnRead(int status) {
-  scoped_ptr<base::ListValue> eventData(new base::ListValue);
-
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", eventData.Pass());
-    return;
-  }
-
-  scoped_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
-
-  eventData->Append(data.release());
-
-  if (!is_suspended_)
-    DispatchEvent("data", eventData.Pass());
+  has_read_pending_ = false;
 
-  DoRead();
+  if (DidRead(status))
+    DoRead();
 }
 
 void TCPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+  if (status < 0) {
+    Fail();
+    return;
+  }
+
+  DidWrite(status);
+  DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
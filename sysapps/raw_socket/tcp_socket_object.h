@@ -5,7 +5,9 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
+#include "base/memory/weak_ptr.h"
 #include "net/dns/single_request_host_resolver.h"
 #include "net/base/io_buffer.h"
 #include "net/socket/tcp_client_socket.h"
@@ -14,15 +16,42 @@
 namespace xwalk {
 namespace sysapps {
 
+// Data sent is queued and written in order, as fast as the socket accepts it.
+//
+// ArrayBuffers are sent and received as binary messages, without converting
+// them to base::Value. The read buffer comes from the ReadBufferPool and is
+// given back when the object is destroyed. Its size adapts to the amount of
+// data read at once, between 4KB and 256KB, and the reads that complete
+// synchronously are delivered with a single "data" event. suspend() stops
+// reading from the socket until resume() is called.
 class TCPSocketObject : public RawSocketObject {
  public:
   TCPSocketObject();
   explicit TCPSocketObject(scoped_ptr<net::StreamSocket> socket);
   virtual ~TCPSocketObject();
 
+  // BindingObject implementation, receives the data sent as an ArrayBuffer.
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE;
+
+ protected:
+  // RawSocketObject implementation.
+  virtual bool HasPendingWrites() const OVERRIDE;
+
  private:
   void RegisterHandlers();
   void DoRead();
+  bool DidRead(int result);
+  void EndRead(int result);
+  void DispatchReadData();
+  void ResetReadBuffer();
+  void AdaptReadBufferSize(int burst_size);
+  void SetReadBufferSize(int size);
+  void CancelRead();
+  void Send(const char* data, size_t size);
+  void DoWrite();
+  void DidWrite(int bytes_written);
+  void ClearWriteQueue();
+  void Fail();
 
   // JavaScript function handlers.
   void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
@@ -41,16 +70,38 @@ class TCPSocketObject : public RawSocketObject {
   void OnResolved(int status);
 
   bool has_write_pending_;
+  bool has_read_pending_;
   bool is_suspended_;
   bool is_half_closed_;
 
-  scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  // Data read is appended to |read_buffer_|, through |read_window_|. The
+  // first |read_size_| bytes are valid, of which |read_dispatched_| were
+  // already delivered.
+  scoped_refptr<net::IOBufferWithSize> read_buffer_;
+  scoped_refptr<net::DrainableIOBuffer> read_window_;
+  int read_size_;
+  int read_dispatched_;
+
+  // Bytes read until the last read that didn't complete synchronously, or
+  // until the buffer was full. The buffer size is adapted to it when the
+  // buffer is reset, -1 if it was already.
+  int last_read_burst_size_;
+
+  // When the stream ends, or fails, while suspended with data not delivered
+  // yet, "close" or "error" is only dispatched after that data, on resume.
+  bool has_read_end_pending_;
+  int read_end_result_;
+
+  // Data waiting to be written, the first buffer is the one being written.
+  std::deque<scoped_refptr<net::DrainableIOBuffer> > write_queue_;
+
   scoped_ptr<net::StreamSocket> socket_;
 
   scoped_ptr<net::HostResolver> resolver_;
   scoped_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
+
+  base::WeakPtrFactory<TCPSocketObject> weak_factory_;
 };
 
 }  // namespace sysapps
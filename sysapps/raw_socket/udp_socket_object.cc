@@ -0,0 +1,380 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/udp_socket_object.h"
+
+#include <string.h>
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "net/base/net_errors.h"
+#include "net/base/net_util.h"
+#include "xwalk/sysapps/raw_socket/read_buffer_pool.h"
+#include "xwalk/sysapps/raw_socket/udp_socket.h"
+
+using namespace xwalk::jsapi::udp_socket; // NOLINT
+using namespace xwalk::jsapi::raw_socket; // NOLINT
+
+namespace {
+
+// Big enough for any datagram.
+const int kReadBufferSize = 64 * 1024;
+
+// The datagrams received are delivered once there is nothing else to read or
+// when they take more than this.
+const size_t kMaxMessagesSize = 256 * 1024;
+
+// Address length, port and data size.
+const size_t kDatagramHeaderSize = 1 + 2 + 4;
+
+void AppendDatagram(std::vector<char>* messages,
+                    const net::IPEndPoint& address,
+                    const char* data, int size) {
+  const std::string host = address.ToStringWithoutPort();
+  const uint16 port = address.port();
+  const uint32 data_size = size;
+
+  messages->push_back(static_cast<char>(host.size()));
+  messages->insert(messages->end(), host.begin(), host.end());
+  messages->push_back(static_cast<char>(port >> 8));
+  messages->push_back(static_cast<char>(port));
+  messages->push_back(static_cast<char>(data_size >> 24));
+  messages->push_back(static_cast<char>(data_size >> 16));
+  messages->push_back(static_cast<char>(data_size >> 8));
+  messages->push_back(static_cast<char>(data_size));
+  messages->insert(messages->end(), data, data + size);
+}
+
+uint32 ReadBigEndian(const char* data, size_t size) {
+  uint32 value = 0;
+  for (size_t i = 0; i < size; ++i)
+    value = (value << 8) | static_cast<unsigned char>(data[i]);
+  return value;
+}
+
+// Errors that only affect a single datagram, the socket can still be used.
+bool IsDatagramError(int result) {
+  return result == net::ERR_MSG_TOO_BIG ||
+         result == net::ERR_CONNECTION_REFUSED ||
+         result == net::ERR_CONNECTION_RESET ||
+         result == net::ERR_ADDRESS_UNREACHABLE;
+}
+
+}  // namespace
+
+namespace xwalk {
+namespace sysapps {
+
+UDPSocketObject::Datagram::Datagram()
+    : size(0) {}
+
+UDPSocketObject::Datagram::~Datagram() {}
+
+UDPSocketObject::UDPSocketObject()
+    : has_receive_pending_(false),
+      has_send_pending_(false),
+      is_suspended_(false),
+      read_buffer_(ReadBufferPool::GetInstance()->Acquire(kReadBufferSize)),
+      has_default_remote_address_(false),
+      last_port_(0),
+      weak_factory_(this) {
+  handler_.Register("init",
+      base::Bind(&UDPSocketObject::OnInit, base::Unretained(this)));
+  handler_.Register("_close",
+      base::Bind(&UDPSocketObject::OnClose, base::Unretained(this)));
+  handler_.Register("suspend",
+      base::Bind(&UDPSocketObject::OnSuspend, base::Unretained(this)));
+  handler_.Register("resume",
+      base::Bind(&UDPSocketObject::OnResume, base::Unretained(this)));
+}
+
+UDPSocketObject::~UDPSocketObject() {
+  // Cancels the pending receive, which holds a reference to the buffer.
+  socket_.reset();
+  ReadBufferPool::GetInstance()->Release(&read_buffer_);
+}
+
+void UDPSocketObject::HandleBinaryMessage(const char* data, size_t size) {
+  if (!socket_)
+    return;
+
+  size_t offset = 0;
+  while (offset < size) {
+    const size_t address_size = static_cast<unsigned char>(data[offset]);
+    if (size - offset < kDatagramHeaderSize + address_size) {
+      LOG(WARNING) << "Malformed datagram sent to the UDP socket.";
+      break;
+    }
+    offset++;
+
+    const std::string address(data + offset, address_size);
+    offset += address_size;
+    const int port = ReadBigEndian(data + offset, 2);
+    offset += 2;
+    const size_t data_size = ReadBigEndian(data + offset, 4);
+    offset += 4;
+
+    if (size - offset < data_size) {
+      LOG(WARNING) << "Malformed datagram sent to the UDP socket.";
+      break;
+    }
+
+    Datagram datagram;
+    if (!data_size) {
+      // Nothing to send.
+    } else if (!GetEndPoint(address, port, &datagram.address)) {
+      LOG(WARNING) << "Invalid destination for the datagram: '" << address
+          << "' port " << port;
+    } else {
+      datagram.buffer = new net::IOBuffer(data_size);
+      datagram.size = data_size;
+      memcpy(datagram.buffer->data(), data + offset, data_size);
+      send_queue_.push_back(datagram);
+    }
+
+    // Discarded datagrams still count as written for the JavaScript side.
+    if (!datagram.buffer)
+      DidWriteBytes(data_size);
+
+    offset += data_size;
+  }
+
+  // What's left after a malformed datagram can't be parsed, it still counts
+  // as written, otherwise bufferedAmount would never go back to zero.
+  if (offset < size)
+    DidWriteBytes(size - offset);
+
+  if (!has_send_pending_)
+    DoSend();
+}
+
+bool UDPSocketObject::HasPendingWrites() const {
+  return !send_queue_.empty();
+}
+
+void UDPSocketObject::DoReceive() {
+  if (has_receive_pending_)
+    return;
+
+  // Datagrams that can be read without blocking are delivered together.
+  while (!is_suspended_ && socket_) {
+    if (messages_.size() >= kMaxMessagesSize) {
+      // Continues in a new task, so a fast sender can't starve the message
+      // loop, which also handles the messages of the other sockets.
+      DispatchMessages();
+      base::MessageLoop::current()->PostTask(
+          FROM_HERE,
+          base::Bind(&UDPSocketObject::DoReceive, weak_factory_.GetWeakPtr()));
+      return;
+    }
+
+    int ret = socket_->RecvFrom(read_buffer_,
+                                read_buffer_->size(),
+                                &read_address_,
+                                base::Bind(&UDPSocketObject::OnReceive,
+                                           base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_receive_pending_ = true;
+      break;
+    }
+
+    if (!DidReceive(ret))
+      return;
+  }
+
+  DispatchMessages();
+}
+
+bool UDPSocketObject::DidReceive(int result) {
+  if (result >= 0) {
+    AppendDatagram(&messages_, read_address_, read_buffer_->data(), result);
+    return true;
+  }
+
+  if (IsDatagramError(result))
+    return true;
+
+  DispatchMessages();
+  Fail();
+  return false;
+}
+
+void UDPSocketObject::DispatchMessages() {
+  // While suspended, the datagrams already received wait for resume().
+  if (is_suspended_ || messages_.empty())
+    return;
+
+  // Received by the "message" listener as an ArrayBuffer, which is split in
+  // one event per datagram on the JavaScript side.
+  DispatchBinaryEvent("message", &messages_[0], messages_.size());
+  messages_.clear();
+}
+
+void UDPSocketObject::DoSend() {
+  // Sends until the socket would block, OnSend() continues from there.
+  while (!send_queue_.empty() && socket_) {
+    const Datagram& datagram = send_queue_.front();
+    int ret = socket_->SendTo(datagram.buffer,
+                              datagram.size,
+                              datagram.address,
+                              base::Bind(&UDPSocketObject::OnSend,
+                                         base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_send_pending_ = true;
+      return;
+    }
+
+    DidSend(ret);
+  }
+}
+
+void UDPSocketObject::DidSend(int result) {
+  DCHECK(!send_queue_.empty());
+  const int size = send_queue_.front().size;
+  send_queue_.pop_front();
+
+  if (result < 0) {
+    LOG(WARNING) << "Failed to send a datagram: "
+        << net::ErrorToString(result);
+  }
+
+  DidWriteBytes(size);
+}
+
+bool UDPSocketObject::GetEndPoint(const std::string& address, int port,
+                                  net::IPEndPoint* end_point) {
+  if (address.empty()) {
+    if (!has_default_remote_address_)
+      return false;
+
+    *end_point = default_remote_address_;
+    return true;
+  }
+
+  if (address != last_address_ || port != last_port_) {
+    net::IPAddressNumber ip_number;
+    if (!net::ParseIPLiteralToNumber(address, &ip_number))
+      return false;
+
+    last_address_ = address;
+    last_port_ = port;
+    last_end_point_ = net::IPEndPoint(ip_number, port);
+  }
+
+  *end_point = last_end_point_;
+  return true;
+}
+
+void UDPSocketObject::ClearSendQueue() {
+  has_send_pending_ = false;
+  send_queue_.clear();
+  CancelDrain();
+}
+
+void UDPSocketObject::Fail() {
+  // This can be called from a callback of the socket, which is only deleted
+  // after it returns. Closing it cancels the pending operations.
+  socket_->Close();
+  base::MessageLoop::current()->DeleteSoon(FROM_HERE, socket_.release());
+  has_receive_pending_ = false;
+  ClearSendQueue();
+
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("error");
+}
+
+void UDPSocketObject::OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  scoped_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return;
+  }
+
+  const UDPOptions& options = params->options;
+
+  net::IPAddressNumber ip_number;
+  if (!net::ParseIPLiteralToNumber(options.local_address, &ip_number)) {
+    LOG(WARNING) << "Invalid IP address " << options.local_address;
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return;
+  }
+
+  if (!options.remote_address.empty()) {
+    net::IPAddressNumber remote_ip_number;
+    if (!net::ParseIPLiteralToNumber(options.remote_address,
+                                     &remote_ip_number)) {
+      LOG(WARNING) << "Invalid IP address " << options.remote_address;
+      setReadyState(READY_STATE_CLOSED);
+      DispatchEvent("error");
+      return;
+    }
+
+    default_remote_address_ =
+        net::IPEndPoint(remote_ip_number, options.remote_port);
+    has_default_remote_address_ = true;
+  }
+
+  socket_.reset(new net::UDPServerSocket(NULL, net::NetLog::Source()));
+  if (options.address_reuse)
+    socket_->AllowAddressReuse();
+
+  net::IPEndPoint address(ip_number, options.local_port);
+  if (socket_->Listen(address) != net::OK) {
+    LOG(WARNING) << "Failed to bind to " << options.local_address
+        << " port " << options.local_port;
+    socket_.reset();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return;
+  }
+
+  setReadyState(READY_STATE_OPEN);
+  DispatchEvent("open");
+  DoReceive();
+}
+
+void UDPSocketObject::OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  // The pending operations, if any, are cancelled with the socket.
+  socket_.reset();
+  has_receive_pending_ = false;
+  messages_.clear();
+  ClearSendQueue();
+
+  setReadyState(READY_STATE_CLOSED);
+}
+
+void UDPSocketObject::OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  is_suspended_ = true;
+}
+
+void UDPSocketObject::OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info) {
+  if (!is_suspended_)
+    return;
+
+  is_suspended_ = false;
+  DispatchMessages();
+  DoReceive();
+}
+
+void UDPSocketObject::OnReceive(int result) {
+  has_receive_pending_ = false;
+
+  if (DidReceive(result))
+    DoReceive();
+}
+
+void UDPSocketObject::OnSend(int result) {
+  has_send_pending_ = false;
+
+  DidSend(result);
+  DoSend();
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
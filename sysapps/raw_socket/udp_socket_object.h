@@ -0,0 +1,110 @@
+// Copyright (c) 2013 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include "base/memory/weak_ptr.h"
+#include "net/base/io_buffer.h"
+#include "net/base/ip_endpoint.h"
+#include "net/udp/udp_server_socket.h"
+#include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Datagrams are exchanged with the JavaScript side as binary messages, each
+// one carrying as many datagrams as available, so a high rate of small
+// datagrams doesn't mean as many messages and events. Every datagram is
+// encoded as:
+//
+//   1 byte       Length of the address.
+//   (length)     Address, as an ASCII string.
+//   2 bytes      Port, big endian.
+//   4 bytes      Size of the data, big endian.
+//   (size)       Data.
+//
+// The address is the one of the sender for the datagrams received and the
+// destination for the ones sent. The datagrams sent with an empty address go
+// to the default remote address given at the creation of the socket.
+//
+// The datagrams received while suspended are discarded by the network stack
+// once its buffer is full, like any datagram that is not read in time.
+class UDPSocketObject : public RawSocketObject {
+ public:
+  UDPSocketObject();
+  virtual ~UDPSocketObject();
+
+  // BindingObject implementation, receives the datagrams sent.
+  virtual void HandleBinaryMessage(const char* data, size_t size) OVERRIDE;
+
+ protected:
+  // RawSocketObject implementation.
+  virtual bool HasPendingWrites() const OVERRIDE;
+
+ private:
+  struct Datagram {
+    Datagram();
+    ~Datagram();
+
+    scoped_refptr<net::IOBuffer> buffer;
+    int size;
+    net::IPEndPoint address;
+  };
+
+  void DoReceive();
+  bool DidReceive(int result);
+  void DispatchMessages();
+
+  void DoSend();
+  void DidSend(int result);
+
+  bool GetEndPoint(const std::string& address, int port,
+                   net::IPEndPoint* end_point);
+  void ClearSendQueue();
+  void Fail();
+
+  // JavaScript function handlers.
+  void OnInit(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnClose(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnSuspend(scoped_ptr<XWalkExtensionFunctionInfo> info);
+  void OnResume(scoped_ptr<XWalkExtensionFunctionInfo> info);
+
+  // net::UDPServerSocket callbacks.
+  void OnReceive(int result);
+  void OnSend(int result);
+
+  bool has_receive_pending_;
+  bool has_send_pending_;
+  bool is_suspended_;
+
+  scoped_refptr<net::IOBufferWithSize> read_buffer_;
+  net::IPEndPoint read_address_;
+
+  // Datagrams received and not delivered yet, encoded as described above.
+  std::vector<char> messages_;
+
+  std::deque<Datagram> send_queue_;
+
+  net::IPEndPoint default_remote_address_;
+  bool has_default_remote_address_;
+
+  // The last address datagrams were sent to, most of the time all of them
+  // go to the same one.
+  std::string last_address_;
+  int last_port_;
+  net::IPEndPoint last_end_point_;
+
+  scoped_ptr<net::UDPServerSocket> socket_;
+
+  base::WeakPtrFactory<UDPSocketObject> weak_factory_;
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_